@@ -61,7 +61,7 @@ def locs_cb(locs, userdata, err):
         end = locs[0]
         print("End: %s" % end.props.name)
         dt = GLib.DateTime.new_local(*userdata) if userdata else GLib.DateTime.new_now_local()
-        provider.get_trips(start, end, dt, 0, trips_cb, None)
+        provider.get_trip_list(start, end, dt, 0, trips_cb, None)
 
 
 def duration(trip):
@@ -26,10 +26,12 @@
 #define __LIBPLANFAHR_H_INSIDE__
 
 #include <libplanfahr/lpf-loc.h>
+#include <libplanfahr/lpf-loc-list.h>
 #include <libplanfahr/lpf-manager.h>
 #include <libplanfahr/lpf-provider.h>
 #include <libplanfahr/lpf-stop.h>
 #include <libplanfahr/lpf-trip.h>
+#include <libplanfahr/lpf-trip-list.h>
 #include <libplanfahr/lpf-trip-part.h>
 
 #undef __LIBPLANFAHR_H_INSIDE__
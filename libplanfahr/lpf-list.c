@@ -0,0 +1,164 @@
+/*
+ * lpf-list.c: shared implementation of the typed lists
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <glib.h>
+
+#include "lpf-list.h"
+
+/*
+ * LpfList backs #LpfLocList and #LpfTripList. It keeps the items in
+ * an array so appending, indexing and getting the length take
+ * constant time and implements #GListModel for all of them. The
+ * typed lists only set the item type and wrap the functions.
+ */
+
+static void lpf_list_model_init (GListModelInterface *iface);
+
+G_DEFINE_ABSTRACT_TYPE_WITH_CODE (LpfList, lpf_list, G_TYPE_OBJECT,
+                                  G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, lpf_list_model_init))
+
+
+static GType
+lpf_list_get_item_type (GListModel *model)
+{
+    return LPF_LIST_GET_CLASS (model)->item_type;
+}
+
+
+static guint
+lpf_list_get_n_items (GListModel *model)
+{
+    return LPF_LIST (model)->items->len;
+}
+
+
+static gpointer
+lpf_list_get_item (GListModel *model, guint position)
+{
+    LpfList *self = LPF_LIST (model);
+
+    if (position >= self->items->len)
+        return NULL;
+    return g_object_ref (g_ptr_array_index (self->items, position));
+}
+
+
+static void
+lpf_list_model_init (GListModelInterface *iface)
+{
+    iface->get_item_type = lpf_list_get_item_type;
+    iface->get_n_items = lpf_list_get_n_items;
+    iface->get_item = lpf_list_get_item;
+}
+
+
+static void
+lpf_list_finalize (GObject *object)
+{
+    LpfList *self = LPF_LIST (object);
+    GObjectClass *parent_class = G_OBJECT_CLASS (lpf_list_parent_class);
+
+    g_ptr_array_unref (self->items);
+
+    parent_class->finalize (object);
+}
+
+
+static void
+lpf_list_class_init (LpfListClass *klass)
+{
+    GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+    object_class->finalize = lpf_list_finalize;
+}
+
+
+static void
+lpf_list_init (LpfList *self)
+{
+    self->items = g_ptr_array_new_with_free_func (g_object_unref);
+}
+
+
+/*
+ * Create a list of @type holding @items. The list is complete
+ * before anybody can watch it so there's no items-changed signal.
+ * @items must free its elements with g_object_unref.
+ */
+gpointer
+lpf_list_new_take (GType type, GPtrArray *items)
+{
+    LpfList *self = g_object_new (type, NULL);
+
+    g_ptr_array_unref (self->items);
+    self->items = items;
+    return self;
+}
+
+
+/* Move the items of a linked list into a new list of @type */
+gpointer
+lpf_list_new_from_slist (GType type, GSList *items)
+{
+    GPtrArray *array = g_ptr_array_new_full (g_slist_length (items), g_object_unref);
+    GSList *l;
+
+    for (l = items; l; l = g_slist_next (l))
+        g_ptr_array_add (array, l->data);
+    g_slist_free (items);
+    return lpf_list_new_take (type, array);
+}
+
+
+void
+lpf_list_add (LpfList *self, gpointer item)
+{
+    g_return_if_fail (LPF_IS_LIST (self));
+    g_return_if_fail (G_TYPE_CHECK_INSTANCE_TYPE (item, LPF_LIST_GET_CLASS (self)->item_type));
+
+    g_ptr_array_add (self->items, item);
+    g_list_model_items_changed (G_LIST_MODEL (self), self->items->len - 1, 0, 1);
+}
+
+
+gpointer
+lpf_list_get (LpfList *self, guint idx)
+{
+    g_return_val_if_fail (LPF_IS_LIST (self), NULL);
+    g_return_val_if_fail (idx < self->items->len, NULL);
+
+    return g_ptr_array_index (self->items, idx);
+}
+
+
+GSList*
+lpf_list_to_slist (LpfList *self)
+{
+    GSList *items = NULL;
+    guint i;
+
+    g_return_val_if_fail (LPF_IS_LIST (self), NULL);
+
+    for (i = self->items->len; i > 0; i--)
+        items = g_slist_prepend (items, g_object_ref (g_ptr_array_index (self->items, i - 1)));
+    return items;
+}
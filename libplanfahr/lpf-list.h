@@ -0,0 +1,68 @@
+/*
+ * lpf-list.h: shared implementation of the typed lists
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _LPF_LIST_H
+#define _LPF_LIST_H
+
+#if !defined (LIBPLANFAHR_COMPILATION)
+# error "lpf-list.h is private to libplanfahr."
+#endif
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define LPF_TYPE_LIST lpf_list_get_type()
+
+#define LPF_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), LPF_TYPE_LIST, LpfList))
+
+#define LPF_LIST_CLASS(klass) \
+  (G_TYPE_CHECK_CLASS_CAST ((klass), LPF_TYPE_LIST, LpfListClass))
+
+#define LPF_IS_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), LPF_TYPE_LIST))
+
+#define LPF_LIST_GET_CLASS(obj) \
+  (G_TYPE_INSTANCE_GET_CLASS ((obj), LPF_TYPE_LIST, LpfListClass))
+
+typedef struct _LpfList {
+    GObject parent;
+    GPtrArray *items;
+} LpfList;
+
+typedef struct _LpfListClass {
+    GObjectClass parent_class;
+    GType item_type;      /* set by the typed lists */
+} LpfListClass;
+
+GType lpf_list_get_type (void);
+
+gpointer lpf_list_new_take (GType type, GPtrArray *items);
+gpointer lpf_list_new_from_slist (GType type, GSList *items);
+void lpf_list_add (LpfList *self, gpointer item);
+gpointer lpf_list_get (LpfList *self, guint idx);
+GSList *lpf_list_to_slist (LpfList *self);
+
+G_END_DECLS
+
+#endif /* _LPF_LIST_H */
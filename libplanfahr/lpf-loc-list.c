@@ -0,0 +1,151 @@
+/*
+ * lpf-loc-list.c: a list of locations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <glib.h>
+
+#include "lpf-loc-list.h"
+#include "lpf-list.h"
+
+/**
+ * SECTION:lpf-loc-list
+ * @short_description: List of locations
+ *
+ * A #LpfLocList holds the locations of a provider reply. Appending,
+ * indexing and getting the length take constant time. It implements
+ * #GListModel so bindings can iterate and index it directly.
+ */
+
+struct _LpfLocList {
+    LpfList parent;
+};
+
+struct _LpfLocListClass {
+    LpfListClass parent_class;
+};
+
+G_DEFINE_TYPE (LpfLocList, lpf_loc_list, LPF_TYPE_LIST)
+
+
+static void
+lpf_loc_list_class_init (LpfLocListClass *klass)
+{
+    LPF_LIST_CLASS (klass)->item_type = LPF_TYPE_LOC;
+}
+
+
+static void
+lpf_loc_list_init (LpfLocList *self)
+{
+}
+
+
+/**
+ * lpf_loc_list_new:
+ * @reserved: number of locations to reserve space for
+ *
+ * Returns: (transfer full): a new empty #LpfLocList
+ */
+LpfLocList*
+lpf_loc_list_new (guint reserved)
+{
+    return lpf_list_new_take (LPF_TYPE_LOC_LIST,
+                              g_ptr_array_new_full (reserved, g_object_unref));
+}
+
+
+/**
+ * lpf_loc_list_add:
+ * @self: a #LpfLocList
+ * @loc: (transfer full): the location to append
+ *
+ * Append @loc to the end of the list.
+ */
+void
+lpf_loc_list_add (LpfLocList *self, LpfLoc *loc)
+{
+    g_return_if_fail (LPF_IS_LOC_LIST (self));
+
+    lpf_list_add (LPF_LIST (self), loc);
+}
+
+
+/**
+ * lpf_loc_list_get_length:
+ * @self: a #LpfLocList
+ *
+ * Returns: the number of locations in the list
+ */
+guint
+lpf_loc_list_get_length (LpfLocList *self)
+{
+    g_return_val_if_fail (LPF_IS_LOC_LIST (self), 0);
+
+    return LPF_LIST (self)->items->len;
+}
+
+
+/**
+ * lpf_loc_list_get:
+ * @self: a #LpfLocList
+ * @idx: index of the location
+ *
+ * Returns: (transfer none): the location at @idx
+ */
+LpfLoc*
+lpf_loc_list_get (LpfLocList *self, guint idx)
+{
+    g_return_val_if_fail (LPF_IS_LOC_LIST (self), NULL);
+
+    return lpf_list_get (LPF_LIST (self), idx);
+}
+
+
+/**
+ * lpf_loc_list_new_from_slist: (skip)
+ * @locs: (transfer full) (element-type LpfLoc): linked list of locations
+ *
+ * Move the locations of a linked list into a new #LpfLocList,
+ * @locs is freed.
+ *
+ * Returns: (transfer full): a new #LpfLocList
+ */
+LpfLocList*
+lpf_loc_list_new_from_slist (GSList *locs)
+{
+    return lpf_list_new_from_slist (LPF_TYPE_LOC_LIST, locs);
+}
+
+
+/**
+ * lpf_loc_list_to_slist: (skip)
+ * @self: a #LpfLocList
+ *
+ * Returns: (transfer full) (element-type LpfLoc): the locations as
+ * linked list for callers of the #GSList based API
+ */
+GSList*
+lpf_loc_list_to_slist (LpfLocList *self)
+{
+    g_return_val_if_fail (LPF_IS_LOC_LIST (self), NULL);
+
+    return lpf_list_to_slist (LPF_LIST (self));
+}
@@ -0,0 +1,59 @@
+/*
+ * lpf-loc-list.h: a list of locations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _LPF_LOC_LIST_H
+#define _LPF_LOC_LIST_H
+
+#if !defined (__LIBPLANFAHR_H_INSIDE__) && !defined (LIBPLANFAHR_COMPILATION)
+# error "Only <libplanfahr.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+
+#include <libplanfahr/lpf-loc.h>
+
+G_BEGIN_DECLS
+
+#define LPF_TYPE_LOC_LIST (lpf_loc_list_get_type())
+
+#define LPF_LOC_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), LPF_TYPE_LOC_LIST, LpfLocList))
+
+#define LPF_IS_LOC_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), LPF_TYPE_LOC_LIST))
+
+typedef struct _LpfLocList LpfLocList;
+typedef struct _LpfLocListClass LpfLocListClass;
+
+GType lpf_loc_list_get_type (void);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (LpfLocList, g_object_unref)
+
+LpfLocList *lpf_loc_list_new (guint reserved);
+void lpf_loc_list_add (LpfLocList *self, LpfLoc *loc);
+guint lpf_loc_list_get_length (LpfLocList *self);
+LpfLoc *lpf_loc_list_get (LpfLocList *self, guint idx);
+LpfLocList *lpf_loc_list_new_from_slist (GSList *locs);
+GSList *lpf_loc_list_to_slist (LpfLocList *self);
+
+G_END_DECLS
+
+#endif /* _LPF_LOC_LIST_H */
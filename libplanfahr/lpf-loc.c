@@ -51,6 +51,9 @@ typedef struct _LpfLocPrivate {
     gdouble long_;
     gdouble lat;
     gpointer opaque;
+    GDestroyNotify opaque_free;
+    const gchar *provider;  /* interned, namespace of id */
+    guint32 id;             /* 0 if unknown */
 } LpfLocPrivate;
 
 typedef struct _LpfLoc {
@@ -71,8 +74,8 @@ lpf_loc_set_property (GObject *object,
 
     switch (property_id) {
     case LPF_LOC_PROP_NAME:
-        g_free (priv->name);
-        priv->name = g_value_dup_string (value);
+        lpf_str_release (priv->name);
+        priv->name = lpf_str_intern (g_value_get_string (value));
         break;
 
     case LPF_LOC_PROP_LONG:
@@ -136,8 +139,9 @@ lpf_loc_finalize (GObject *object)
     LpfLocPrivate *priv = GET_PRIVATE (self);
     GObjectClass *parent_class = G_OBJECT_CLASS (lpf_loc_parent_class);
 
-    g_free (priv->name);
-    g_free (priv->opaque);
+    lpf_str_release (priv->name);
+    if (priv->opaque_free)
+        (*priv->opaque_free) (priv->opaque);
 
     parent_class->finalize (object);
 }
@@ -165,14 +169,14 @@ lpf_loc_class_init (LpfLocClass *klass)
                                  "Longitude",
                                  "Get Location Longitude",
                                  -180.0, +180.0, 0,
-                                 G_PARAM_CONSTRUCT | G_PARAM_READWRITE);
+                                 G_PARAM_READWRITE);
     g_object_class_install_property (object_class, LPF_LOC_PROP_LONG, pspec);
 
     pspec = g_param_spec_double ("lat",
                                  "latitude",
                                  "Get Location Latitude",
                                  -90.0, +90.0, 0,
-                                 G_PARAM_CONSTRUCT | G_PARAM_READWRITE);
+                                 G_PARAM_READWRITE);
     g_object_class_install_property (object_class, LPF_LOC_PROP_LAT, pspec);
 }
 
@@ -181,6 +185,46 @@ lpf_loc_init (LpfLoc *self)
 {
 }
 
+/**
+ * lpf_loc_new_full:
+ * @name: (allow-none): name of the location
+ * @long_: longitude
+ * @lat: latitude
+ *
+ * Create a location without going through the property machinery.
+ *
+ * Returns: (transfer full): a new #LpfLoc
+ */
+LpfLoc*
+lpf_loc_new_full (const gchar *name, gdouble long_, gdouble lat)
+{
+    LpfLoc *self = g_object_new (LPF_TYPE_LOC, NULL);
+
+    lpf_loc_set_full (self, name, long_, lat);
+    return self;
+}
+
+/**
+ * lpf_loc_set_full: (skip)
+ * @self: a #LpfLoc
+ * @name: (allow-none): name of the location
+ * @long_: longitude
+ * @lat: latitude
+ *
+ * Set name and position at once. No change notifications are
+ * emitted so this is only meant for objects that are being built.
+ */
+void
+lpf_loc_set_full (LpfLoc *self, const gchar *name, gdouble long_, gdouble lat)
+{
+    LpfLocPrivate *priv = GET_PRIVATE (self);
+
+    lpf_str_release (priv->name);
+    priv->name = lpf_str_intern (name);
+    priv->long_ = long_;
+    priv->lat = lat;
+}
+
 /**
  * lpf_loc_get_opaque: (skip)
  * @self: a #LpfLoc
@@ -207,16 +251,127 @@ lpf_loc_get_opaque(LpfLoc *self)
  */
 void
 lpf_loc_set_opaque(LpfLoc *self, gpointer opaque)
+{
+    lpf_loc_set_opaque_full (self, opaque, g_free);
+}
+
+/**
+ * lpf_loc_set_opaque_full: (skip)
+ * @self: a #LpfLoc
+ * @opaque: pointer to opaque data
+ * @destroy: (allow-none): function to free @opaque with
+ *
+ * Set the opaque data stored by a provider. This allows providers
+ * to share the data between locations.
+ */
+void
+lpf_loc_set_opaque_full(LpfLoc *self, gpointer opaque, GDestroyNotify destroy)
 {
     LpfLocPrivate *priv = GET_PRIVATE (self);
 
     priv->opaque = opaque;
+    priv->opaque_free = destroy;
+}
+
+/**
+ * lpf_loc_set_id: (skip)
+ * @self: a #LpfLoc
+ * @provider: (allow-none): namespace of @id, usually the provider's name
+ * @id: the provider's numeric id of this location
+ *
+ * Set the compact identity of a location as used by
+ * #lpf_loc_equal and #lpf_loc_hash.
+ */
+void
+lpf_loc_set_id(LpfLoc *self, const gchar *provider, guint32 id)
+{
+    LpfLocPrivate *priv = GET_PRIVATE (self);
+
+    priv->provider = g_intern_string (provider);
+    priv->id = id;
+}
+
+/**
+ * lpf_loc_get_id:
+ * @self: a #LpfLoc
+ *
+ * Returns: the provider's numeric id of this location or 0 if the
+ * provider didn't set one
+ */
+guint32
+lpf_loc_get_id(LpfLoc *self)
+{
+    LpfLocPrivate *priv = GET_PRIVATE (self);
+
+    return priv->id;
+}
+
+/**
+ * lpf_loc_get_provider:
+ * @self: a #LpfLoc
+ *
+ * Returns: (allow-none): the namespace of the location's id, usually
+ * the name of the provider that returned it
+ */
+const gchar*
+lpf_loc_get_provider(LpfLoc *self)
+{
+    LpfLocPrivate *priv = GET_PRIVATE (self);
+
+    return priv->provider;
+}
+
+/**
+ * lpf_loc_hash:
+ * @loc: (type LpfLoc): a #LpfLoc
+ *
+ * Hash function for using locations as keys in a #GHashTable
+ * together with #lpf_loc_equal.
+ *
+ * Returns: a hash value for @loc
+ */
+guint
+lpf_loc_hash(gconstpointer loc)
+{
+    LpfLocPrivate *priv = GET_PRIVATE ((LpfLoc*)loc);
+
+    if (priv->id)
+        return g_direct_hash (priv->provider) * 31 + priv->id;
+    /* names are interned */
+    return g_direct_hash (priv->name);
+}
+
+/**
+ * lpf_loc_equal:
+ * @a: (type LpfLoc): a #LpfLoc
+ * @b: (type LpfLoc): another #LpfLoc
+ *
+ * Locations are equal if they have the same id from the same
+ * provider. Locations without id are compared by name and position.
+ *
+ * Returns: %TRUE if @a and @b denote the same location
+ */
+gboolean
+lpf_loc_equal(gconstpointer a, gconstpointer b)
+{
+    LpfLocPrivate *pa = GET_PRIVATE ((LpfLoc*)a);
+    LpfLocPrivate *pb = GET_PRIVATE ((LpfLoc*)b);
+
+    if (pa->id || pb->id)
+        return pa->id == pb->id && pa->provider == pb->provider;
+
+    return pa->name == pb->name &&
+        pa->long_ == pb->long_ &&
+        pa->lat == pb->lat;
 }
 
 /**
  * lpf_loc_get_name: (transfer none):
  * @self: a #LpfLoc
  *
+ * Names are interned so locations with equal names share the
+ * same string.
+ *
  * Returns: the location's name
  */
 const gchar*
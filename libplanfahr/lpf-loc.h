@@ -35,12 +35,21 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (LpfLoc, lpf_loc, LPF, LOC, GObject)
 
+LpfLoc      *lpf_loc_new_full (const gchar *name, gdouble long_, gdouble lat);
 const gchar *lpf_loc_get_name (LpfLoc* self);
 double       lpf_loc_get_lat  (LpfLoc *self);
 double       lpf_loc_get_long (LpfLoc *self);
+guint32      lpf_loc_get_id   (LpfLoc *self);
+const gchar *lpf_loc_get_provider (LpfLoc *self);
+
+guint    lpf_loc_hash  (gconstpointer loc);
+gboolean lpf_loc_equal (gconstpointer a, gconstpointer b);
 
 gpointer lpf_loc_get_opaque (LpfLoc *self);
 void lpf_loc_set_opaque (LpfLoc *self, gpointer opaque);
+void lpf_loc_set_opaque_full (LpfLoc *self, gpointer opaque, GDestroyNotify destroy);
+void lpf_loc_set_id (LpfLoc *self, const gchar *provider, guint32 id);
+void lpf_loc_set_full (LpfLoc *self, const gchar *name, gdouble long_, gdouble lat);
 
 G_END_DECLS
 
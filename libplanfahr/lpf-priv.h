@@ -41,4 +41,24 @@
     do { } while (0)
 #endif /* !ENABLE_DEBUG */
 
+#include <glib.h>
+
+/*
+ * Names, line names and platforms repeat a lot across trips so objects
+ * hold interned strings. These are shared, immutable and freed once
+ * the last user is gone.
+ */
+static inline gchar*
+lpf_str_intern (const gchar *str)
+{
+    return str ? g_ref_string_new_intern (str) : NULL;
+}
+
+static inline void
+lpf_str_release (gchar *str)
+{
+    if (str)
+        g_ref_string_release (str);
+}
+
 #endif
@@ -48,6 +48,43 @@ G_DEFINE_INTERFACE (LpfProvider, lpf_provider, G_TYPE_OBJECT)
  * Callback invoked after the trips matching the query were
  * received. In case of an error @trips is #NULL.
  */
+/**
+ * LpfProviderGotLocsBatchNotify:
+ * @idx: index of the match the locations belong to
+ * @locs: (element-type Lpf.Loc): List of found locations
+ * @user_data: userdata
+ * @err: (transfer full): #GError
+ *
+ * Callback invoked for each match passed to
+ * #lpf_provider_get_locs_batch once its locations were
+ * received. In case of an error @locs is #NULL.
+ */
+/**
+ * LpfProviderGotTripNotify:
+ * @trip: (transfer full): a found trip
+ * @user_data: userdata
+ *
+ * Callback invoked for each trip as soon as it got received when
+ * using #lpf_provider_get_trips_stream.
+ */
+/**
+ * LpfProviderGotLocListNotify:
+ * @locs: (transfer full) (allow-none): the found locations
+ * @user_data: userdata
+ * @err: (transfer full): #GError
+ *
+ * Callback invoked after the locations matching the query were
+ * received. In case of an error @locs is #NULL.
+ */
+/**
+ * LpfProviderGotTripListNotify:
+ * @trips: (transfer full) (allow-none): the found trips
+ * @user_data: userdata
+ * @err: (transfer full): #GError
+ *
+ * Callback invoked after the trips matching the query were
+ * received. In case of an error @trips is #NULL.
+ */
 
 
 GQuark
@@ -113,6 +150,265 @@ lpf_provider_get_locs (LpfProvider *self, const char* match, LpfProviderGetLocsF
     return LPF_PROVIDER_GET_INTERFACE (self)->get_locs (self, match, flags, callback, user_data);
 }
 
+/* transfers data between lpf_provider_get_locs_full and the callback */
+typedef struct _LpfProviderCapData {
+    LpfProvider *self;
+    guint max_results;
+    LpfProviderGotLocsNotify callback;
+    gpointer user_data;
+} LpfProviderCapData;
+
+
+/* cap the result for providers that can't do it themselves */
+static void
+got_locs_capped (GSList *locs, gpointer user_data, GError *err)
+{
+    LpfProviderCapData *cap_data = user_data;
+    GSList *last;
+
+    last = g_slist_nth (locs, cap_data->max_results - 1);
+    if (last && last->next) {
+        lpf_provider_free_locs (cap_data->self, last->next);
+        last->next = NULL;
+    }
+
+    (*cap_data->callback)(locs, cap_data->user_data, err);
+    g_free (cap_data);
+}
+
+/**
+ * lpf_provider_get_locs_full:
+ * @self: a #LpfProvider
+ * @match: locations to match
+ * @flags: #LpfProviderGetLocsFlags for loation lookup
+ * @max_results: maximum number of locations to return, 0 for no limit
+ * @callback: (scope async): #LpfProviderGotLocsNotify to invoke
+ *   once locations are available
+ * @user_data: (allow-none): User data for the callback
+ *
+ * Like #lpf_provider_get_locs but returns at most @max_results
+ * locations. Use this for e.g. autocompletion where only the
+ * first few matches are shown.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_locs_full (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderCapData *cap_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (match, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_locs_full)
+        return iface->get_locs_full (self, match, flags, max_results, callback, user_data);
+    if (!max_results)
+        return iface->get_locs (self, match, flags, callback, user_data);
+
+    cap_data = g_new0 (LpfProviderCapData, 1);
+    cap_data->self = self;
+    cap_data->max_results = max_results;
+    cap_data->callback = callback;
+    cap_data->user_data = user_data;
+
+    ret = iface->get_locs (self, match, flags, got_locs_capped, cap_data);
+    if (ret < 0)
+        g_free (cap_data);
+    return ret;
+}
+
+/* transfers data between lpf_provider_get_locs_progressive and the callback */
+typedef struct _LpfProviderProgressData {
+    LpfProviderGotLocsProgressNotify callback;
+    gpointer user_data;
+} LpfProviderProgressData;
+
+
+/* the only answer of providers without local knowledge is the final one */
+static void
+got_locs_final (GSList *locs, gpointer user_data, GError *err)
+{
+    LpfProviderProgressData *progress_data = user_data;
+
+    (*progress_data->callback)(locs, TRUE, progress_data->user_data, err);
+    g_free (progress_data);
+}
+
+/**
+ * lpf_provider_get_locs_progressive:
+ * @self: a #LpfProvider
+ * @match: locations to match
+ * @flags: #LpfProviderGetLocsFlags for loation lookup
+ * @max_results: maximum number of locations to return, 0 for no limit
+ * @callback: (scope async): #LpfProviderGotLocsProgressNotify to invoke
+ *   once locations are available
+ * @user_data: (allow-none): User data for the callback
+ *
+ * Like #lpf_provider_get_locs_full but meant for type-ahead: If the
+ * provider knows matching locations already, e.g. from earlier
+ * lookups or trips, @callback is invoked with these right away and
+ * @final set to %FALSE. It's invoked again with @final set to
+ * %TRUE once the provider's answer is available. Without local
+ * knowledge there is only the final invocation. Each invocation
+ * passes ownership of the list.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_locs_progressive (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsProgressNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderProgressData *progress_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (match, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_locs_progressive)
+        return iface->get_locs_progressive (self, match, flags, max_results, callback, user_data);
+
+    progress_data = g_new0 (LpfProviderProgressData, 1);
+    progress_data->callback = callback;
+    progress_data->user_data = user_data;
+
+    ret = lpf_provider_get_locs_full (self, match, flags, max_results, got_locs_final, progress_data);
+    if (ret < 0)
+        g_free (progress_data);
+    return ret;
+}
+
+/**
+ * lpf_provider_get_locs_near:
+ * @self: a #LpfProvider
+ * @lon: longitude of the point
+ * @lat: latitude of the point
+ * @radius: only return stations within this many meters, 0 for no limit
+ * @max_results: maximum number of stations to return, 0 for no limit
+ * @callback: (scope async): #LpfProviderGotLocsNotify to invoke
+ *   once locations are available
+ * @user_data: (allow-none): User data for the callback
+ *
+ * Look up the stations closest to a point, nearest first. At least
+ * one of @radius and @max_results must be given. Providers answer
+ * this from the stations they have seen in earlier replies so an
+ * empty list doesn't mean there's no station around.
+ *
+ * Returns: 0 on success, -1 on error or if the provider can't
+ *   look up stations by position
+ */
+gint
+lpf_provider_get_locs_near (LpfProvider *self, gdouble lon, gdouble lat, guint radius, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (radius || max_results, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_locs_near == NULL)
+        return -1;
+    return iface->get_locs_near (self, lon, lat, radius, max_results, callback, user_data);
+}
+
+/**
+ * lpf_provider_loc_new_from_id:
+ * @self: a #LpfProvider
+ * @id: the provider's numeric id of a station
+ *
+ * Build a location from a station id as returned by
+ * #lpf_loc_get_id without looking it up. The location can be used
+ * as trip endpoint right away, its name and position are only
+ * filled in if the provider knows the station already.
+ *
+ * Returns: (transfer full) (allow-none): a new #LpfLoc or %NULL if
+ *   the provider can't build locations from ids
+ */
+LpfLoc*
+lpf_provider_loc_new_from_id (LpfProvider *self, guint32 id)
+{
+    LpfProviderInterface *iface;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), NULL);
+    g_return_val_if_fail (id, NULL);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->loc_new_from_id == NULL)
+        return NULL;
+    return iface->loc_new_from_id (self, id);
+}
+
+/* transfers data between the list and linked list based lookups */
+typedef struct _LpfProviderListData {
+    gpointer callback;
+    gpointer user_data;
+} LpfProviderListData;
+
+
+/* hand linked list results to a list based callback */
+static void
+got_locs_list (GSList *locs, gpointer user_data, GError *err)
+{
+    LpfProviderListData *list_data = user_data;
+    LpfProviderGotLocListNotify callback = list_data->callback;
+    LpfLocList *list = NULL;
+
+    if (err == NULL)
+        list = lpf_loc_list_new_from_slist (locs);
+    else
+        g_slist_free_full (locs, g_object_unref);
+
+    (*callback)(list, list_data->user_data, err);
+    g_free (list_data);
+}
+
+/**
+ * lpf_provider_get_loc_list:
+ * @self: a #LpfProvider
+ * @match: locations to match
+ * @flags: #LpfProviderGetLocsFlags for loation lookup
+ * @max_results: maximum number of locations to return, 0 for no limit
+ * @callback: (scope async): #LpfProviderGotLocListNotify to invoke
+ *   once locations are available
+ * @user_data: (allow-none): User data for the callback
+ *
+ * Like #lpf_provider_get_locs_full but @callback is invoked with a
+ * #LpfLocList that can be indexed in constant time. The caller owns
+ * the list.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_loc_list (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocListNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderListData *list_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (match, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_loc_list)
+        return iface->get_loc_list (self, match, flags, max_results, callback, user_data);
+
+    list_data = g_new0 (LpfProviderListData, 1);
+    list_data->callback = callback;
+    list_data->user_data = user_data;
+
+    ret = lpf_provider_get_locs_full (self, match, flags, max_results, got_locs_list, list_data);
+    if (ret < 0)
+        g_free (list_data);
+    return ret;
+}
+
 /**
  * lpf_provider_free_locs:
  * @self: a #LpfProvider
@@ -126,6 +422,143 @@ lpf_provider_free_locs(LpfProvider *self, GSList *locs)
     g_slist_free_full (locs, g_object_unref);
 }
 
+/* transfers data between lpf_provider_get_locs_batch and the callbacks */
+typedef struct _LpfProviderBatchData {
+    LpfProvider *self;
+    gchar **matches;
+    guint idx;
+    LpfProviderGetLocsFlags flags;
+    LpfProviderGotLocsBatchNotify locs_callback;
+    LpfProviderGotLocsNotify callback;
+    gpointer user_data;
+} LpfProviderBatchData;
+
+
+/* look up one match after the other for providers that can't batch */
+static void
+got_locs_batch (GSList *locs, gpointer user_data, GError *err)
+{
+    LpfProviderBatchData *batch_data = user_data;
+    LpfProviderInterface *iface = LPF_PROVIDER_GET_INTERFACE (batch_data->self);
+
+    (*batch_data->locs_callback)(batch_data->idx, locs, batch_data->user_data, err);
+
+    while (batch_data->matches[++batch_data->idx]) {
+        if (iface->get_locs (batch_data->self,
+                             batch_data->matches[batch_data->idx],
+                             batch_data->flags,
+                             got_locs_batch,
+                             batch_data) == 0)
+            return;
+
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_REQUEST_FAILED,
+                     "Cannot get location for '%s'",
+                     batch_data->matches[batch_data->idx]);
+        (*batch_data->locs_callback)(batch_data->idx, NULL, batch_data->user_data, err);
+        err = NULL;
+    }
+
+    (*batch_data->callback)(NULL, batch_data->user_data, NULL);
+    g_strfreev (batch_data->matches);
+    g_free (batch_data);
+}
+
+/**
+ * lpf_provider_get_locs_batch:
+ * @self: a #LpfProvider
+ * @matches: (array zero-terminated=1): %NULL terminated list of
+ *   locations to match
+ * @flags: #LpfProviderGetLocsFlags for loation lookup
+ * @locs_callback: (scope async): #LpfProviderGotLocsBatchNotify to
+ *   invoke for each match
+ * @callback: (scope async): #LpfProviderGotLocsNotify to invoke
+ *   once all matches were handled
+ * @user_data: (allow-none): User data for the callbacks
+ *
+ * Like #lpf_provider_get_locs but looks up many locations at
+ * once. Providers that support it pack several matches into a
+ * single request. @locs_callback is invoked with the index of the
+ * match in @matches and the matched #LpfLocation s. The caller
+ * is responsible for freeing these via #lpf_provider_free_locs.
+ * Once all matches are handled @callback is invoked with a %NULL
+ * locations list.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_locs_batch (LpfProvider *self, const gchar * const *matches, LpfProviderGetLocsFlags flags, LpfProviderGotLocsBatchNotify locs_callback, LpfProviderGotLocsNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderBatchData *batch_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (matches && matches[0], -1);
+    g_return_val_if_fail (locs_callback, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_locs_batch)
+        return iface->get_locs_batch (self, matches, flags, locs_callback, callback, user_data);
+
+    batch_data = g_new0 (LpfProviderBatchData, 1);
+    batch_data->self = self;
+    batch_data->matches = g_strdupv ((gchar **)matches);
+    batch_data->flags = flags;
+    batch_data->locs_callback = locs_callback;
+    batch_data->callback = callback;
+    batch_data->user_data = user_data;
+
+    ret = iface->get_locs (self, matches[0], flags, got_locs_batch, batch_data);
+    if (ret < 0) {
+        g_strfreev (batch_data->matches);
+        g_free (batch_data);
+    }
+    return ret;
+}
+
+/* hand list results to a linked list based callback */
+static void
+got_trip_list_slist (LpfTripList *trips, gpointer user_data, GError *err)
+{
+    LpfProviderListData *list_data = user_data;
+    LpfProviderGotTripsNotify callback = list_data->callback;
+    GSList *slist = NULL;
+
+    if (trips) {
+        slist = lpf_trip_list_to_slist (trips);
+        g_object_unref (trips);
+    }
+
+    (*callback)(slist, list_data->user_data, err);
+    g_free (list_data);
+}
+
+
+/* look up trips via whatever the provider implements */
+static gint
+provider_get_trips (LpfProvider *self, LpfLoc *start, LpfLoc *end, GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripsNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface = LPF_PROVIDER_GET_INTERFACE (self);
+    LpfProviderListData *list_data;
+    gint ret;
+
+    if (iface->get_trips)
+        return iface->get_trips (self, start, end, date, flags, callback, user_data);
+    g_return_val_if_fail (iface->get_trip_list, -1);
+
+    list_data = g_new0 (LpfProviderListData, 1);
+    list_data->callback = callback;
+    list_data->user_data = user_data;
+
+    ret = iface->get_trip_list (self, start, end, date, flags, got_trip_list_slist, list_data);
+    if (ret < 0)
+        g_free (list_data);
+    return ret;
+}
+
 /**
  * lpf_provider_get_trips:
  * @self: a #LpfProvider
@@ -141,7 +574,8 @@ lpf_provider_free_locs(LpfProvider *self, GSList *locs)
  * at @end and starting (or depending on @flags) ending at @date.
  * Once completed @callback is invoked with a #GSList of matched
  * trips. The caller is responsible for freeing the locations list via
- * #lpf_provider_free_trips.
+ * #lpf_provider_free_trips. Use #lpf_provider_get_trip_list to get
+ * the trips as #LpfTripList instead.
  *
  * Returns: 0 on success, -1 on error
  */
@@ -155,7 +589,69 @@ lpf_provider_get_trips (LpfProvider *self, LpfLoc *start, LpfLoc *end, GDateTime
     g_return_val_if_fail (date, -1);
     g_return_val_if_fail (callback, -1);
 
-    return LPF_PROVIDER_GET_INTERFACE (self)->get_trips (self, start, end, date, flags, callback, user_data);
+    return provider_get_trips (self, start, end, date, flags, callback, user_data);
+}
+
+
+/* hand linked list results to a list based callback */
+static void
+got_trips_list (GSList *trips, gpointer user_data, GError *err)
+{
+    LpfProviderListData *list_data = user_data;
+    LpfProviderGotTripListNotify callback = list_data->callback;
+    LpfTripList *list = NULL;
+
+    if (err == NULL)
+        list = lpf_trip_list_new_from_slist (trips);
+    else
+        g_slist_free_full (trips, g_object_unref);
+
+    (*callback)(list, list_data->user_data, err);
+    g_free (list_data);
+}
+
+/**
+ * lpf_provider_get_trip_list:
+ * @self: a #LpfProvider
+ * @start: start of trip location
+ * @end: end of trip location
+ * @date: Date and time the trip starts as #GDateTime
+ * @flags: #LpfProviderGetTripsFlags for trip lookups
+ * @callback: (scope async): #LpfProviderGotTripListNotify to invoke
+ *   once trips are available
+ * @user_data: (allow-none): User data for the callback
+ *
+ * Like #lpf_provider_get_trips but @callback is invoked with a
+ * #LpfTripList that can be indexed in constant time. The caller
+ * owns the list.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_trip_list (LpfProvider *self, LpfLoc *start, LpfLoc *end, GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripListNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderListData *list_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (start, -1);
+    g_return_val_if_fail (end, -1);
+    g_return_val_if_fail (date, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_trip_list)
+        return iface->get_trip_list (self, start, end, date, flags, callback, user_data);
+
+    list_data = g_new0 (LpfProviderListData, 1);
+    list_data->callback = callback;
+    list_data->user_data = user_data;
+
+    ret = iface->get_trips (self, start, end, date, flags, got_trips_list, list_data);
+    if (ret < 0)
+        g_free (list_data);
+    return ret;
 }
 
 static void
@@ -183,6 +679,79 @@ lpf_provider_free_trips(LpfProvider *self, GSList *trips)
 }
 
 
+/* transfers data between lpf_provider_get_trips_stream and the callbacks */
+typedef struct _LpfProviderStreamData {
+    LpfProviderGotTripNotify trip_callback;
+    LpfProviderGotTripsNotify callback;
+    gpointer user_data;
+} LpfProviderStreamData;
+
+
+/* hand out the trips one by one for providers that can't stream */
+static void
+got_trips_stream (GSList *trips, gpointer user_data, GError *err)
+{
+    LpfProviderStreamData *stream_data = user_data;
+    GSList *l;
+
+    for (l = trips; l; l = g_slist_next (l))
+        (*stream_data->trip_callback)(LPF_TRIP (l->data), stream_data->user_data);
+    g_slist_free (trips);
+
+    (*stream_data->callback)(NULL, stream_data->user_data, err);
+    g_free (stream_data);
+}
+
+/**
+ * lpf_provider_get_trips_stream:
+ * @self: a #LpfProvider
+ * @start: start of trip location
+ * @end: end of trip location
+ * @date: Date and time the trip starts as #GDateTime
+ * @flags: #LpfProviderGetTripsFlags for trip lookups
+ * @trip_callback: (scope async): #LpfProviderGotTripNotify to invoke
+ *   for each trip
+ * @callback: (scope async): #LpfProviderGotTripsNotify to invoke
+ *   once all trips got received
+ * @user_data: (allow-none): User data for the callbacks
+ *
+ * Like #lpf_provider_get_trips but @trip_callback is invoked with
+ * each trip as soon as it can be parsed so trips can be processed
+ * while the rest of the response is still being received. The
+ * caller owns the passed trip. Once all trips are received or on
+ * error @callback is invoked with a %NULL trips list.
+ *
+ * Returns: 0 on success, -1 on error
+ */
+gint
+lpf_provider_get_trips_stream (LpfProvider *self, LpfLoc *start, LpfLoc *end, GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripNotify trip_callback, LpfProviderGotTripsNotify callback, gpointer user_data)
+{
+    LpfProviderInterface *iface;
+    LpfProviderStreamData *stream_data;
+    gint ret;
+
+    g_return_val_if_fail (LPF_IS_PROVIDER (self), -1);
+    g_return_val_if_fail (start, -1);
+    g_return_val_if_fail (end, -1);
+    g_return_val_if_fail (date, -1);
+    g_return_val_if_fail (trip_callback, -1);
+    g_return_val_if_fail (callback, -1);
+
+    iface = LPF_PROVIDER_GET_INTERFACE (self);
+    if (iface->get_trips_stream)
+        return iface->get_trips_stream (self, start, end, date, flags, trip_callback, callback, user_data);
+
+    stream_data = g_new0 (LpfProviderStreamData, 1);
+    stream_data->trip_callback = trip_callback;
+    stream_data->callback = callback;
+    stream_data->user_data = user_data;
+
+    ret = provider_get_trips (self, start, end, date, flags, got_trips_stream, stream_data);
+    if (ret < 0)
+        g_free (stream_data);
+    return ret;
+}
+
 /**
  * lpf_provider_create: (skip)
  *
@@ -25,6 +25,9 @@
 
 #include <glib-object.h>
 #include <libplanfahr/lpf-loc.h>
+#include <libplanfahr/lpf-loc-list.h>
+#include <libplanfahr/lpf-trip.h>
+#include <libplanfahr/lpf-trip-list.h>
 
 G_BEGIN_DECLS
 
@@ -53,14 +56,20 @@ typedef enum {
 
 /**
  * LpfProviderGetLocsFlags:
- * @LPF_PROVIDER_GET_LOCS_NONE: No flags
+ * @LPF_PROVIDER_GET_LOCS_NONE: No flags, same as %LPF_PROVIDER_GET_LOCS_STATIONS
+ * @LPF_PROVIDER_GET_LOCS_STATIONS: Match stations
+ * @LPF_PROVIDER_GET_LOCS_ADDRESSES: Match addresses
+ * @LPF_PROVIDER_GET_LOCS_POIS: Match points of interest
  *
- * Flags passed to #lpf_provider_get_locs. Currently only here for symmetry with
- * other API functions.
+ * Flags passed to #lpf_provider_get_locs. The location types can be
+ * combined.
  */
 typedef enum
 {
-    LPF_PROVIDER_GET_LOCS_NONE = 0, /*< nick=none >*/
+    LPF_PROVIDER_GET_LOCS_NONE      =      0, /*< nick=none >*/
+    LPF_PROVIDER_GET_LOCS_STATIONS  = 1 << 0, /*< nick=stations >*/
+    LPF_PROVIDER_GET_LOCS_ADDRESSES = 1 << 1, /*< nick=addresses >*/
+    LPF_PROVIDER_GET_LOCS_POIS      = 1 << 2, /*< nick=pois >*/
 } LpfProviderGetLocsFlags;
 
 
@@ -94,6 +103,11 @@ typedef enum
 
 typedef void (*LpfProviderGotLocsNotify) (GSList *locs, gpointer user_data, GError *err);
 typedef void (*LpfProviderGotTripsNotify) (GSList *trips, gpointer user_data, GError *err);
+typedef void (*LpfProviderGotTripNotify) (LpfTrip *trip, gpointer user_data);
+typedef void (*LpfProviderGotLocsBatchNotify) (guint idx, GSList *locs, gpointer user_data, GError *err);
+typedef void (*LpfProviderGotLocsProgressNotify) (GSList *locs, gboolean final, gpointer user_data, GError *err);
+typedef void (*LpfProviderGotLocListNotify) (LpfLocList *locs, gpointer user_data, GError *err);
+typedef void (*LpfProviderGotTripListNotify) (LpfTripList *trips, gpointer user_data, GError *err);
 
 typedef struct _LpfProvider LpfProvider;
 
@@ -107,6 +121,14 @@ typedef struct {
 
     gint (*get_locs)  (LpfProvider *self, const gchar *match, LpfProviderGetLocsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data);
     gint (*get_trips) (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data);
+    gint (*get_trips_stream) (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripNotify trip_callback, LpfProviderGotTripsNotify callback, gpointer user_data);
+    gint (*get_locs_batch) (LpfProvider *self, const gchar * const *matches, LpfProviderGetLocsFlags flags, LpfProviderGotLocsBatchNotify locs_callback, LpfProviderGotLocsNotify callback, gpointer user_data);
+    gint (*get_locs_full) (LpfProvider *self, const gchar *match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data);
+    gint (*get_locs_progressive) (LpfProvider *self, const gchar *match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsProgressNotify callback, gpointer user_data);
+    gint (*get_locs_near) (LpfProvider *self, gdouble lon, gdouble lat, guint radius, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data);
+    gint (*get_loc_list) (LpfProvider *self, const gchar *match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocListNotify callback, gpointer user_data);
+    gint (*get_trip_list) (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripListNotify callback, gpointer user_data);
+    LpfLoc* (*loc_new_from_id) (LpfProvider *self, guint32 id);
 } LpfProviderInterface;
 
 GType lpf_provider_get_type (void);
@@ -120,10 +142,18 @@ void lpf_provider_deactivate (LpfProvider *self, GObject *obj);
 GQuark lpf_provider_error_quark (void);
 
 gint lpf_provider_get_locs (LpfProvider *self, const gchar* match, LpfProviderGetLocsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data);
+gint lpf_provider_get_locs_full (LpfProvider *self, const gchar* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data);
 void lpf_provider_free_locs (LpfProvider *self, GSList *locs);
+gint lpf_provider_get_locs_progressive (LpfProvider *self, const gchar* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsProgressNotify callback, gpointer user_data);
+gint lpf_provider_get_locs_near (LpfProvider *self, gdouble lon, gdouble lat, guint radius, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data);
+gint lpf_provider_get_loc_list (LpfProvider *self, const gchar* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocListNotify callback, gpointer user_data);
+gint lpf_provider_get_locs_batch (LpfProvider *self, const gchar * const *matches, LpfProviderGetLocsFlags flags, LpfProviderGotLocsBatchNotify locs_callback, LpfProviderGotLocsNotify callback, gpointer user_data);
+LpfLoc *lpf_provider_loc_new_from_id (LpfProvider *self, guint32 id);
 
 gint lpf_provider_get_trips  (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data);
 void lpf_provider_free_trips (LpfProvider *self, GSList *trips);
+gint lpf_provider_get_trip_list (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripListNotify callback, gpointer user_data);
+gint lpf_provider_get_trips_stream (LpfProvider *self, LpfLoc *start, LpfLoc *end,  GDateTime *date, LpfProviderGetTripsFlags flags, LpfProviderGotTripNotify trip_callback, LpfProviderGotTripsNotify callback, gpointer user_data);
 
 
 G_END_DECLS
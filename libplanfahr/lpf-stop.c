@@ -49,6 +49,12 @@ enum {
  * @short_description: A stop during public transport
  *
  * A #LpfStop adds arrival and departure times to a #LpfLoc.
+ *
+ * Times are kept as minutes since the Unix epoch in UTC so a stop
+ * stays small. Seconds and the time zone of a #GDateTime set on a
+ * stop are dropped, reading a time property returns a new UTC
+ * #GDateTime for the same minute. Code looking at many stops should
+ * prefer the integer accessors.
  */
 
 G_DEFINE_TYPE (LpfStop, lpf_stop, LPF_TYPE_LOC)
@@ -57,13 +63,31 @@ G_DEFINE_TYPE (LpfStop, lpf_stop, LPF_TYPE_LOC)
 
 typedef struct _LpfStopPrivate LpfStopPrivate;
 struct _LpfStopPrivate {
-    /* Planned */
-    GDateTime *arr, *dep;
+    /* Planned, minutes since the epoch or LPF_STOP_NO_TIME */
+    gint32 arr, dep;
     gchar *arr_plat, *dep_plat;
     /* Predicted */
-    GDateTime *rt_arr, *rt_dep;
+    gint32 rt_arr, rt_dep;
 };
 
+static gint32
+date_time_to_minutes (GDateTime *dt)
+{
+    if (dt == NULL)
+        return LPF_STOP_NO_TIME;
+
+    return g_date_time_to_unix (dt) / 60;
+}
+
+static GDateTime*
+minutes_to_date_time (gint32 min)
+{
+    if (min == LPF_STOP_NO_TIME)
+        return NULL;
+
+    return g_date_time_new_from_unix_utc ((gint64)min * 60);
+}
+
 static void
 lpf_stop_set_property (GObject *object,
                       guint property_id,
@@ -75,37 +99,29 @@ lpf_stop_set_property (GObject *object,
 
     switch (property_id) {
     case LPF_STOP_PROP_ARRIVAL:
-        if (priv->arr)
-            g_date_time_unref (priv->arr);
-        priv->arr = g_value_get_boxed (value);
+        priv->arr = date_time_to_minutes (g_value_get_boxed (value));
         break;
 
     case LPF_STOP_PROP_DEPARTURE:
-        if (priv->dep)
-            g_date_time_unref (priv->dep);
-        priv->dep = g_value_get_boxed (value);
+        priv->dep = date_time_to_minutes (g_value_get_boxed (value));
         break;
 
     case LPF_STOP_PROP_ARRIVAL_PLATFORM:
-        g_free (priv->arr_plat);
-        priv->arr_plat = g_value_dup_string (value);
+        lpf_str_release (priv->arr_plat);
+        priv->arr_plat = lpf_str_intern (g_value_get_string (value));
         break;
 
     case LPF_STOP_PROP_DEPARTURE_PLATFORM:
-        g_free (priv->dep_plat);
-        priv->dep_plat = g_value_dup_string (value);
+        lpf_str_release (priv->dep_plat);
+        priv->dep_plat = lpf_str_intern (g_value_get_string (value));
         break;
 
     case LPF_STOP_PROP_RT_ARRIVAL:
-        if (priv->rt_arr)
-            g_date_time_unref (priv->rt_arr);
-        priv->rt_arr = g_value_get_boxed (value);
+        priv->rt_arr = date_time_to_minutes (g_value_get_boxed (value));
         break;
 
     case LPF_STOP_PROP_RT_DEPARTURE:
-        if (priv->rt_dep)
-            g_date_time_unref (priv->rt_dep);
-        priv->rt_dep = g_value_get_boxed (value);
+        priv->rt_dep = date_time_to_minutes (g_value_get_boxed (value));
         break;
 
     default:
@@ -118,12 +134,12 @@ lpf_stop_set_property (GObject *object,
 /* calc_delay: Calculate the time difference between planned and real time in
  * minutes */
 static gint
-calc_delay(GDateTime *planned, GDateTime *real)
+calc_delay(gint32 planned, gint32 real)
 {
-    if (planned == NULL || real == NULL)
+    if (planned == LPF_STOP_NO_TIME || real == LPF_STOP_NO_TIME)
         return 0;
 
-    return g_date_time_difference (real, planned) / (60 * 1000 * 1000);
+    return real - planned;
 }
 
 
@@ -135,15 +151,14 @@ lpf_stop_get_property (GObject *object,
 {
     LpfStop *self = LPF_STOP (object);
     LpfStopPrivate *priv = GET_PRIVATE(self);
-    gint delay;
 
     switch (property_id) {
     case LPF_STOP_PROP_ARRIVAL:
-        g_value_set_boxed (value, priv->arr);
+        g_value_take_boxed (value, minutes_to_date_time (priv->arr));
         break;
 
     case LPF_STOP_PROP_DEPARTURE:
-        g_value_set_boxed (value, priv->dep);
+        g_value_take_boxed (value, minutes_to_date_time (priv->dep));
         break;
 
     case LPF_STOP_PROP_ARRIVAL_PLATFORM:
@@ -155,21 +170,19 @@ lpf_stop_get_property (GObject *object,
         break;
 
     case LPF_STOP_PROP_RT_ARRIVAL:
-        g_value_set_boxed (value, priv->rt_arr);
+        g_value_take_boxed (value, minutes_to_date_time (priv->rt_arr));
         break;
 
     case LPF_STOP_PROP_RT_DEPARTURE:
-        g_value_set_boxed (value, priv->rt_dep);
+        g_value_take_boxed (value, minutes_to_date_time (priv->rt_dep));
         break;
 
     case LPF_STOP_PROP_ARRIVAL_DELAY:
-        delay = calc_delay (priv->arr, priv->rt_arr);
-        g_value_set_int (value, delay);
+        g_value_set_int (value, calc_delay (priv->arr, priv->rt_arr));
         break;
 
     case LPF_STOP_PROP_DEPARTURE_DELAY:
-        delay = calc_delay (priv->dep, priv->rt_dep);
-        g_value_set_int (value, delay);
+        g_value_set_int (value, calc_delay (priv->dep, priv->rt_dep));
         break;
 
     default:
@@ -195,16 +208,8 @@ lpf_stop_finalize (GObject *object)
     LpfStopPrivate *priv = GET_PRIVATE (self);
     GObjectClass *parent_class = G_OBJECT_CLASS (lpf_stop_parent_class);
 
-    if (priv->dep)
-        g_date_time_unref (priv->dep);
-    if (priv->arr)
-        g_date_time_unref (priv->arr);
-    g_free (priv->arr_plat);
-    g_free (priv->dep_plat);
-    if (priv->rt_dep)
-        g_date_time_unref (priv->rt_dep);
-    if (priv->rt_arr)
-        g_date_time_unref (priv->rt_arr);
+    lpf_str_release (priv->arr_plat);
+    lpf_str_release (priv->dep_plat);
 
     parent_class->finalize (object);
 }
@@ -225,25 +230,27 @@ lpf_stop_class_init (LpfStopClass *klass)
 /**
  * LpfStop:departure:
  *
- * Train departs at this stop at this date and time
+ * Train departs at this stop at this date and time. Stored with
+ * minute precision and read back in UTC.
  */
     g_object_class_install_property (object_class,
                                      LPF_STOP_PROP_DEPARTURE,
                                      g_param_spec_boxed ("departure",
                                                          "Departure",
-                                                         "Departure date and time",
+                                                         "Departure date and time (UTC, minute precision)",
                                                          G_TYPE_DATE_TIME,
                                                          G_PARAM_READWRITE));
 /**
  * LpfStop:arrival:
  *
- * Train arrives at this stop at this date and time
+ * Train arrives at this stop at this date and time. Stored with
+ * minute precision and read back in UTC.
  */
     g_object_class_install_property (object_class,
                                      LPF_STOP_PROP_ARRIVAL,
                                      g_param_spec_boxed ("arrival",
                                                          "Arrival",
-                                                         "Arrival date and time",
+                                                         "Arrival date and time (UTC, minute precision)",
                                                          G_TYPE_DATE_TIME,
                                                          G_PARAM_READWRITE));
 
@@ -265,25 +272,27 @@ lpf_stop_class_init (LpfStopClass *klass)
 /**
  * LpfStop:rt_departure:
  *
- * Real time departure time
+ * Real time departure time. Stored with minute precision and read
+ * back in UTC.
  */
     g_object_class_install_property (object_class,
                                      LPF_STOP_PROP_RT_DEPARTURE,
                                      g_param_spec_boxed ("rt_departure",
                                                          "Real Time Departure",
-                                                         "Real Time Departure date and time",
+                                                         "Real Time Departure date and time (UTC, minute precision)",
                                                          G_TYPE_DATE_TIME,
                                                          G_PARAM_READWRITE));
 /**
  * LpfStop:rt_arrival:
  *
- * Real time arrival time
+ * Real time arrival time. Stored with minute precision and read
+ * back in UTC.
  */
     g_object_class_install_property (object_class,
                                      LPF_STOP_PROP_RT_ARRIVAL,
                                      g_param_spec_boxed ("rt_arrival",
                                                          "Real Time Arrival",
-                                                         "Real time arrival date and time",
+                                                         "Real time arrival date and time (UTC, minute precision)",
                                                          G_TYPE_DATE_TIME,
                                                          G_PARAM_READWRITE));
 
@@ -311,4 +320,140 @@ lpf_stop_class_init (LpfStopClass *klass)
 static void
 lpf_stop_init (LpfStop *self)
 {
+    LpfStopPrivate *priv = GET_PRIVATE (self);
+
+    priv->arr = priv->dep = LPF_STOP_NO_TIME;
+    priv->rt_arr = priv->rt_dep = LPF_STOP_NO_TIME;
+}
+
+
+/**
+ * lpf_stop_new_full:
+ * @name: (allow-none): name of the stop
+ * @long_: longitude
+ * @lat: latitude
+ * @arr: planned arrival in minutes since the epoch or %LPF_STOP_NO_TIME
+ * @dep: planned departure in minutes since the epoch or %LPF_STOP_NO_TIME
+ * @rt_arr: predicted arrival in minutes since the epoch or %LPF_STOP_NO_TIME
+ * @rt_dep: predicted departure in minutes since the epoch or %LPF_STOP_NO_TIME
+ * @arr_plat: (allow-none): arrival platform
+ * @dep_plat: (allow-none): departure platform
+ *
+ * Create a stop in one go. Providers build lots of stops so this
+ * skips the property machinery. Times are minutes since the Unix
+ * epoch (1970-01-01 00:00 UTC).
+ *
+ * Returns: (transfer full): a new #LpfStop
+ */
+LpfStop*
+lpf_stop_new_full (const gchar *name, gdouble long_, gdouble lat,
+                   gint32 arr, gint32 dep,
+                   gint32 rt_arr, gint32 rt_dep,
+                   const gchar *arr_plat, const gchar *dep_plat)
+{
+    LpfStop *self = g_object_new (LPF_TYPE_STOP, NULL);
+    LpfStopPrivate *priv = GET_PRIVATE (self);
+
+    lpf_loc_set_full (LPF_LOC (self), name, long_, lat);
+    priv->arr = arr;
+    priv->dep = dep;
+    priv->rt_arr = rt_arr;
+    priv->rt_dep = rt_dep;
+    priv->arr_plat = lpf_str_intern (arr_plat);
+    priv->dep_plat = lpf_str_intern (dep_plat);
+    return self;
+}
+
+/**
+ * lpf_stop_get_arrival_minutes:
+ * @self: a #LpfStop
+ *
+ * Returns: the planned arrival in minutes since the Unix epoch
+ * (1970-01-01 00:00 UTC) or %LPF_STOP_NO_TIME
+ */
+gint32
+lpf_stop_get_arrival_minutes (LpfStop *self)
+{
+    g_return_val_if_fail (LPF_IS_STOP (self), LPF_STOP_NO_TIME);
+
+    return GET_PRIVATE (self)->arr;
+}
+
+/**
+ * lpf_stop_get_departure_minutes:
+ * @self: a #LpfStop
+ *
+ * Returns: the planned departure in minutes since the Unix epoch
+ * (1970-01-01 00:00 UTC) or %LPF_STOP_NO_TIME
+ */
+gint32
+lpf_stop_get_departure_minutes (LpfStop *self)
+{
+    g_return_val_if_fail (LPF_IS_STOP (self), LPF_STOP_NO_TIME);
+
+    return GET_PRIVATE (self)->dep;
+}
+
+/**
+ * lpf_stop_get_rt_arrival_minutes:
+ * @self: a #LpfStop
+ *
+ * Returns: the predicted arrival in minutes since the Unix epoch
+ * (1970-01-01 00:00 UTC) or %LPF_STOP_NO_TIME
+ */
+gint32
+lpf_stop_get_rt_arrival_minutes (LpfStop *self)
+{
+    g_return_val_if_fail (LPF_IS_STOP (self), LPF_STOP_NO_TIME);
+
+    return GET_PRIVATE (self)->rt_arr;
+}
+
+/**
+ * lpf_stop_get_rt_departure_minutes:
+ * @self: a #LpfStop
+ *
+ * Returns: the predicted departure in minutes since the Unix epoch
+ * (1970-01-01 00:00 UTC) or %LPF_STOP_NO_TIME
+ */
+gint32
+lpf_stop_get_rt_departure_minutes (LpfStop *self)
+{
+    g_return_val_if_fail (LPF_IS_STOP (self), LPF_STOP_NO_TIME);
+
+    return GET_PRIVATE (self)->rt_dep;
+}
+
+/**
+ * lpf_stop_get_arrival_delay:
+ * @self: a #LpfStop
+ *
+ * Returns: the arrival delay in minutes, 0 if unknown
+ */
+gint
+lpf_stop_get_arrival_delay (LpfStop *self)
+{
+    LpfStopPrivate *priv;
+
+    g_return_val_if_fail (LPF_IS_STOP (self), 0);
+
+    priv = GET_PRIVATE (self);
+    return calc_delay (priv->arr, priv->rt_arr);
+}
+
+/**
+ * lpf_stop_get_departure_delay:
+ * @self: a #LpfStop
+ *
+ * Returns: the departure delay in minutes, 0 if unknown
+ */
+gint
+lpf_stop_get_departure_delay (LpfStop *self)
+{
+    LpfStopPrivate *priv;
+
+    g_return_val_if_fail (LPF_IS_STOP (self), 0);
+
+    priv = GET_PRIVATE (self);
+    return calc_delay (priv->dep, priv->rt_dep);
 }
@@ -48,6 +48,13 @@ G_BEGIN_DECLS
 #define LPF_STOP_GET_CLASS(obj) \
   (G_TYPE_INSTANCE_GET_CLASS ((obj), LPF_TYPE_STOP, LpfStopClass))
 
+/**
+ * LPF_STOP_NO_TIME:
+ *
+ * A #LpfStop doesn't carry this time
+ */
+#define LPF_STOP_NO_TIME G_MININT32
+
 typedef struct {
   GObject parent;
 } LpfStop;
@@ -58,6 +65,18 @@ typedef struct {
 
 GType lpf_stop_get_type (void);
 
+LpfStop *lpf_stop_new_full (const gchar *name, gdouble long_, gdouble lat,
+                            gint32 arr, gint32 dep,
+                            gint32 rt_arr, gint32 rt_dep,
+                            const gchar *arr_plat, const gchar *dep_plat);
+
+gint32 lpf_stop_get_arrival_minutes (LpfStop *self);
+gint32 lpf_stop_get_departure_minutes (LpfStop *self);
+gint32 lpf_stop_get_rt_arrival_minutes (LpfStop *self);
+gint32 lpf_stop_get_rt_departure_minutes (LpfStop *self);
+gint   lpf_stop_get_arrival_delay (LpfStop *self);
+gint   lpf_stop_get_departure_delay (LpfStop *self);
+
 G_END_DECLS
 
 #endif /* _LPF_STOP_H */
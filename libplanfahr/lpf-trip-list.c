@@ -0,0 +1,168 @@
+/*
+ * lpf-trip-list.c: a list of trips
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <glib.h>
+
+#include "lpf-trip-list.h"
+#include "lpf-list.h"
+
+/**
+ * SECTION:lpf-trip-list
+ * @short_description: List of trips
+ *
+ * A #LpfTripList holds the trips of a provider reply. Appending,
+ * indexing and getting the length take constant time. It implements
+ * #GListModel so bindings can iterate and index it directly.
+ */
+
+struct _LpfTripList {
+    LpfList parent;
+};
+
+struct _LpfTripListClass {
+    LpfListClass parent_class;
+};
+
+G_DEFINE_TYPE (LpfTripList, lpf_trip_list, LPF_TYPE_LIST)
+
+
+static void
+lpf_trip_list_class_init (LpfTripListClass *klass)
+{
+    LPF_LIST_CLASS (klass)->item_type = LPF_TYPE_TRIP;
+}
+
+
+static void
+lpf_trip_list_init (LpfTripList *self)
+{
+}
+
+
+/**
+ * lpf_trip_list_new:
+ * @reserved: number of trips to reserve space for
+ *
+ * Returns: (transfer full): a new empty #LpfTripList
+ */
+LpfTripList*
+lpf_trip_list_new (guint reserved)
+{
+    return lpf_list_new_take (LPF_TYPE_TRIP_LIST,
+                              g_ptr_array_new_full (reserved, g_object_unref));
+}
+
+
+/**
+ * lpf_trip_list_new_take: (skip)
+ * @trips: (transfer full) (element-type LpfTrip): the trips, freeing
+ *   them with g_object_unref
+ *
+ * Create a list from trips collected upfront. Unlike appending to
+ * an empty list this doesn't signal each trip.
+ *
+ * Returns: (transfer full): a new #LpfTripList
+ */
+LpfTripList*
+lpf_trip_list_new_take (GPtrArray *trips)
+{
+    return lpf_list_new_take (LPF_TYPE_TRIP_LIST, trips);
+}
+
+
+/**
+ * lpf_trip_list_add:
+ * @self: a #LpfTripList
+ * @trip: (transfer full): the trip to append
+ *
+ * Append @trip to the end of the list.
+ */
+void
+lpf_trip_list_add (LpfTripList *self, LpfTrip *trip)
+{
+    g_return_if_fail (LPF_IS_TRIP_LIST (self));
+
+    lpf_list_add (LPF_LIST (self), trip);
+}
+
+
+/**
+ * lpf_trip_list_get_length:
+ * @self: a #LpfTripList
+ *
+ * Returns: the number of trips in the list
+ */
+guint
+lpf_trip_list_get_length (LpfTripList *self)
+{
+    g_return_val_if_fail (LPF_IS_TRIP_LIST (self), 0);
+
+    return LPF_LIST (self)->items->len;
+}
+
+
+/**
+ * lpf_trip_list_get:
+ * @self: a #LpfTripList
+ * @idx: index of the trip
+ *
+ * Returns: (transfer none): the trip at @idx
+ */
+LpfTrip*
+lpf_trip_list_get (LpfTripList *self, guint idx)
+{
+    g_return_val_if_fail (LPF_IS_TRIP_LIST (self), NULL);
+
+    return lpf_list_get (LPF_LIST (self), idx);
+}
+
+
+/**
+ * lpf_trip_list_new_from_slist: (skip)
+ * @trips: (transfer full) (element-type LpfTrip): linked list of trips
+ *
+ * Move the trips of a linked list into a new #LpfTripList,
+ * @trips is freed.
+ *
+ * Returns: (transfer full): a new #LpfTripList
+ */
+LpfTripList*
+lpf_trip_list_new_from_slist (GSList *trips)
+{
+    return lpf_list_new_from_slist (LPF_TYPE_TRIP_LIST, trips);
+}
+
+
+/**
+ * lpf_trip_list_to_slist: (skip)
+ * @self: a #LpfTripList
+ *
+ * Returns: (transfer full) (element-type LpfTrip): the trips as
+ * linked list for callers of the #GSList based API
+ */
+GSList*
+lpf_trip_list_to_slist (LpfTripList *self)
+{
+    g_return_val_if_fail (LPF_IS_TRIP_LIST (self), NULL);
+
+    return lpf_list_to_slist (LPF_LIST (self));
+}
@@ -0,0 +1,60 @@
+/*
+ * lpf-trip-list.h: a list of trips
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _LPF_TRIP_LIST_H
+#define _LPF_TRIP_LIST_H
+
+#if !defined (__LIBPLANFAHR_H_INSIDE__) && !defined (LIBPLANFAHR_COMPILATION)
+# error "Only <libplanfahr.h> can be included directly."
+#endif
+
+#include <gio/gio.h>
+
+#include <libplanfahr/lpf-trip.h>
+
+G_BEGIN_DECLS
+
+#define LPF_TYPE_TRIP_LIST (lpf_trip_list_get_type())
+
+#define LPF_TRIP_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_CAST ((obj), LPF_TYPE_TRIP_LIST, LpfTripList))
+
+#define LPF_IS_TRIP_LIST(obj) \
+  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), LPF_TYPE_TRIP_LIST))
+
+typedef struct _LpfTripList LpfTripList;
+typedef struct _LpfTripListClass LpfTripListClass;
+
+GType lpf_trip_list_get_type (void);
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (LpfTripList, g_object_unref)
+
+LpfTripList *lpf_trip_list_new (guint reserved);
+void lpf_trip_list_add (LpfTripList *self, LpfTrip *trip);
+guint lpf_trip_list_get_length (LpfTripList *self);
+LpfTrip *lpf_trip_list_get (LpfTripList *self, guint idx);
+LpfTripList *lpf_trip_list_new_from_slist (GSList *trips);
+GSList *lpf_trip_list_to_slist (LpfTripList *self);
+LpfTripList *lpf_trip_list_new_take (GPtrArray *trips);
+
+G_END_DECLS
+
+#endif /* _LPF_TRIP_LIST_H */
@@ -58,8 +58,17 @@ struct _LpfTripPartPrivate {
     LpfStop *end;
     gchar *line;
     GSList *stops;
+    /* attributes and notes, decoded on first use */
+    LpfTripPartAttrsLoader attrs_loader;
+    gpointer attrs_data;
+    GDestroyNotify attrs_destroy;
+    LpfTripPartAttrFlags attr_flags;
+    gchar **attrs; /* interned key value pairs */
+    gchar **notes; /* interned */
 };
 
+static const gchar * const no_notes[] = { NULL };
+
 
 /**
  * lpf_trip_part_get_end
@@ -115,6 +124,187 @@ lpf_trip_part_get_stops(LpfTripPart *self)
 }
 
 
+static void
+free_interned (gchar **strs)
+{
+    gchar **s;
+
+    if (strs == NULL)
+        return;
+    for (s = strs; *s; s++)
+        lpf_str_release (*s);
+    g_free (strs);
+}
+
+
+static gchar**
+dup_interned (const gchar * const *strs)
+{
+    gchar **ret;
+    guint i, n;
+
+    if (strs == NULL || strs[0] == NULL)
+        return NULL;
+
+    n = g_strv_length ((gchar **)strs);
+    ret = g_new (gchar*, n + 1);
+    for (i = 0; i < n; i++)
+        ret[i] = lpf_str_intern (strs[i]);
+    ret[n] = NULL;
+    return ret;
+}
+
+
+static void
+drop_attrs_loader (LpfTripPartPrivate *priv)
+{
+    if (priv->attrs_destroy)
+        priv->attrs_destroy (priv->attrs_data);
+    priv->attrs_loader = NULL;
+    priv->attrs_data = NULL;
+    priv->attrs_destroy = NULL;
+}
+
+
+static LpfTripPartPrivate*
+load_attrs (LpfTripPart *self)
+{
+    LpfTripPartPrivate *priv = GET_PRIVATE(self);
+    LpfTripPartAttrsLoader loader = priv->attrs_loader;
+
+    if (loader) {
+        priv->attrs_loader = NULL;
+        loader (self, priv->attrs_data);
+        drop_attrs_loader (priv);
+    }
+    return priv;
+}
+
+
+/**
+ * lpf_trip_part_get_attr_flags
+ * @self: A #LpfTripPart
+ *
+ * Returns the flags describing the service of this trip part.
+ *
+ * Returns: The #LpfTripPartAttrFlags of a #LpfTripPart.
+ **/
+LpfTripPartAttrFlags
+lpf_trip_part_get_attr_flags(LpfTripPart *self)
+{
+    g_return_val_if_fail (LPF_IS_TRIP_PART (self), LPF_TRIP_PART_ATTR_FLAGS_NONE);
+
+    return load_attrs (self)->attr_flags;
+}
+
+
+/**
+ * lpf_trip_part_get_attr
+ * @self: A #LpfTripPart
+ * @key: The attribute's name like "Operator" or "Direction"
+ *
+ * Returns a provider specific attribute of this trip part.
+ *
+ * Returns: (transfer none) (nullable): The attribute's value.
+ **/
+const gchar*
+lpf_trip_part_get_attr(LpfTripPart *self, const gchar *key)
+{
+    LpfTripPartPrivate *priv;
+    gchar **a;
+
+    g_return_val_if_fail (LPF_IS_TRIP_PART (self), NULL);
+    g_return_val_if_fail (key, NULL);
+
+    priv = load_attrs (self);
+    for (a = priv->attrs; a && a[0] && a[1]; a += 2) {
+        if (!g_strcmp0 (a[0], key))
+            return a[1];
+    }
+    return NULL;
+}
+
+
+/**
+ * lpf_trip_part_get_notes
+ * @self: A #LpfTripPart
+ *
+ * Returns the notes for this trip part like bicycle conveyance
+ * restrictions.
+ *
+ * Returns: (transfer none) (array zero-terminated=1): The notes of a #LpfTripPart.
+ **/
+const gchar* const*
+lpf_trip_part_get_notes(LpfTripPart *self)
+{
+    LpfTripPartPrivate *priv;
+
+    g_return_val_if_fail (LPF_IS_TRIP_PART (self), no_notes);
+
+    priv = load_attrs (self);
+    return priv->notes ? (const gchar * const *)priv->notes : no_notes;
+}
+
+
+/**
+ * lpf_trip_part_set_attrs: (skip)
+ * @self: A #LpfTripPart
+ * @flags: The #LpfTripPartAttrFlags
+ * @attrs: (allow-none): %NULL terminated array of key value pairs
+ * @notes: (allow-none): %NULL terminated array of notes
+ *
+ * Set attributes and notes of a trip part. Only useful for providers.
+ */
+void
+lpf_trip_part_set_attrs (LpfTripPart *self,
+                         LpfTripPartAttrFlags flags,
+                         const gchar * const *attrs,
+                         const gchar * const *notes)
+{
+    LpfTripPartPrivate *priv;
+
+    g_return_if_fail (LPF_IS_TRIP_PART (self));
+
+    priv = GET_PRIVATE(self);
+    if (priv->attrs_loader)
+        drop_attrs_loader (priv);
+
+    free_interned (priv->attrs);
+    free_interned (priv->notes);
+    priv->attr_flags = flags;
+    priv->attrs = dup_interned (attrs);
+    priv->notes = dup_interned (notes);
+}
+
+
+/**
+ * lpf_trip_part_set_attrs_loader: (skip)
+ * @self: A #LpfTripPart
+ * @loader: Function that sets the attributes via lpf_trip_part_set_attrs()
+ * @data: Data passed to @loader
+ * @destroy: (allow-none): Function to free @data
+ *
+ * Defer decoding of attributes and notes until they're asked for the
+ * first time. Only useful for providers.
+ */
+void
+lpf_trip_part_set_attrs_loader (LpfTripPart *self,
+                                LpfTripPartAttrsLoader loader,
+                                gpointer data,
+                                GDestroyNotify destroy)
+{
+    LpfTripPartPrivate *priv;
+
+    g_return_if_fail (LPF_IS_TRIP_PART (self));
+
+    priv = GET_PRIVATE(self);
+    drop_attrs_loader (priv);
+    priv->attrs_loader = loader;
+    priv->attrs_data = data;
+    priv->attrs_destroy = destroy;
+}
+
+
 static void
 lpf_trip_part_set_property (GObject *object,
                       guint property_id,
@@ -138,8 +328,8 @@ lpf_trip_part_set_property (GObject *object,
         break;
 
     case LPF_TRIP_PART_PROP_LINE:
-        g_free (priv->line);
-        priv->line = g_value_dup_string(value);
+        lpf_str_release (priv->line);
+        priv->line = lpf_str_intern (g_value_get_string (value));
         break;
 
     case LPF_TRIP_PART_PROP_STOPS:
@@ -198,7 +388,10 @@ lpf_trip_part_finalize (GObject *object)
     if (priv->end)
         g_object_unref (priv->end);
     g_slist_free_full (priv->stops, g_object_unref);
-    g_free (priv->line);
+    lpf_str_release (priv->line);
+    drop_attrs_loader (priv);
+    free_interned (priv->attrs);
+    free_interned (priv->notes);
 
     parent_class->finalize (object);
 }
@@ -221,7 +414,7 @@ lpf_trip_part_class_init (LpfTripPartClass *klass)
                                                           "Start",
                                                           "The start location and date/time",
                                                           LPF_TYPE_STOP,
-                                                          G_PARAM_CONSTRUCT | G_PARAM_READWRITE));
+                                                          G_PARAM_READWRITE));
 
     g_object_class_install_property (object_class,
                                      LPF_TRIP_PART_PROP_END,
@@ -229,7 +422,7 @@ lpf_trip_part_class_init (LpfTripPartClass *klass)
                                                           "End",
                                                           "The end location and date/time",
                                                           LPF_TYPE_STOP,
-                                                          G_PARAM_CONSTRUCT | G_PARAM_READWRITE));
+                                                          G_PARAM_READWRITE));
 
     g_object_class_install_property (object_class,
                                      LPF_TRIP_PART_PROP_LINE,
@@ -246,10 +439,39 @@ lpf_trip_part_class_init (LpfTripPartClass *klass)
                                      g_param_spec_pointer ("stops",
                                                            "Stops",
                                                            "Stops between start and end",
-                                                           G_PARAM_CONSTRUCT | G_PARAM_READWRITE));
+                                                           G_PARAM_READWRITE));
 }
 
 static void
 lpf_trip_part_init (LpfTripPart *self)
 {
 }
+
+
+/**
+ * lpf_trip_part_new_take:
+ * @start: (transfer full): start of the trip part
+ * @end: (transfer full): end of the trip part
+ * @line: (allow-none): the line operating between @start and @end
+ * @stops: (transfer full) (element-type LpfStop) (allow-none): the stops
+ *   between @start and @end
+ *
+ * Create a trip part taking ownership of the passed in stops.
+ * Providers build lots of trip parts so this skips the property
+ * machinery.
+ *
+ * Returns: (transfer full): a new #LpfTripPart
+ */
+LpfTripPart*
+lpf_trip_part_new_take (LpfStop *start, LpfStop *end, const gchar *line, GSList *stops)
+{
+    LpfTripPart *self = g_object_new (LPF_TYPE_TRIP_PART, NULL);
+    LpfTripPartPrivate *priv = GET_PRIVATE (self);
+
+    priv->start = start;
+    priv->end = end;
+    lpf_str_release (priv->line);
+    priv->line = lpf_str_intern (line);
+    priv->stops = stops;
+    return self;
+}
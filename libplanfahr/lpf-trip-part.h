@@ -31,6 +31,24 @@
 
 G_BEGIN_DECLS
 
+/**
+ * LpfTripPartAttrFlags:
+ * @LPF_TRIP_PART_ATTR_FLAGS_NONE: No flags set.
+ * @LPF_TRIP_PART_ATTR_FLAGS_BICYCLES: Bicycles are conveyed
+ * @LPF_TRIP_PART_ATTR_FLAGS_RESERVATION: Seats or bicycles can or must be reserved
+ * @LPF_TRIP_PART_ATTR_FLAGS_ACCESSIBLE: Boarding aid or wheelchair space available
+ * @LPF_TRIP_PART_ATTR_FLAGS_AIR_CONDITIONING: Vehicle is air conditioned
+ *
+ * Flags describing the service of a #LpfTripPart.
+ */
+typedef enum {
+    LPF_TRIP_PART_ATTR_FLAGS_NONE = 0,
+    LPF_TRIP_PART_ATTR_FLAGS_BICYCLES = (1<<0),
+    LPF_TRIP_PART_ATTR_FLAGS_RESERVATION = (1<<1),
+    LPF_TRIP_PART_ATTR_FLAGS_ACCESSIBLE = (1<<2),
+    LPF_TRIP_PART_ATTR_FLAGS_AIR_CONDITIONING = (1<<3),
+} LpfTripPartAttrFlags;
+
 #define LPF_TYPE_TRIP_PART lpf_trip_part_get_type()
 
 #define LPF_TRIP_PART(obj)                                            \
@@ -56,11 +74,21 @@ typedef struct {
     GObjectClass parent_class;
 } LpfTripPartClass;
 
+typedef void (*LpfTripPartAttrsLoader) (LpfTripPart *self, gpointer data);
+
 GType lpf_trip_part_get_type (void);
 
+LpfTripPart *lpf_trip_part_new_take (LpfStop *start, LpfStop *end, const gchar *line, GSList *stops);
+
 LpfStop* lpf_trip_part_get_start(LpfTripPart *self);
 LpfStop* lpf_trip_part_get_end(LpfTripPart *self);
 GSList* lpf_trip_part_get_stops(LpfTripPart *self);
+LpfTripPartAttrFlags lpf_trip_part_get_attr_flags(LpfTripPart *self);
+const gchar* lpf_trip_part_get_attr(LpfTripPart *self, const gchar *key);
+const gchar* const* lpf_trip_part_get_notes(LpfTripPart *self);
+
+void lpf_trip_part_set_attrs (LpfTripPart *self, LpfTripPartAttrFlags flags, const gchar * const *attrs, const gchar * const *notes);
+void lpf_trip_part_set_attrs_loader (LpfTripPart *self, LpfTripPartAttrsLoader loader, gpointer data, GDestroyNotify destroy);
 
 G_END_DECLS
 
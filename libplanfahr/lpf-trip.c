@@ -37,6 +37,8 @@ enum {
     LPF_TRIP_PROP_0 = 0,
     LPF_TRIP_PROP_PARTS,
     LPF_TRIP_PROP_STATUS,
+    LPF_TRIP_PROP_SERVICE_START,
+    LPF_TRIP_PROP_SERVICE_DAYS,
 };
 
 /**
@@ -55,6 +57,8 @@ typedef struct _LpfTripPrivate LpfTripPrivate;
 struct _LpfTripPrivate {
     GSList *parts;
     LpfTripStatusFlags status;
+    GDateTime *service_start;
+    GBytes *service_days;
 };
 
 /**
@@ -75,6 +79,53 @@ lpf_trip_get_parts(LpfTrip *self)
 }
 
 
+/**
+ * lpf_trip_runs_on:
+ * @self: A #LpfTrip
+ * @date: The date to check
+ *
+ * Check if the trip runs on the given day. Only the date part of
+ * @date is looked at.
+ *
+ * Returns: %TRUE if the trip runs on @date, %FALSE otherwise or if the
+ * provider didn't tell.
+ **/
+gboolean
+lpf_trip_runs_on(LpfTrip *self, GDateTime *date)
+{
+    LpfTripPrivate *priv;
+    const guchar *bits;
+    gsize len;
+    GDate day, start;
+    gint off;
+
+    g_return_val_if_fail (LPF_IS_TRIP (self), FALSE);
+    g_return_val_if_fail (date, FALSE);
+
+    priv = GET_PRIVATE(self);
+    if (priv->service_start == NULL || priv->service_days == NULL)
+        return FALSE;
+
+    g_date_clear (&day, 1);
+    g_date_set_dmy (&day,
+                    g_date_time_get_day_of_month (date),
+                    g_date_time_get_month (date),
+                    g_date_time_get_year (date));
+    g_date_clear (&start, 1);
+    g_date_set_dmy (&start,
+                    g_date_time_get_day_of_month (priv->service_start),
+                    g_date_time_get_month (priv->service_start),
+                    g_date_time_get_year (priv->service_start));
+
+    off = g_date_days_between (&start, &day);
+    bits = g_bytes_get_data (priv->service_days, &len);
+    if (off < 0 || (gsize)off >= len * 8)
+        return FALSE;
+
+    return (bits[off / 8] & (0x80 >> (off % 8))) != 0;
+}
+
+
 static void
 lpf_trip_set_property (GObject *object,
                       guint property_id,
@@ -91,6 +142,16 @@ lpf_trip_set_property (GObject *object,
     case LPF_TRIP_PROP_STATUS:
         priv->status = g_value_get_flags (value);
         break;
+    case LPF_TRIP_PROP_SERVICE_START:
+        if (priv->service_start)
+            g_date_time_unref (priv->service_start);
+        priv->service_start = g_value_dup_boxed (value);
+        break;
+    case LPF_TRIP_PROP_SERVICE_DAYS:
+        if (priv->service_days)
+            g_bytes_unref (priv->service_days);
+        priv->service_days = g_value_dup_boxed (value);
+        break;
     default:
         /* We don't have any other property... */
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
@@ -114,6 +175,12 @@ lpf_trip_get_property (GObject *object,
     case LPF_TRIP_PROP_STATUS:
         g_value_set_flags (value, priv->status);
         break;
+    case LPF_TRIP_PROP_SERVICE_START:
+        g_value_set_boxed (value, priv->service_start);
+        break;
+    case LPF_TRIP_PROP_SERVICE_DAYS:
+        g_value_set_boxed (value, priv->service_days);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -139,6 +206,10 @@ lpf_trip_finalize (GObject *object)
     GObjectClass *parent_class = G_OBJECT_CLASS (lpf_trip_parent_class);
 
     g_slist_free_full (priv->parts, g_object_unref);
+    if (priv->service_start)
+        g_date_time_unref (priv->service_start);
+    if (priv->service_days)
+        g_bytes_unref (priv->service_days);
 
     parent_class->finalize (object);
 }
@@ -167,7 +238,7 @@ lpf_trip_class_init (LpfTripClass *klass)
                                      g_param_spec_pointer ("parts",
                                                            "trip parts",
                                                            "The parts of the trip",
-                                                           G_PARAM_CONSTRUCT | G_PARAM_READWRITE));
+                                                           G_PARAM_READWRITE));
 
 /**
  * LpfTrip:status: (type LpfTripStatusFlags)
@@ -181,7 +252,37 @@ lpf_trip_class_init (LpfTripClass *klass)
                                                          "The statusof the trip",
                                                          LPF_TYPE_TRIP_STATUS_FLAGS,
                                                          LPF_TRIP_STATUS_FLAGS_NONE,
-                                                         G_PARAM_CONSTRUCT |
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+/**
+ * LpfTrip:service-start:
+ *
+ * The first day covered by #LpfTrip:service-days
+ */
+    g_object_class_install_property (object_class,
+                                     LPF_TRIP_PROP_SERVICE_START,
+                                     g_param_spec_boxed ("service-start",
+                                                         "Service start",
+                                                         "First day of the service days",
+                                                         G_TYPE_DATE_TIME,
+                                                         G_PARAM_READWRITE |
+                                                         G_PARAM_STATIC_STRINGS));
+
+/**
+ * LpfTrip:service-days:
+ *
+ * The days this trip runs on as a bitmap. The most significant bit
+ * of the first byte is #LpfTrip:service-start, each following bit is
+ * the next day. Days past the end of the bitmap have no service.
+ * See also lpf_trip_runs_on().
+ */
+    g_object_class_install_property (object_class,
+                                     LPF_TRIP_PROP_SERVICE_DAYS,
+                                     g_param_spec_boxed ("service-days",
+                                                         "Service days",
+                                                         "Days the trip runs on",
+                                                         G_TYPE_BYTES,
                                                          G_PARAM_READWRITE |
                                                          G_PARAM_STATIC_STRINGS));
 }
@@ -190,3 +291,31 @@ static void
 lpf_trip_init (LpfTrip *self)
 {
 }
+
+
+/**
+ * lpf_trip_new_take:
+ * @parts: (transfer full) (element-type LpfTripPart): the parts of the trip
+ * @status: the #LpfTripStatusFlags of the trip
+ * @service_start: (transfer full) (allow-none): first day of @service_days
+ * @service_days: (transfer full) (allow-none): the days the trip runs on
+ *
+ * Create a trip taking ownership of the passed in parts and service
+ * days. Providers build lots of trips so this skips the property
+ * machinery.
+ *
+ * Returns: (transfer full): a new #LpfTrip
+ */
+LpfTrip*
+lpf_trip_new_take (GSList *parts, LpfTripStatusFlags status,
+                   GDateTime *service_start, GBytes *service_days)
+{
+    LpfTrip *self = g_object_new (LPF_TYPE_TRIP, NULL);
+    LpfTripPrivate *priv = GET_PRIVATE (self);
+
+    priv->parts = parts;
+    priv->status = status;
+    priv->service_start = service_start;
+    priv->service_days = service_days;
+    return self;
+}
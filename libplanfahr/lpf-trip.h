@@ -70,7 +70,11 @@ typedef struct {
 
 GType lpf_trip_get_type (void);
 
+LpfTrip *lpf_trip_new_take (GSList *parts, LpfTripStatusFlags status,
+                            GDateTime *service_start, GBytes *service_days);
+
 GSList* lpf_trip_get_parts(LpfTrip *self);
+gboolean lpf_trip_runs_on(LpfTrip *self, GDateTime *date);
 
 G_END_DECLS
 
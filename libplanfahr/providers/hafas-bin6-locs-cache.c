@@ -0,0 +1,398 @@
+/*
+ * hafas-bin6-locs-cache.c: cache for location lookups
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <gio/gio.h>
+
+#include "hafas-bin6-locs-cache.h"
+#include "lpf-loc.h"
+#include "lpf-priv.h"
+
+/* Bump when the layout of the saved cache changes */
+#define LOCS_CACHE_VERSION 1
+#define LOCS_CACHE_TYPE "(ua(suxa(sdds)))"
+
+/* A location as kept in the cache, turned into a LpfLoc on a hit */
+typedef struct _HafasBin6CachedLoc {
+    gchar *name;
+    gdouble lon, lat;
+    gchar *opaque;
+} HafasBin6CachedLoc;
+
+typedef struct _HafasBin6LocsCacheEntry {
+    gchar *key;
+    guint max_results;  /* cap the locations were looked up with, 0 for none */
+    gint64 stamp;       /* real time the entry got added */
+    GArray *locs;       /* of HafasBin6CachedLoc, empty for no result */
+    GList link;         /* in the LRU queue */
+} HafasBin6LocsCacheEntry;
+
+struct _HafasBin6LocsCache {
+    GHashTable *entries;  /* key -> HafasBin6LocsCacheEntry */
+    GQueue lru;           /* most recently used first */
+    guint max_entries;
+    gint64 ttl;           /* in microseconds */
+};
+
+
+static void
+cached_loc_clear (gpointer data)
+{
+    HafasBin6CachedLoc *cached = data;
+
+    g_free (cached->name);
+    g_free (cached->opaque);
+}
+
+
+static HafasBin6LocsCacheEntry*
+entry_new (gchar *key, guint max_results, gint64 stamp)
+{
+    HafasBin6LocsCacheEntry *entry = g_slice_new0 (HafasBin6LocsCacheEntry);
+
+    entry->key = key;
+    entry->max_results = max_results;
+    entry->stamp = stamp;
+    entry->locs = g_array_new (FALSE, FALSE, sizeof (HafasBin6CachedLoc));
+    g_array_set_clear_func (entry->locs, cached_loc_clear);
+    entry->link.data = entry;
+    return entry;
+}
+
+
+static void
+entry_free (gpointer data)
+{
+    HafasBin6LocsCacheEntry *entry = data;
+
+    g_free (entry->key);
+    g_array_free (entry->locs, TRUE);
+    g_slice_free (HafasBin6LocsCacheEntry, entry);
+}
+
+
+static void
+entry_remove (HafasBin6LocsCache *cache, HafasBin6LocsCacheEntry *entry)
+{
+    g_queue_unlink (&cache->lru, &entry->link);
+    g_hash_table_remove (cache->entries, entry->key);
+}
+
+
+/* Add a new entry making room for it if needed */
+static void
+entry_add (HafasBin6LocsCache *cache, HafasBin6LocsCacheEntry *entry, gboolean recent)
+{
+    HafasBin6LocsCacheEntry *old;
+
+    old = g_hash_table_lookup (cache->entries, entry->key);
+    if (old)
+        entry_remove (cache, old);
+
+    if (recent)
+        g_queue_push_head_link (&cache->lru, &entry->link);
+    else
+        g_queue_push_tail_link (&cache->lru, &entry->link);
+    g_hash_table_insert (cache->entries, entry->key, entry);
+
+    while (cache->lru.length > cache->max_entries)
+        entry_remove (cache, cache->lru.tail->data);
+}
+
+
+/*
+ * Matches differing only in case, Unicode normalization or
+ * whitespace give the same locations.
+ */
+static gchar*
+cache_key (const gchar *match, LpfProviderGetLocsFlags types)
+{
+    gchar *norm, *fold, *p;
+    gboolean space = FALSE;
+    GString *key;
+
+    key = g_string_new (NULL);
+    g_string_printf (key, "%u:", types);
+
+    norm = g_utf8_normalize (match, -1, G_NORMALIZE_ALL);
+    if (norm == NULL) {
+        g_string_append (key, match);
+        return g_string_free (key, FALSE);
+    }
+
+    fold = g_utf8_casefold (norm, -1);
+    for (p = g_strstrip (fold); *p; p++) {
+        if (g_ascii_isspace (*p)) {
+            if (!space)
+                g_string_append_c (key, ' ');
+            space = TRUE;
+        } else {
+            g_string_append_c (key, *p);
+            space = FALSE;
+        }
+    }
+
+    g_free (fold);
+    g_free (norm);
+    return g_string_free (key, FALSE);
+}
+
+
+HafasBin6LocsCache*
+hafas_bin6_locs_cache_new (guint max_entries, gint64 ttl)
+{
+    HafasBin6LocsCache *cache = g_slice_new0 (HafasBin6LocsCache);
+
+    cache->entries = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, entry_free);
+    g_queue_init (&cache->lru);
+    cache->max_entries = max_entries;
+    cache->ttl = ttl;
+    return cache;
+}
+
+
+void
+hafas_bin6_locs_cache_free (HafasBin6LocsCache *cache)
+{
+    if (cache == NULL)
+        return;
+
+    g_hash_table_destroy (cache->entries);
+    g_slice_free (HafasBin6LocsCache, cache);
+}
+
+
+void
+hafas_bin6_locs_cache_set_max_entries (HafasBin6LocsCache *cache, guint max_entries)
+{
+    cache->max_entries = max_entries;
+    while (cache->lru.length > cache->max_entries)
+        entry_remove (cache, cache->lru.tail->data);
+}
+
+
+void
+hafas_bin6_locs_cache_set_ttl (HafasBin6LocsCache *cache, gint64 ttl)
+{
+    cache->ttl = ttl;
+}
+
+
+guint
+hafas_bin6_locs_cache_get_size (HafasBin6LocsCache *cache)
+{
+    return cache->lru.length;
+}
+
+
+/*
+ * Look up the locations for @match. On a hit @locs holds new
+ * #LpfLoc objects owned by the caller, %NULL if the lookup had no
+ * result.
+ */
+gboolean
+hafas_bin6_locs_cache_lookup (HafasBin6LocsCache *cache,
+                              const gchar *match,
+                              LpfProviderGetLocsFlags types,
+                              guint max_results,
+                              gint64 now,
+                              GSList **locs)
+{
+    HafasBin6LocsCacheEntry *entry;
+    HafasBin6CachedLoc *cached;
+    LpfLoc *loc;
+    gchar *key;
+    guint i, n;
+
+    g_return_val_if_fail (locs, FALSE);
+    *locs = NULL;
+
+    if (!cache->max_entries)
+        return FALSE;
+
+    key = cache_key (match, types);
+    entry = g_hash_table_lookup (cache->entries, key);
+    g_free (key);
+    if (entry == NULL)
+        return FALSE;
+
+    if (now - entry->stamp > cache->ttl) {
+        entry_remove (cache, entry);
+        return FALSE;
+    }
+
+    /* A capped entry only helps if it has all locations asked for */
+    if (entry->max_results && entry->locs->len >= entry->max_results &&
+        (!max_results || max_results > entry->max_results))
+        return FALSE;
+
+    g_queue_unlink (&cache->lru, &entry->link);
+    g_queue_push_head_link (&cache->lru, &entry->link);
+
+    n = entry->locs->len;
+    if (max_results && max_results < n)
+        n = max_results;
+    for (i = n; i > 0; i--) {
+        cached = &g_array_index (entry->locs, HafasBin6CachedLoc, i - 1);
+        loc = lpf_loc_new_full (cached->name, cached->lon, cached->lat);
+        lpf_loc_set_opaque (loc, g_strdup (cached->opaque));
+        *locs = g_slist_prepend (*locs, loc);
+    }
+
+    LPF_DEBUG ("Cache hit for '%s': %u locations", match, n);
+    return TRUE;
+}
+
+
+/*
+ * Remember @locs as the result of looking up @match with at most
+ * @max_results locations. An empty @locs caches a lookup without
+ * result.
+ */
+void
+hafas_bin6_locs_cache_insert (HafasBin6LocsCache *cache,
+                              const gchar *match,
+                              LpfProviderGetLocsFlags types,
+                              guint max_results,
+                              GSList *locs,
+                              gint64 now)
+{
+    HafasBin6LocsCacheEntry *entry;
+    HafasBin6CachedLoc cached;
+    LpfLoc *loc;
+    GSList *l;
+
+    if (!cache->max_entries)
+        return;
+
+    entry = entry_new (cache_key (match, types), max_results, now);
+    for (l = locs; l; l = g_slist_next (l)) {
+        loc = LPF_LOC (l->data);
+        cached.name = g_strdup (lpf_loc_get_name (loc));
+        cached.lon = lpf_loc_get_long (loc);
+        cached.lat = lpf_loc_get_lat (loc);
+        cached.opaque = g_strdup (lpf_loc_get_opaque (loc));
+        g_array_append_val (entry->locs, cached);
+    }
+    entry_add (cache, entry, TRUE);
+}
+
+
+/* Write out all unexpired entries, most recently used first */
+gboolean
+hafas_bin6_locs_cache_save (HafasBin6LocsCache *cache, const gchar *path, gint64 now, GError **err)
+{
+    HafasBin6LocsCacheEntry *entry;
+    HafasBin6CachedLoc *cached;
+    GVariantBuilder entries, locs;
+    GVariant *v;
+    gboolean ret;
+    GList *l;
+    guint i;
+
+    g_variant_builder_init (&entries, G_VARIANT_TYPE ("a(suxa(sdds))"));
+    for (l = cache->lru.head; l; l = l->next) {
+        entry = l->data;
+        if (now - entry->stamp > cache->ttl)
+            continue;
+
+        g_variant_builder_init (&locs, G_VARIANT_TYPE ("a(sdds)"));
+        for (i = 0; i < entry->locs->len; i++) {
+            cached = &g_array_index (entry->locs, HafasBin6CachedLoc, i);
+            g_variant_builder_add (&locs, "(sdds)",
+                                   cached->name ? cached->name : "",
+                                   cached->lon,
+                                   cached->lat,
+                                   cached->opaque ? cached->opaque : "");
+        }
+        g_variant_builder_add (&entries, "(suxa(sdds))",
+                               entry->key,
+                               entry->max_results,
+                               entry->stamp,
+                               &locs);
+    }
+
+    v = g_variant_ref_sink (g_variant_new (LOCS_CACHE_TYPE, LOCS_CACHE_VERSION, &entries));
+    ret = g_file_set_contents (path,
+                               g_variant_get_data (v),
+                               g_variant_get_size (v),
+                               err);
+    g_variant_unref (v);
+    return ret;
+}
+
+
+/* Add the unexpired entries saved at @path behind the current ones */
+gboolean
+hafas_bin6_locs_cache_load (HafasBin6LocsCache *cache, const gchar *path, gint64 now, GError **err)
+{
+    HafasBin6LocsCacheEntry *entry;
+    HafasBin6CachedLoc cached;
+    GVariantIter *entries, *locs;
+    const gchar *key, *name, *opaque;
+    guint32 version, max_results;
+    gint64 stamp;
+    gchar *contents;
+    gsize len;
+    GVariant *v;
+    GBytes *bytes;
+
+    if (!g_file_get_contents (path, &contents, &len, err))
+        return FALSE;
+
+    bytes = g_bytes_new_take (contents, len);
+    v = g_variant_ref_sink (g_variant_new_from_bytes (G_VARIANT_TYPE (LOCS_CACHE_TYPE), bytes, FALSE));
+    g_bytes_unref (bytes);
+
+    g_variant_get (v, "(ua(suxa(sdds)))", &version, &entries);
+    if (version != LOCS_CACHE_VERSION) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     "Unsupported location cache version %u", version);
+        g_variant_iter_free (entries);
+        g_variant_unref (v);
+        return FALSE;
+    }
+
+    while (g_variant_iter_next (entries, "(&suxa(sdds))", &key, &max_results, &stamp, &locs)) {
+        if (now - stamp > cache->ttl || g_hash_table_contains (cache->entries, key) ||
+            cache->lru.length >= cache->max_entries) {
+            g_variant_iter_free (locs);
+            continue;
+        }
+
+        entry = entry_new (g_strdup (key), max_results, stamp);
+        while (g_variant_iter_next (locs, "(&sdd&s)", &name, &cached.lon, &cached.lat, &opaque)) {
+            cached.name = *name ? g_strdup (name) : NULL;
+            cached.opaque = *opaque ? g_strdup (opaque) : NULL;
+            g_array_append_val (entry->locs, cached);
+        }
+        g_variant_iter_free (locs);
+        entry_add (cache, entry, FALSE);
+    }
+    g_variant_iter_free (entries);
+    g_variant_unref (v);
+
+    LPF_DEBUG ("Loaded %u cached location lookups", cache->lru.length);
+    return TRUE;
+}
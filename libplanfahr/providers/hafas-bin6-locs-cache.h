@@ -0,0 +1,56 @@
+/*
+ * hafas-bin6-locs-cache.h: cache for location lookups
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _HAFAS_BIN6_LOCS_CACHE_H
+#define _HAFAS_BIN6_LOCS_CACHE_H
+
+#include <glib.h>
+
+#include "lpf-provider.h"
+
+G_BEGIN_DECLS
+
+/**
+ * HafasBin6LocsCache:
+ *
+ * A bounded LRU cache mapping match strings to the locations a
+ * provider returned for them. Lookups that had no result are cached
+ * as well. Entries expire after a TTL. Times are passed in
+ * explicitly as returned by g_get_real_time() so entries can be
+ * persisted across runs.
+ */
+typedef struct _HafasBin6LocsCache HafasBin6LocsCache;
+
+HafasBin6LocsCache *hafas_bin6_locs_cache_new (guint max_entries, gint64 ttl);
+void hafas_bin6_locs_cache_free (HafasBin6LocsCache *cache);
+void hafas_bin6_locs_cache_set_max_entries (HafasBin6LocsCache *cache, guint max_entries);
+void hafas_bin6_locs_cache_set_ttl (HafasBin6LocsCache *cache, gint64 ttl);
+guint hafas_bin6_locs_cache_get_size (HafasBin6LocsCache *cache);
+
+gboolean hafas_bin6_locs_cache_lookup (HafasBin6LocsCache *cache, const gchar *match, LpfProviderGetLocsFlags types, guint max_results, gint64 now, GSList **locs);
+void hafas_bin6_locs_cache_insert (HafasBin6LocsCache *cache, const gchar *match, LpfProviderGetLocsFlags types, guint max_results, GSList *locs, gint64 now);
+
+gboolean hafas_bin6_locs_cache_save (HafasBin6LocsCache *cache, const gchar *path, gint64 now, GError **err);
+gboolean hafas_bin6_locs_cache_load (HafasBin6LocsCache *cache, const gchar *path, gint64 now, GError **err);
+
+G_END_DECLS
+#endif /* _HAFAS_BIN6_LOCS_CACHE_H */
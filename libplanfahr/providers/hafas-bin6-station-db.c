@@ -0,0 +1,637 @@
+/*
+ * hafas-bin6-station-db.c: on disk database of stations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <gio/gio.h>
+#include <glib/gstdio.h>
+
+#include "hafas-bin6-station-db.h"
+#include "hafas-bin6-format.h"
+#include "lpf-priv.h"
+
+/*
+ * File layout, in host byte order like the bin6 data it's built from:
+ *
+ *   HafasBin6StationDbHeader
+ *   HafasBin6StationDbRecord[n_stations]  sorted by id
+ *   guint32[n_stations]                   record indices sorted by name
+ *   names                                 NUL terminated UTF-8 strings
+ *
+ * The file is never modified in place. A sync writes a new file and
+ * renames it over the old one so processes that still have the old
+ * one mapped aren't affected. Syncs hold an exclusive lock on a lock
+ * file next to the database so concurrent writers merge rather than
+ * overwrite each other's stations.
+ */
+#define STATION_DB_LOCK_SUFFIX ".lock"
+#define STATION_DB_MAGIC "LPSD"
+/* Bump when the layout of the file changes */
+#define STATION_DB_VERSION 1
+
+typedef struct _HafasBin6StationDbHeader {
+    gchar   magic[4];
+    guint32 version;
+    guint32 n_stations;
+    guint32 names_len;
+} __attribute__ ((packed)) HafasBin6StationDbHeader;
+
+typedef struct _HafasBin6StationDbRecord {
+    guint32 id;
+    guint32 name_off; /* offset in names */
+    gint32  lon;      /* longitude * 10^6 */
+    gint32  lat;      /* latitude * 10^6 */
+} __attribute__ ((packed)) HafasBin6StationDbRecord;
+
+/* A station added since the last sync */
+typedef struct _HafasBin6PendingStation {
+    guint32 id;
+    gchar *name;
+    gint32 lon, lat;
+} HafasBin6PendingStation;
+
+struct _HafasBin6StationDb {
+    gchar *path;
+    GMappedFile *file;                         /* NULL if there's no file yet */
+    const HafasBin6StationDbRecord *records;
+    const guint32 *by_name;
+    const gchar *names;
+    guint32 n_stations;
+    guint32 names_len;
+    GHashTable *pending;                       /* id -> HafasBin6PendingStation */
+    GHashTable *pending_names;                 /* name -> HafasBin6PendingStation */
+};
+
+
+static void
+pending_station_free (gpointer data)
+{
+    HafasBin6PendingStation *station = data;
+
+    g_free (station->name);
+    g_slice_free (HafasBin6PendingStation, station);
+}
+
+
+HafasBin6StationDb*
+hafas_bin6_station_db_new (const gchar *path)
+{
+    HafasBin6StationDb *db = g_slice_new0 (HafasBin6StationDb);
+
+    db->path = g_strdup (path);
+    db->pending = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                         NULL, pending_station_free);
+    db->pending_names = g_hash_table_new (g_str_hash, g_str_equal);
+    return db;
+}
+
+
+void
+hafas_bin6_station_db_free (HafasBin6StationDb *db)
+{
+    if (db == NULL)
+        return;
+
+    g_hash_table_destroy (db->pending_names);
+    g_hash_table_destroy (db->pending);
+    if (db->file)
+        g_mapped_file_unref (db->file);
+    g_free (db->path);
+    g_slice_free (HafasBin6StationDb, db);
+}
+
+
+/* Map the file at path and make sure the tables fit into it */
+static GMappedFile*
+station_db_map (const gchar *path, GError **err)
+{
+    const HafasBin6StationDbHeader *header;
+    GMappedFile *file;
+    const gchar *data;
+    guint64 expected;
+    gsize len;
+
+    if ((file = g_mapped_file_new (path, FALSE, err)) == NULL)
+        return NULL;
+
+    data = g_mapped_file_get_contents (file);
+    len = g_mapped_file_get_length (file);
+    header = (const HafasBin6StationDbHeader*)data;
+
+    if (len < sizeof (HafasBin6StationDbHeader) ||
+        memcmp (header->magic, STATION_DB_MAGIC, sizeof (header->magic))) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     "%s is not a station database", path);
+        goto err;
+    }
+
+    if (header->version != STATION_DB_VERSION) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     "Unsupported station database version %u", header->version);
+        goto err;
+    }
+
+    expected = sizeof (HafasBin6StationDbHeader) +
+        (guint64)header->n_stations * (sizeof (HafasBin6StationDbRecord) + sizeof (guint32)) +
+        header->names_len;
+    /* the last name must be terminated so lookups can't run off the end */
+    if (expected != len || (header->names_len && data[len - 1] != '\0')) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                     "Station database %s is truncated", path);
+        goto err;
+    }
+    return file;
+
+ err:
+    g_mapped_file_unref (file);
+    return NULL;
+}
+
+
+/* Use the tables of the mapped file */
+static void
+station_db_set_file (HafasBin6StationDb *db, GMappedFile *file)
+{
+    const HafasBin6StationDbHeader *header;
+    const gchar *data;
+
+    if (db->file)
+        g_mapped_file_unref (db->file);
+    db->file = file;
+
+    data = g_mapped_file_get_contents (file);
+    header = (const HafasBin6StationDbHeader*)data;
+    db->n_stations = header->n_stations;
+    db->names_len = header->names_len;
+    db->records = (const HafasBin6StationDbRecord*)(data + sizeof (HafasBin6StationDbHeader));
+    db->by_name = (const guint32*)(db->records + db->n_stations);
+    db->names = (const gchar*)(db->by_name + db->n_stations);
+}
+
+
+/**
+ * hafas_bin6_station_db_load:
+ * @db: a #HafasBin6StationDb
+ * @err: a #GError
+ *
+ * Map the database file. A missing file is not an error, the
+ * database is empty then.
+ *
+ * Returns: %TRUE if the database could be mapped
+ */
+gboolean
+hafas_bin6_station_db_load (HafasBin6StationDb *db, GError **err)
+{
+    GMappedFile *file;
+
+    if (!g_file_test (db->path, G_FILE_TEST_EXISTS))
+        return TRUE;
+
+    if ((file = station_db_map (db->path, err)) == NULL)
+        return FALSE;
+
+    station_db_set_file (db, file);
+    LPF_DEBUG ("Mapped %u stations from %s", db->n_stations, db->path);
+    return TRUE;
+}
+
+
+guint
+hafas_bin6_station_db_get_size (HafasBin6StationDb *db)
+{
+    return db->n_stations + g_hash_table_size (db->pending);
+}
+
+
+guint
+hafas_bin6_station_db_get_n_pending (HafasBin6StationDb *db)
+{
+    return g_hash_table_size (db->pending);
+}
+
+
+static const gchar*
+record_name (HafasBin6StationDb *db, const HafasBin6StationDbRecord *record)
+{
+    if (record->name_off >= db->names_len)
+        return NULL;
+    return db->names + record->name_off;
+}
+
+
+static const HafasBin6StationDbRecord*
+find_id (HafasBin6StationDb *db, guint32 id)
+{
+    guint lo = 0, hi = db->n_stations, mid;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (db->records[mid].id < id)
+            lo = mid + 1;
+        else if (db->records[mid].id > id)
+            hi = mid;
+        else
+            return &db->records[mid];
+    }
+    return NULL;
+}
+
+
+static const HafasBin6StationDbRecord*
+find_name (HafasBin6StationDb *db, const gchar *name)
+{
+    const HafasBin6StationDbRecord *record;
+    const gchar *other;
+    guint lo = 0, hi = db->n_stations, mid;
+    gint cmp;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (db->by_name[mid] >= db->n_stations)
+            return NULL;
+        record = &db->records[db->by_name[mid]];
+        if ((other = record_name (db, record)) == NULL)
+            return NULL;
+
+        cmp = strcmp (other, name);
+        if (cmp < 0)
+            lo = mid + 1;
+        else if (cmp > 0)
+            hi = mid;
+        else
+            return record;
+    }
+    return NULL;
+}
+
+
+/**
+ * hafas_bin6_station_db_lookup_id:
+ * @db: a #HafasBin6StationDb
+ * @id: the HAFAS station id
+ * @name: (out) (allow-none): the station's name
+ * @lon: (out) (allow-none): the station's longitude * 10^6
+ * @lat: (out) (allow-none): the station's latitude * 10^6
+ *
+ * Returns: %TRUE if the station is known
+ */
+gboolean
+hafas_bin6_station_db_lookup_id (HafasBin6StationDb *db, guint32 id,
+                                 const gchar **name, gint32 *lon, gint32 *lat)
+{
+    const HafasBin6StationDbRecord *record;
+    HafasBin6PendingStation *station;
+
+    if ((record = find_id (db, id)) != NULL) {
+        if (name && (*name = record_name (db, record)) == NULL)
+            return FALSE;
+        if (lon)
+            *lon = record->lon;
+        if (lat)
+            *lat = record->lat;
+        return TRUE;
+    }
+
+    if ((station = g_hash_table_lookup (db->pending, GUINT_TO_POINTER (id))) != NULL) {
+        if (name)
+            *name = station->name;
+        if (lon)
+            *lon = station->lon;
+        if (lat)
+            *lat = station->lat;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/**
+ * hafas_bin6_station_db_lookup_name:
+ * @db: a #HafasBin6StationDb
+ * @name: the station's name
+ * @id: (out) (allow-none): the HAFAS station id
+ * @lon: (out) (allow-none): the station's longitude * 10^6
+ * @lat: (out) (allow-none): the station's latitude * 10^6
+ *
+ * Look up a station by its exact name.
+ *
+ * Returns: %TRUE if the station is known
+ */
+gboolean
+hafas_bin6_station_db_lookup_name (HafasBin6StationDb *db, const gchar *name,
+                                   guint32 *id, gint32 *lon, gint32 *lat)
+{
+    const HafasBin6StationDbRecord *record;
+    HafasBin6PendingStation *station;
+
+    if ((record = find_name (db, name)) != NULL) {
+        if (id)
+            *id = record->id;
+        if (lon)
+            *lon = record->lon;
+        if (lat)
+            *lat = record->lat;
+        return TRUE;
+    }
+
+    if ((station = g_hash_table_lookup (db->pending_names, name)) != NULL) {
+        if (id)
+            *id = station->id;
+        if (lon)
+            *lon = station->lon;
+        if (lat)
+            *lat = station->lat;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+
+/**
+ * hafas_bin6_station_db_add:
+ * @db: a #HafasBin6StationDb
+ * @id: the HAFAS station id
+ * @name: the station's name
+ * @lon: the station's longitude * 10^6
+ * @lat: the station's latitude * 10^6
+ *
+ * Add a station. It's only written out on the next sync.
+ *
+ * Returns: %TRUE if the station wasn't known yet
+ */
+gboolean
+hafas_bin6_station_db_add (HafasBin6StationDb *db, guint32 id, const gchar *name,
+                           gint32 lon, gint32 lat)
+{
+    HafasBin6PendingStation *station;
+
+    g_return_val_if_fail (name, FALSE);
+
+    if (hafas_bin6_station_db_lookup_id (db, id, NULL, NULL, NULL))
+        return FALSE;
+
+    station = g_slice_new (HafasBin6PendingStation);
+    station->id = id;
+    station->name = g_strdup (name);
+    station->lon = lon;
+    station->lat = lat;
+    g_hash_table_insert (db->pending, GUINT_TO_POINTER (id), station);
+    if (!g_hash_table_contains (db->pending_names, station->name))
+        g_hash_table_insert (db->pending_names, station->name, station);
+    return TRUE;
+}
+
+
+static void
+add_stop (HafasBin6StationDb *db, const HafasBin6StopView *sv)
+{
+    const HafasBin6Station *station = hafas_bin6_stop_view_get_station (sv);
+    gchar *name;
+
+    if (hafas_bin6_station_db_lookup_id (db, station->id, NULL, NULL, NULL))
+        return;
+
+    if ((name = hafas_bin6_stop_view_get_name (sv)) == NULL)
+        return;
+    hafas_bin6_station_db_add (db, station->id, name, station->lon, station->lat);
+    g_free (name);
+}
+
+
+/**
+ * hafas_bin6_station_db_add_view:
+ * @db: a #HafasBin6StationDb
+ * @view: a checked #HafasBin6View
+ *
+ * Add all stations passed by the trips in @view.
+ */
+void
+hafas_bin6_station_db_add_view (HafasBin6StationDb *db, const HafasBin6View *view)
+{
+    HafasBin6TripView trip;
+    HafasBin6PartView part;
+    HafasBin6StopView sv;
+    guint i, j, k;
+
+    for (i = 0; i < view->num_trips; i++) {
+        hafas_bin6_view_get_trip (view, i, &trip);
+        for (j = 0; j < hafas_bin6_trip_view_get_n_parts (&trip); j++) {
+            hafas_bin6_trip_view_get_part (&trip, j, &part);
+            hafas_bin6_part_view_get_start (&part, &sv);
+            add_stop (db, &sv);
+            hafas_bin6_part_view_get_end (&part, &sv);
+            add_stop (db, &sv);
+            for (k = 0; k < hafas_bin6_part_view_get_n_stops (&part); k++) {
+                hafas_bin6_part_view_get_stop (&part, k, &sv);
+                add_stop (db, &sv);
+            }
+        }
+    }
+}
+
+
+/* A station while merging, name points into the old file or a pending station */
+typedef struct _HafasBin6MergeStation {
+    guint32 id;
+    const gchar *name;
+    gint32 lon, lat;
+    guint32 name_off;
+} HafasBin6MergeStation;
+
+
+static gint
+merge_id_cmp (gconstpointer a, gconstpointer b)
+{
+    guint32 x = ((const HafasBin6MergeStation*)a)->id;
+    guint32 y = ((const HafasBin6MergeStation*)b)->id;
+
+    return x < y ? -1 : (x > y);
+}
+
+
+static gint
+merge_name_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const HafasBin6MergeStation *stations = user_data;
+
+    return strcmp (stations[*(const guint32*)a].name, stations[*(const guint32*)b].name);
+}
+
+
+/* Take the lock serializing syncs, returns the locked fd or -1 */
+static gint
+station_db_lock (HafasBin6StationDb *db, GError **err)
+{
+    gchar *lockpath = g_strconcat (db->path, STATION_DB_LOCK_SUFFIX, NULL);
+    gint fd, saved_errno;
+
+    if ((fd = g_open (lockpath, O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0)
+        goto err;
+
+    while (flock (fd, LOCK_EX) < 0) {
+        if (errno != EINTR) {
+            saved_errno = errno;
+            close (fd);
+            errno = saved_errno;
+            goto err;
+        }
+    }
+    g_free (lockpath);
+    return fd;
+
+ err:
+    saved_errno = errno;
+    g_set_error (err, G_IO_ERROR, g_io_error_from_errno (saved_errno),
+                 "Failed to lock %s: %s", lockpath, g_strerror (saved_errno));
+    g_free (lockpath);
+    return -1;
+}
+
+
+/* Merge the pending stations with the file and write it out */
+static gboolean
+station_db_write (HafasBin6StationDb *db, GError **err)
+{
+    HafasBin6StationDbHeader header;
+    HafasBin6StationDbRecord record;
+    HafasBin6PendingStation *pending;
+    HafasBin6MergeStation station, *stations;
+    GMappedFile *current = NULL;
+    GHashTableIter iter;
+    GArray *merged, *by_name;
+    GString *out, *names;
+    gboolean ret = FALSE;
+    guint32 i, n = 0;
+
+    /* merge with what's on disk now rather than what we mapped */
+    if (g_file_test (db->path, G_FILE_TEST_EXISTS)) {
+        if ((current = station_db_map (db->path, err)) == NULL)
+            return FALSE;
+        station_db_set_file (db, current);
+    }
+
+    merged = g_array_sized_new (FALSE, FALSE, sizeof (HafasBin6MergeStation),
+                                db->n_stations + g_hash_table_size (db->pending));
+    for (i = 0; i < db->n_stations; i++) {
+        station.id = db->records[i].id;
+        if ((station.name = record_name (db, &db->records[i])) == NULL)
+            continue;
+        station.lon = db->records[i].lon;
+        station.lat = db->records[i].lat;
+        g_array_append_val (merged, station);
+    }
+    g_hash_table_iter_init (&iter, db->pending);
+    while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&pending)) {
+        if (find_id (db, pending->id))
+            continue;
+        station.id = pending->id;
+        station.name = pending->name;
+        station.lon = pending->lon;
+        station.lat = pending->lat;
+        g_array_append_val (merged, station);
+    }
+    g_array_sort (merged, merge_id_cmp);
+    stations = (HafasBin6MergeStation*)merged->data;
+
+    names = g_string_new (NULL);
+    by_name = g_array_sized_new (FALSE, FALSE, sizeof (guint32), merged->len);
+    for (i = 0; i < merged->len; i++) {
+        stations[i].name_off = names->len;
+        g_string_append_len (names, stations[i].name, strlen (stations[i].name) + 1);
+        g_array_append_val (by_name, i);
+    }
+    g_array_sort_with_data (by_name, merge_name_cmp, stations);
+
+    memcpy (header.magic, STATION_DB_MAGIC, sizeof (header.magic));
+    header.version = STATION_DB_VERSION;
+    header.n_stations = merged->len;
+    header.names_len = names->len;
+
+    out = g_string_sized_new (sizeof (header) +
+                              merged->len * (sizeof (record) + sizeof (guint32)) +
+                              names->len);
+    g_string_append_len (out, (const gchar*)&header, sizeof (header));
+    for (i = 0; i < merged->len; i++) {
+        record.id = stations[i].id;
+        record.name_off = stations[i].name_off;
+        record.lon = stations[i].lon;
+        record.lat = stations[i].lat;
+        g_string_append_len (out, (const gchar*)&record, sizeof (record));
+    }
+    g_string_append_len (out, by_name->data, by_name->len * sizeof (guint32));
+    g_string_append_len (out, names->str, names->len);
+    n = merged->len;
+
+    g_array_free (by_name, TRUE);
+    g_string_free (names, TRUE);
+    g_array_free (merged, TRUE);
+
+    ret = g_file_set_contents (db->path, out->str, out->len, err);
+    g_string_free (out, TRUE);
+    if (!ret)
+        return FALSE;
+
+    /* the pending stations are in the new file now */
+    if ((current = station_db_map (db->path, err)) == NULL)
+        return FALSE;
+    station_db_set_file (db, current);
+    g_hash_table_remove_all (db->pending_names);
+    g_hash_table_remove_all (db->pending);
+
+    LPF_DEBUG ("Wrote %u stations to %s", n, db->path);
+    return TRUE;
+}
+
+
+/**
+ * hafas_bin6_station_db_sync:
+ * @db: a #HafasBin6StationDb
+ * @err: a #GError
+ *
+ * Write out the stations added since the last sync. Stations other
+ * processes have written to the file in the meantime are kept, syncs
+ * of several processes are serialized by a lock file.
+ *
+ * Returns: %TRUE if the file was written
+ */
+gboolean
+hafas_bin6_station_db_sync (HafasBin6StationDb *db, GError **err)
+{
+    gboolean ret;
+    gint fd;
+
+    if (!g_hash_table_size (db->pending))
+        return TRUE;
+
+    if ((fd = station_db_lock (db, err)) < 0)
+        return FALSE;
+
+    ret = station_db_write (db, err);
+    /* closing drops the lock */
+    close (fd);
+    return ret;
+}
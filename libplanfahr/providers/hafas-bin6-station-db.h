@@ -0,0 +1,57 @@
+/*
+ * hafas-bin6-station-db.h: on disk database of stations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _HAFAS_BIN6_STATION_DB_H
+#define _HAFAS_BIN6_STATION_DB_H
+
+#include <glib.h>
+
+#include "hafas-bin6-view.h"
+
+G_BEGIN_DECLS
+
+/**
+ * HafasBin6StationDb:
+ *
+ * The stations seen in trip responses keyed by their HAFAS id. The
+ * database file is memory mapped so lookups only touch the pages
+ * they need and several processes share it through the page
+ * cache. New stations are kept in memory until the next sync.
+ *
+ * Names returned by lookups stay valid until the next sync.
+ */
+typedef struct _HafasBin6StationDb HafasBin6StationDb;
+
+HafasBin6StationDb *hafas_bin6_station_db_new (const gchar *path);
+void hafas_bin6_station_db_free (HafasBin6StationDb *db);
+gboolean hafas_bin6_station_db_load (HafasBin6StationDb *db, GError **err);
+gboolean hafas_bin6_station_db_sync (HafasBin6StationDb *db, GError **err);
+guint hafas_bin6_station_db_get_size (HafasBin6StationDb *db);
+guint hafas_bin6_station_db_get_n_pending (HafasBin6StationDb *db);
+
+gboolean hafas_bin6_station_db_add (HafasBin6StationDb *db, guint32 id, const gchar *name, gint32 lon, gint32 lat);
+void hafas_bin6_station_db_add_view (HafasBin6StationDb *db, const HafasBin6View *view);
+gboolean hafas_bin6_station_db_lookup_id (HafasBin6StationDb *db, guint32 id, const gchar **name, gint32 *lon, gint32 *lat);
+gboolean hafas_bin6_station_db_lookup_name (HafasBin6StationDb *db, const gchar *name, guint32 *id, gint32 *lon, gint32 *lat);
+
+G_END_DECLS
+#endif /* _HAFAS_BIN6_STATION_DB_H */
@@ -0,0 +1,713 @@
+/*
+ * hafas-bin6-station-index.c: search index over known stations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <config.h>
+
+#include <math.h>
+#include <string.h>
+#include <glib-object.h>
+
+#include "hafas-bin6-station-index.h"
+#include "lpf-loc.h"
+#include "lpf-priv.h"
+
+/*
+ * Names are folded to lower case ASCII-ish words. Every word start
+ * of every name goes into a sorted array so a binary search finds
+ * all names with a word starting with the query. For queries with
+ * several words the trigram postings give the candidates that
+ * contain the longest word no matter in which order the words
+ * appear in the name.
+ *
+ * For nearest station queries stations are put into a grid of
+ * cells of HAFAS_BIN6_GRID_CELL microdegrees keyed by the cell's
+ * position. Lookups search rings of cells around the point.
+ */
+
+/* 0.01 degrees, about 1.1km north-south */
+#define HAFAS_BIN6_GRID_CELL 10000
+#define HAFAS_BIN6_GRID_COLS (360 * 1000000 / HAFAS_BIN6_GRID_CELL)
+#define HAFAS_BIN6_GRID_ROWS (180 * 1000000 / HAFAS_BIN6_GRID_CELL)
+/* rings searched before falling back to checking all stations */
+#define HAFAS_BIN6_GRID_MAX_RINGS 32
+/* meters per degree latitude */
+#define HAFAS_BIN6_METERS_PER_DEG 111195.0
+
+typedef struct _HafasBin6IndexedStation {
+    guint id;
+    gchar *name;
+    gchar *folded;
+    gdouble lon, lat;
+    gboolean located;   /* whether lon and lat are known */
+    gchar *opaque;      /* might be NULL for stations only seen in trips */
+} HafasBin6IndexedStation;
+
+/* A word start in a folded name, the rest of the name follows */
+typedef struct _HafasBin6IndexWord {
+    const gchar *suffix;
+    guint id;
+} HafasBin6IndexWord;
+
+/* A candidate of a lookup */
+typedef struct _HafasBin6IndexHit {
+    guint id;
+    guint score;        /* lower is better */
+} HafasBin6IndexHit;
+
+/* A candidate of a nearest station lookup */
+typedef struct _HafasBin6NearHit {
+    guint id;
+    gdouble dist;       /* in meters */
+} HafasBin6NearHit;
+
+struct _HafasBin6StationIndex {
+    GPtrArray *stations;    /* of HafasBin6IndexedStation, the id is the index */
+    GHashTable *by_name;    /* name -> HafasBin6IndexedStation */
+    GArray *words;          /* of HafasBin6IndexWord */
+    gboolean sorted;        /* whether words is sorted */
+    GHashTable *trigrams;   /* trigram -> GArray of ascending ids */
+    GHashTable *grid;       /* cell -> GArray of ids */
+    guint n_located;
+    guint max_stations;
+};
+
+#define TRIGRAM(s) GUINT_TO_POINTER (((guchar)(s)[0] << 16) | ((guchar)(s)[1] << 8) | (guchar)(s)[2])
+#define GRID_CELL(col, row) GUINT_TO_POINTER (((col) << 16) | (row))
+
+
+static void
+indexed_station_free (gpointer data)
+{
+    HafasBin6IndexedStation *station = data;
+
+    g_free (station->name);
+    g_free (station->folded);
+    g_free (station->opaque);
+    g_slice_free (HafasBin6IndexedStation, station);
+}
+
+
+static void
+postings_free (gpointer data)
+{
+    g_array_free (data, TRUE);
+}
+
+
+/**
+ * hafas_bin6_station_index_fold:
+ * @str: a UTF-8 string
+ *
+ * Fold @str for matching: diacritics are dropped, case is folded
+ * and everything that isn't a letter or digit separates words.
+ *
+ * Returns: the folded string or %NULL if @str isn't valid UTF-8
+ */
+gchar*
+hafas_bin6_station_index_fold (const gchar *str)
+{
+    gchar *nfd, *fold, *p;
+    gboolean space = TRUE;
+    GString *out;
+    gunichar c;
+
+    nfd = g_utf8_normalize (str, -1, G_NORMALIZE_NFD);
+    if (nfd == NULL)
+        return NULL;
+    fold = g_utf8_casefold (nfd, -1);
+    g_free (nfd);
+
+    out = g_string_sized_new (strlen (fold));
+    for (p = fold; *p; p = g_utf8_next_char (p)) {
+        c = g_utf8_get_char (p);
+        if (g_unichar_ismark (c))
+            continue;
+        if (!g_unichar_isalnum (c)) {
+            if (!space)
+                g_string_append_c (out, ' ');
+            space = TRUE;
+            continue;
+        }
+        g_string_append_unichar (out, c);
+        space = FALSE;
+    }
+    if (out->len && out->str[out->len - 1] == ' ')
+        g_string_truncate (out, out->len - 1);
+
+    g_free (fold);
+    return g_string_free (out, FALSE);
+}
+
+
+HafasBin6StationIndex*
+hafas_bin6_station_index_new (guint max_stations)
+{
+    HafasBin6StationIndex *index = g_slice_new0 (HafasBin6StationIndex);
+
+    index->stations = g_ptr_array_new_with_free_func (indexed_station_free);
+    index->by_name = g_hash_table_new (g_str_hash, g_str_equal);
+    index->words = g_array_new (FALSE, FALSE, sizeof (HafasBin6IndexWord));
+    index->sorted = TRUE;
+    index->trigrams = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                             NULL, postings_free);
+    index->grid = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                         NULL, postings_free);
+    index->max_stations = max_stations;
+    return index;
+}
+
+
+void
+hafas_bin6_station_index_free (HafasBin6StationIndex *index)
+{
+    if (index == NULL)
+        return;
+
+    g_hash_table_destroy (index->grid);
+    g_hash_table_destroy (index->trigrams);
+    g_array_free (index->words, TRUE);
+    g_hash_table_destroy (index->by_name);
+    g_ptr_array_free (index->stations, TRUE);
+    g_slice_free (HafasBin6StationIndex, index);
+}
+
+
+guint
+hafas_bin6_station_index_get_size (HafasBin6StationIndex *index)
+{
+    return index->stations->len;
+}
+
+
+static void
+add_trigrams (HafasBin6StationIndex *index, const gchar *folded, guint id)
+{
+    GArray *postings;
+    gsize i, len = strlen (folded);
+
+    for (i = 0; i + 3 <= len; i++) {
+        if (memchr (folded + i, ' ', 3))
+            continue;
+
+        postings = g_hash_table_lookup (index->trigrams, TRIGRAM (folded + i));
+        if (postings == NULL) {
+            postings = g_array_new (FALSE, FALSE, sizeof (guint));
+            g_hash_table_insert (index->trigrams, TRIGRAM (folded + i), postings);
+        }
+        /* ids only ever grow so this keeps the postings sorted and unique */
+        if (!postings->len || g_array_index (postings, guint, postings->len - 1) != id)
+            g_array_append_val (postings, id);
+    }
+}
+
+
+/* Grid column and row of a position in degrees */
+static void
+grid_cell (gdouble lon, gdouble lat, gint *col, gint *row)
+{
+    /* fixed point like HafasBin6Station */
+    gint32 x = (gint32)floor (lon * 1000000.0 + 0.5);
+    gint32 y = (gint32)floor (lat * 1000000.0 + 0.5);
+
+    *col = CLAMP ((x + 180 * 1000000) / HAFAS_BIN6_GRID_CELL, 0, HAFAS_BIN6_GRID_COLS - 1);
+    *row = CLAMP ((y + 90 * 1000000) / HAFAS_BIN6_GRID_CELL, 0, HAFAS_BIN6_GRID_ROWS - 1);
+}
+
+
+static void
+add_to_grid (HafasBin6StationIndex *index, HafasBin6IndexedStation *station)
+{
+    GArray *cell;
+    gint col, row;
+
+    /* Unknown positions come as 0/0 */
+    if (station->lon == 0.0 && station->lat == 0.0)
+        return;
+
+    grid_cell (station->lon, station->lat, &col, &row);
+    cell = g_hash_table_lookup (index->grid, GRID_CELL (col, row));
+    if (cell == NULL) {
+        cell = g_array_new (FALSE, FALSE, sizeof (guint));
+        g_hash_table_insert (index->grid, GRID_CELL (col, row), cell);
+    }
+    g_array_append_val (cell, station->id);
+    station->located = TRUE;
+    index->n_located++;
+}
+
+
+/*
+ * Add a station. A station already known by name only gets its
+ * opaque data and position filled in if they were missing.
+ */
+void
+hafas_bin6_station_index_add (HafasBin6StationIndex *index,
+                              const gchar *name,
+                              gdouble lon,
+                              gdouble lat,
+                              const gchar *opaque)
+{
+    HafasBin6IndexedStation *station;
+    HafasBin6IndexWord word;
+    const gchar *p;
+    gchar *folded;
+
+    if (name == NULL)
+        return;
+
+    station = g_hash_table_lookup (index->by_name, name);
+    if (station) {
+        if (opaque && !station->opaque)
+            station->opaque = g_strdup (opaque);
+        if (!station->located) {
+            station->lon = lon;
+            station->lat = lat;
+            add_to_grid (index, station);
+        }
+        return;
+    }
+
+    if (index->stations->len >= index->max_stations)
+        return;
+
+    folded = hafas_bin6_station_index_fold (name);
+    if (folded == NULL || *folded == '\0') {
+        g_free (folded);
+        return;
+    }
+
+    station = g_slice_new0 (HafasBin6IndexedStation);
+    station->id = index->stations->len;
+    station->name = g_strdup (name);
+    station->folded = folded;
+    station->lon = lon;
+    station->lat = lat;
+    station->opaque = g_strdup (opaque);
+
+    word.id = station->id;
+    g_ptr_array_add (index->stations, station);
+    g_hash_table_insert (index->by_name, station->name, station);
+
+    for (p = folded; *p; p++) {
+        if (p == folded || p[-1] == ' ') {
+            word.suffix = p;
+            g_array_append_val (index->words, word);
+        }
+    }
+    index->sorted = FALSE;
+
+    add_trigrams (index, folded, word.id);
+    add_to_grid (index, station);
+}
+
+
+void
+hafas_bin6_station_index_add_locs (HafasBin6StationIndex *index, GSList *locs)
+{
+    LpfLoc *loc;
+    GSList *l;
+
+    for (l = locs; l; l = g_slist_next (l)) {
+        loc = LPF_LOC (l->data);
+        hafas_bin6_station_index_add (index,
+                                      lpf_loc_get_name (loc),
+                                      lpf_loc_get_long (loc),
+                                      lpf_loc_get_lat (loc),
+                                      lpf_loc_get_opaque (loc));
+    }
+}
+
+
+static gint
+word_cmp (gconstpointer a, gconstpointer b)
+{
+    return strcmp (((const HafasBin6IndexWord*)a)->suffix,
+                   ((const HafasBin6IndexWord*)b)->suffix);
+}
+
+
+/* Ids of all stations with a word starting with prefix */
+static void
+collect_prefix (HafasBin6StationIndex *index, const gchar *prefix, GHashTable *ids)
+{
+    HafasBin6IndexWord *words;
+    gsize len = strlen (prefix);
+    guint lo = 0, hi, mid;
+
+    if (!index->sorted) {
+        g_array_sort (index->words, word_cmp);
+        index->sorted = TRUE;
+    }
+
+    words = (HafasBin6IndexWord*)index->words->data;
+    hi = index->words->len;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (strcmp (words[mid].suffix, prefix) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    for (; lo < index->words->len && !strncmp (words[lo].suffix, prefix, len); lo++)
+        g_hash_table_add (ids, GUINT_TO_POINTER (words[lo].id + 1));
+}
+
+
+/* Ids of all stations containing all trigrams of word */
+static void
+collect_trigrams (HafasBin6StationIndex *index, const gchar *word, GHashTable *ids)
+{
+    GArray *postings, *result = NULL;
+    gsize i, len = strlen (word);
+    guint a, b, n;
+
+    for (i = 0; i + 3 <= len; i++) {
+        postings = g_hash_table_lookup (index->trigrams, TRIGRAM (word + i));
+        if (postings == NULL)
+            goto out;
+
+        if (result == NULL) {
+            result = g_array_sized_new (FALSE, FALSE, sizeof (guint), postings->len);
+            g_array_append_vals (result, postings->data, postings->len);
+            continue;
+        }
+
+        /* intersect the sorted lists in place */
+        for (a = b = n = 0; a < result->len && b < postings->len;) {
+            guint x = g_array_index (result, guint, a), y = g_array_index (postings, guint, b);
+
+            if (x < y)
+                a++;
+            else if (x > y)
+                b++;
+            else {
+                g_array_index (result, guint, n++) = x;
+                a++;
+                b++;
+            }
+        }
+        g_array_set_size (result, n);
+    }
+
+    for (i = 0; result && i < result->len; i++)
+        g_hash_table_add (ids, GUINT_TO_POINTER (g_array_index (result, guint, i) + 1));
+ out:
+    if (result)
+        g_array_free (result, TRUE);
+}
+
+
+/* Whether a word of folded starts with prefix */
+static gboolean
+has_word_prefix (const gchar *folded, const gchar *prefix)
+{
+    gsize len = strlen (prefix);
+    const gchar *p;
+
+    for (p = folded; p; p = strchr (p, ' ')) {
+        if (*p == ' ')
+            p++;
+        if (!strncmp (p, prefix, len))
+            return TRUE;
+    }
+    return FALSE;
+}
+
+
+static gint
+hit_cmp (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+    const HafasBin6IndexHit *x = a, *y = b;
+    GPtrArray *stations = user_data;
+    gsize lx, ly;
+
+    if (x->score != y->score)
+        return x->score < y->score ? -1 : 1;
+
+    lx = strlen (((HafasBin6IndexedStation*)g_ptr_array_index (stations, x->id))->folded);
+    ly = strlen (((HafasBin6IndexedStation*)g_ptr_array_index (stations, y->id))->folded);
+    if (lx != ly)
+        return lx < ly ? -1 : 1;
+    return x->id < y->id ? -1 : (x->id > y->id);
+}
+
+
+static LpfLoc*
+station_to_loc (HafasBin6IndexedStation *station)
+{
+    LpfLoc *loc;
+
+    loc = lpf_loc_new_full (station->name, station->lon, station->lat);
+    lpf_loc_set_opaque (loc, g_strdup (station->opaque));
+    return loc;
+}
+
+
+/**
+ * hafas_bin6_station_index_lookup:
+ * @index: a #HafasBin6StationIndex
+ * @match: the string to match
+ * @max_results: maximum number of locations to return, 0 for no limit
+ * @locs: (out): the best matching locations, owned by the caller
+ *
+ * Find the known stations that have a word starting with each word
+ * of @match. Only stations with opaque data are returned since
+ * others can't be used for trip queries. Exact matches come first,
+ * then names starting with @match, then the rest.
+ *
+ * Returns: %TRUE if @locs can stand in for asking the provider
+ * which is only the case if all @max_results locations match
+ * exactly. Prefix matches are returned in @locs but need to be
+ * refined by the provider.
+ */
+gboolean
+hafas_bin6_station_index_lookup (HafasBin6StationIndex *index,
+                                 const gchar *match,
+                                 guint max_results,
+                                 GSList **locs)
+{
+    HafasBin6IndexedStation *station;
+    HafasBin6IndexHit hit;
+    GHashTable *ids;
+    GHashTableIter iter;
+    GArray *hits;
+    gchar *folded, **words, *longest;
+    gpointer key;
+    guint i, w, n;
+    gboolean exact;
+
+    g_return_val_if_fail (locs, FALSE);
+    *locs = NULL;
+
+    folded = hafas_bin6_station_index_fold (match);
+    if (folded == NULL || strlen (folded) < 2 || !index->stations->len) {
+        g_free (folded);
+        return FALSE;
+    }
+
+    words = g_strsplit (folded, " ", -1);
+    longest = words[0];
+    for (w = 1; words[w]; w++) {
+        if (strlen (words[w]) > strlen (longest))
+            longest = words[w];
+    }
+
+    ids = g_hash_table_new (g_direct_hash, g_direct_equal);
+    if (words[1] == NULL)
+        collect_prefix (index, folded, ids);
+    else if (strlen (longest) >= 3)
+        collect_trigrams (index, longest, ids);
+    else
+        collect_prefix (index, words[0], ids);
+
+    hits = g_array_new (FALSE, FALSE, sizeof (HafasBin6IndexHit));
+    g_hash_table_iter_init (&iter, ids);
+    while (g_hash_table_iter_next (&iter, &key, NULL)) {
+        hit.id = GPOINTER_TO_UINT (key) - 1;
+        station = g_ptr_array_index (index->stations, hit.id);
+        if (station->opaque == NULL)
+            continue;
+
+        for (w = 0; words[w]; w++) {
+            if (!has_word_prefix (station->folded, words[w]))
+                break;
+        }
+        if (words[w])
+            continue;
+
+        if (!strcmp (station->folded, folded))
+            hit.score = 0;
+        else if (g_str_has_prefix (station->folded, folded))
+            hit.score = 1;
+        else
+            hit.score = 2;
+        g_array_append_val (hits, hit);
+    }
+    g_array_sort_with_data (hits, hit_cmp, index->stations);
+
+    n = hits->len;
+    if (max_results && max_results < n)
+        n = max_results;
+    for (i = n; i > 0; i--) {
+        station = g_ptr_array_index (index->stations,
+                                     g_array_index (hits, HafasBin6IndexHit, i - 1).id);
+        *locs = g_slist_prepend (*locs, station_to_loc (station));
+    }
+
+    /* Hits are sorted by score so the last one tells */
+    exact = max_results && n >= max_results &&
+        g_array_index (hits, HafasBin6IndexHit, n - 1).score == 0;
+
+    LPF_DEBUG ("%u of %u known stations match '%s'", hits->len, index->stations->len, match);
+
+    g_array_free (hits, TRUE);
+    g_hash_table_destroy (ids);
+    g_strfreev (words);
+    g_free (folded);
+    return exact;
+}
+
+
+/* Distance in meters, good enough for the short distances we care about */
+static gdouble
+distance (gdouble lon1, gdouble lat1, gdouble lon2, gdouble lat2)
+{
+    gdouble dx = (lon2 - lon1) * cos ((lat1 + lat2) / 2.0 * G_PI / 180.0);
+    gdouble dy = lat2 - lat1;
+
+    return sqrt (dx * dx + dy * dy) * HAFAS_BIN6_METERS_PER_DEG;
+}
+
+
+static void
+check_near (HafasBin6StationIndex *index, guint id, gdouble lon, gdouble lat,
+            guint radius, GArray *hits)
+{
+    HafasBin6IndexedStation *station = g_ptr_array_index (index->stations, id);
+    HafasBin6NearHit hit;
+
+    if (station->opaque == NULL)
+        return;
+
+    hit.id = id;
+    hit.dist = distance (lon, lat, station->lon, station->lat);
+    if (radius && hit.dist > radius)
+        return;
+    g_array_append_val (hits, hit);
+}
+
+
+/* Check the stations in the cell, returns the number of stations in it */
+static guint
+check_near_cell (HafasBin6StationIndex *index, gint col, gint row,
+                 gdouble lon, gdouble lat, guint radius, GArray *hits)
+{
+    GArray *cell;
+    guint i;
+
+    if (col < 0 || col >= HAFAS_BIN6_GRID_COLS || row < 0 || row >= HAFAS_BIN6_GRID_ROWS)
+        return 0;
+
+    cell = g_hash_table_lookup (index->grid, GRID_CELL (col, row));
+    if (cell == NULL)
+        return 0;
+
+    for (i = 0; i < cell->len; i++)
+        check_near (index, g_array_index (cell, guint, i), lon, lat, radius, hits);
+    return cell->len;
+}
+
+
+static gint
+near_hit_cmp (gconstpointer a, gconstpointer b)
+{
+    const HafasBin6NearHit *x = a, *y = b;
+
+    if (x->dist != y->dist)
+        return x->dist < y->dist ? -1 : 1;
+    return x->id < y->id ? -1 : (x->id > y->id);
+}
+
+
+/**
+ * hafas_bin6_station_index_nearest:
+ * @index: a #HafasBin6StationIndex
+ * @lon: longitude of the point
+ * @lat: latitude of the point
+ * @radius: only return stations within this many meters, 0 for no limit
+ * @max_results: maximum number of locations to return, 0 for no limit
+ *
+ * Find the known stations closest to a point. Like with
+ * hafas_bin6_station_index_lookup() only stations with opaque
+ * data are returned.
+ *
+ * Returns: (transfer full): the stations ordered by distance
+ */
+GSList*
+hafas_bin6_station_index_nearest (HafasBin6StationIndex *index,
+                                  gdouble lon,
+                                  gdouble lat,
+                                  guint radius,
+                                  guint max_results)
+{
+    HafasBin6NearHit *hits_data;
+    GArray *hits;
+    GSList *locs = NULL;
+    gdouble step, reach;
+    guint i, n, seen = 0;
+    gint col, row, r, c, w;
+
+    g_return_val_if_fail (radius || max_results, NULL);
+
+    grid_cell (lon, lat, &col, &row);
+    /* the narrower side of a cell in meters */
+    step = HAFAS_BIN6_GRID_CELL / 1000000.0 * HAFAS_BIN6_METERS_PER_DEG;
+    step *= MIN (1.0, cos (lat * G_PI / 180.0));
+
+    hits = g_array_new (FALSE, FALSE, sizeof (HafasBin6NearHit));
+    for (r = 0; seen < index->n_located; r++) {
+        if (r > HAFAS_BIN6_GRID_MAX_RINGS) {
+            /* few stations around, checking them all is cheaper */
+            g_array_set_size (hits, 0);
+            for (i = 0; i < index->stations->len; i++) {
+                if (((HafasBin6IndexedStation*)g_ptr_array_index (index->stations, i))->located)
+                    check_near (index, i, lon, lat, radius, hits);
+            }
+            break;
+        }
+
+        /* top and bottom row of the ring, then the columns in between */
+        for (c = col - r; c <= col + r; c++) {
+            seen += check_near_cell (index, c, row - r, lon, lat, radius, hits);
+            if (r)
+                seen += check_near_cell (index, c, row + r, lon, lat, radius, hits);
+        }
+        for (w = row - r + 1; w < row + r; w++) {
+            seen += check_near_cell (index, col - r, w, lon, lat, radius, hits);
+            seen += check_near_cell (index, col + r, w, lon, lat, radius, hits);
+        }
+
+        /* all stations outside of the searched rings are at least this far away */
+        reach = r * step;
+        if (radius && reach >= radius)
+            break;
+        if (max_results && hits->len >= max_results) {
+            g_array_sort (hits, near_hit_cmp);
+            if (g_array_index (hits, HafasBin6NearHit, max_results - 1).dist <= reach)
+                break;
+        }
+    }
+    g_array_sort (hits, near_hit_cmp);
+
+    n = hits->len;
+    if (max_results && max_results < n)
+        n = max_results;
+    hits_data = (HafasBin6NearHit*)hits->data;
+    for (i = n; i > 0; i--)
+        locs = g_slist_prepend (locs, station_to_loc (g_ptr_array_index (index->stations,
+                                                                         hits_data[i - 1].id)));
+
+    LPF_DEBUG ("%u known stations near %f/%f, searched %d rings", hits->len, lon, lat, r);
+    g_array_free (hits, TRUE);
+    return locs;
+}
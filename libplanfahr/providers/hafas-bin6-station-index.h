@@ -0,0 +1,51 @@
+/*
+ * hafas-bin6-station-index.h: search index over known stations
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _HAFAS_BIN6_STATION_INDEX_H
+#define _HAFAS_BIN6_STATION_INDEX_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * HafasBin6StationIndex:
+ *
+ * Index over the stations seen in location and trip responses so
+ * type-ahead lookups can be answered without a request. Names are
+ * matched case and diacritic insensitive by word prefixes. Stations
+ * with a known position can also be looked up by distance.
+ */
+typedef struct _HafasBin6StationIndex HafasBin6StationIndex;
+
+HafasBin6StationIndex *hafas_bin6_station_index_new (guint max_stations);
+void hafas_bin6_station_index_free (HafasBin6StationIndex *index);
+guint hafas_bin6_station_index_get_size (HafasBin6StationIndex *index);
+void hafas_bin6_station_index_add (HafasBin6StationIndex *index, const gchar *name, gdouble lon, gdouble lat, const gchar *opaque);
+void hafas_bin6_station_index_add_locs (HafasBin6StationIndex *index, GSList *locs);
+gboolean hafas_bin6_station_index_lookup (HafasBin6StationIndex *index, const gchar *match, guint max_results, GSList **locs);
+GSList *hafas_bin6_station_index_nearest (HafasBin6StationIndex *index, gdouble lon, gdouble lat, guint radius, guint max_results);
+
+gchar *hafas_bin6_station_index_fold (const gchar *str);
+
+G_END_DECLS
+#endif /* _HAFAS_BIN6_STATION_INDEX_H */
@@ -0,0 +1,1096 @@
+/*
+ * hafas-bin6-view.c: read-only cursors into hafas binary format version 6 data
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <config.h>
+
+#include <string.h>
+#include <glib.h>
+
+#include "hafas-bin6.h"
+#include "hafas-bin6-view.h"
+#include "lpf-priv.h"
+#include "lpf-provider.h"
+#include "lpf-stop.h"
+
+/*
+ * The cursors only do pointer arithmetic on the decompressed
+ * buffer. Strings are converted and dates calculated when asked for.
+ */
+
+/* Whether the string at off in the strings table is complete */
+static gboolean
+str_available (const gchar *data, gsize len, guint16 off)
+{
+    guint64 start = (guint64)HAFAS_BIN6_HEADER(data)->strings_tbl + off;
+
+    if (start >= len)
+        return FALSE;
+    return memchr (data + start, '\0', len - start) != NULL;
+}
+
+#ifdef ENABLE_DEBUG
+static const gchar*
+debug_str (const gchar *data, gsize len, guint16 off)
+{
+    return str_available (data, len, off) ? HAFAS_BIN6_STR(data, off) : "<truncated>";
+}
+#endif
+
+/* Offset of a table base into the view's data */
+#define VIEW_OFF(view, base) ((guint64)((base) - (view)->data))
+
+/* The attribute and comment tables usually come last so in a partial
+ * view they're only resolved once they're within it */
+static void
+resolve_extras (HafasBin6View *view)
+{
+    if (view->attrs_tbl && view->attrs_tbl < view->len)
+        view->attrs = view->data + view->attrs_tbl;
+    if (view->comments_tbl && view->comments_tbl < view->len)
+        view->comments = view->data + view->comments_tbl;
+}
+
+/* Whether size bytes at off are within the view */
+static gboolean
+in_view (const HafasBin6View *view, guint64 off, guint64 size)
+{
+    return off + size <= view->len;
+}
+
+static gboolean
+station_available (const HafasBin6View *view, guint16 idx)
+{
+    guint64 off = VIEW_OFF(view, view->stations) + (guint64)idx * sizeof (HafasBin6Station);
+
+    if (!in_view (view, off, sizeof (HafasBin6Station)))
+        return FALSE;
+    return str_available (view->data, view->len,
+                          ((const HafasBin6Station*)(view->data + off))->name_off);
+}
+
+/**
+ * hafas_bin6_view_init:
+ * @view: the #HafasBin6View to initialize
+ * @data: decompressed hafas binary data
+ * @len: length of @data
+ * @err: #GError
+ *
+ * Check the headers of @data and set up @view to access the trips.
+ * Table bases are resolved once here. Use #hafas_bin6_view_check or
+ * #hafas_bin6_view_trip_available before accessing any trip.
+ *
+ * Returns: %TRUE if @data can be accessed via @view
+ */
+gboolean
+hafas_bin6_view_init (HafasBin6View *view, const gchar *data, gsize len, GError **err)
+{
+    const HafasBin6Header *header;
+    const HafasBin6ExtHeader *ext;
+    const HafasBin6TripDetailsHeader *details;
+    guint16 version;
+
+    g_return_val_if_fail (view, FALSE);
+    g_return_val_if_fail (data, FALSE);
+    g_return_val_if_fail (len, FALSE);
+
+    memset (view, 0, sizeof (HafasBin6View));
+
+    if (len < sizeof (HafasBin6Header)) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Hafas blob too short: %" G_GSIZE_FORMAT " bytes", len);
+        return FALSE;
+    }
+
+    version = *(guint16*)data;
+    if (version != 6) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Incorrect Hafas Binary version %d", version);
+        return FALSE;
+    }
+
+    header = HAFAS_BIN6_HEADER(data);
+    LPF_DEBUG("%d Trips from '%s' to '%s'",
+              header->num_trips,
+              debug_str (data, len, HAFAS_BIN6_START(data)->name_off),
+              debug_str (data, len, HAFAS_BIN6_END(data)->name_off));
+
+    if (sizeof (HafasBin6Header) +
+        sizeof (HafasBin6Trip) * header->num_trips >= len ||
+        (guint64)header->ext + sizeof (HafasBin6ExtHeader) >= len) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Truncated Hafas blob");
+        return FALSE;
+    }
+
+    ext = HAFAS_BIN6_EXT_HEADER(data);
+    /* We might not have attrs_index0 */
+    if (ext->length < sizeof (HafasBin6ExtHeader)) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Ext header too short: %d", ext->length);
+        return FALSE;
+    }
+
+    LPF_DEBUG("Ext length:       0x%.4x", ext->length);
+    LPF_DEBUG("Errors:           0x%.4x", ext->err);
+    LPF_DEBUG("Sequence:         0x%.4x", ext->seq);
+    LPF_DEBUG("Detail table:     0x%.4x", ext->details_tbl);
+    LPF_DEBUG("Encoding: %s", debug_str (data, len, ext->enc_off));
+    LPF_DEBUG("Request Id: %s", debug_str (data, len, ext->req_id_off));
+
+    if (ext->err) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Hafas Blob has error code %d", ext->err);
+        return FALSE;
+    }
+
+    if (ext->seq <= 0) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Illegal sequence number %d", ext->seq);
+        return FALSE;
+    }
+
+    if ((guint64)ext->details_tbl + sizeof (HafasBin6TripDetailsHeader) >= len ||
+        !str_available (data, len, ext->enc_off)) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Truncated Hafas blob");
+        return FALSE;
+    }
+
+    details = HAFAS_BIN6_TRIP_DETAILS_HEADER(data);
+    LPF_DEBUG("Trip detail version: %d", details->version);
+    if (details->version != 1 ||
+        details->stop_size != sizeof (HafasBin6TripStop) ||
+        details->part_detail_size != sizeof (HafasBin6TripPartDetail)) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Unsupported trip details version %d", details->version);
+        return FALSE;
+    }
+
+    view->data = data;
+    view->len = len;
+    view->enc = HAFAS_BIN6_STR(data, ext->enc_off);
+    view->charset = hafas_bin6_charset_from_name (view->enc);
+    view->num_trips = header->num_trips;
+    view->days = header->days;
+
+    view->trips = _HAFAS_BIN6_TRIPS_TABLE(data);
+    view->service = data + header->service_tbl;
+    view->strings = data + header->strings_tbl;
+    view->stations = data + header->stations_tbl;
+    view->details_index = _HAFAS_BIN6_TRIP_DETAILS_INDEX(data);
+    view->part_details = _HAFAS_BIN6_TRIP_PART_DETAILS_INDEX(data);
+    view->stops = _HAFAS_BIN6_STOPS_INDEX(data);
+    /* only looked at on demand so bounds are checked when accessed */
+    view->attrs_tbl = ext->attrs_off;
+    view->comments_tbl = header->comments_tbl;
+    resolve_extras (view);
+    return TRUE;
+}
+
+/**
+ * hafas_bin6_view_headers_available:
+ * @data: the first @len bytes of decompressed hafas binary data
+ * @len: length of @data
+ *
+ * Check whether @data is long enough for #hafas_bin6_view_init to
+ * look at all the headers. This allows to set up a view on a
+ * partially received response.
+ *
+ * Returns: %TRUE if all headers are within @data
+ */
+gboolean
+hafas_bin6_view_headers_available (const gchar *data, gsize len)
+{
+    const HafasBin6Header *header;
+    const HafasBin6ExtHeader *ext;
+
+    if (len < sizeof (HafasBin6Header))
+        return FALSE;
+
+    header = HAFAS_BIN6_HEADER(data);
+    if (sizeof (HafasBin6Header) +
+        sizeof (HafasBin6Trip) * header->num_trips >= len ||
+        (guint64)header->ext + sizeof (HafasBin6ExtHeader) >= len)
+        return FALSE;
+
+    ext = HAFAS_BIN6_EXT_HEADER(data);
+    if ((guint64)ext->details_tbl + sizeof (HafasBin6TripDetailsHeader) >= len)
+        return FALSE;
+
+    return str_available (data, len, HAFAS_BIN6_START(data)->name_off) &&
+        str_available (data, len, HAFAS_BIN6_END(data)->name_off) &&
+        str_available (data, len, ext->enc_off) &&
+        str_available (data, len, ext->req_id_off);
+}
+
+/**
+ * hafas_bin6_view_trip_available:
+ * @view: a #HafasBin6View
+ * @idx: index of the trip
+ *
+ * Check whether all the records and strings making up the trip are
+ * within the view. This allows to parse trips of a partially received
+ * response. Once this returned %TRUE the trip's cursors can be used
+ * without further checks.
+ *
+ * Returns: %TRUE if the trip can be accessed
+ */
+gboolean
+hafas_bin6_view_trip_available (const HafasBin6View *view, guint idx)
+{
+    const gchar *data = view->data;
+    const HafasBin6Trip *trip;
+    const HafasBin6ServiceDay *sd;
+    const HafasBin6TripPart *part;
+    const HafasBin6TripPartDetail *pd;
+    const HafasBin6TripStop *stop;
+    guint64 off;
+    guint16 tidx;
+    guint j, k;
+
+    g_return_val_if_fail (idx < view->num_trips, FALSE);
+
+    trip = (const HafasBin6Trip*)(view->trips + idx * sizeof (HafasBin6Trip));
+
+    off = VIEW_OFF(view, view->service) + trip->service_off;
+    if (!in_view (view, off, G_STRUCT_OFFSET (HafasBin6ServiceDay, byte0)))
+        return FALSE;
+    sd = (const HafasBin6ServiceDay*)(data + off);
+    if (!in_view (view, off + G_STRUCT_OFFSET (HafasBin6ServiceDay, byte0), sd->byte_len))
+        return FALSE;
+
+    /* trip details and part details share the trip index */
+    if (!in_view (view, VIEW_OFF(view, view->details_index) + 2 * idx, sizeof (guint16)))
+        return FALSE;
+    tidx = *(const guint16*)(view->details_index + 2 * idx);
+    if (!in_view (view, VIEW_OFF(view, view->details_index) + tidx,
+                  sizeof (HafasBin6TripDetail)) ||
+        !in_view (view, VIEW_OFF(view, view->part_details) + tidx,
+                  (guint64)trip->part_cnt * sizeof (HafasBin6TripPartDetail)) ||
+        !in_view (view, VIEW_OFF(view, view->trips) + trip->parts_off,
+                  (guint64)trip->part_cnt * sizeof (HafasBin6TripPart)))
+        return FALSE;
+
+    for (j = 0; j < trip->part_cnt; j++) {
+        part = (const HafasBin6TripPart*)(view->trips + trip->parts_off +
+                                          j * sizeof (HafasBin6TripPart));
+        pd = (const HafasBin6TripPartDetail*)(view->part_details + tidx +
+                                              j * sizeof (HafasBin6TripPartDetail));
+
+        if (!station_available (view, part->dep_off) ||
+            !station_available (view, part->arr_off) ||
+            !str_available (data, view->len, part->line_off) ||
+            !str_available (data, view->len, part->dep_pos_off) ||
+            !str_available (data, view->len, part->arr_pos_off) ||
+            !str_available (data, view->len, pd->dep_pos_pred_off) ||
+            !str_available (data, view->len, pd->arr_pos_pred_off))
+            return FALSE;
+
+        /* parts without stops might not carry a valid stop index */
+        if (pd->stops_cnt == 0)
+            continue;
+
+        off = VIEW_OFF(view, view->stops) + (guint64)pd->stop_index * sizeof (HafasBin6TripStop);
+        if (!in_view (view, off, (guint64)pd->stops_cnt * sizeof (HafasBin6TripStop)))
+            return FALSE;
+
+        for (k = 0; k < pd->stops_cnt; k++) {
+            stop = (const HafasBin6TripStop*)(data + off + k * sizeof (HafasBin6TripStop));
+            if (!station_available (view, stop->stop_idx) ||
+                !str_available (data, view->len, stop->dep_pos_off) ||
+                !str_available (data, view->len, stop->arr_pos_off))
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * hafas_bin6_view_trip_extras_available:
+ * @view: a #HafasBin6View
+ * @idx: index of a trip that is available
+ *
+ * Check whether the attributes and comments of all parts of the
+ * trip are within the view. Unlike the rest of the trip they aren't
+ * needed to access it but in a partial view they'd be cut off.
+ *
+ * Returns: %TRUE if the trip's attributes and comments can be decoded
+ */
+gboolean
+hafas_bin6_view_trip_extras_available (const HafasBin6View *view, guint idx)
+{
+    const gchar *data = view->data;
+    const HafasBin6Attr *attr;
+    HafasBin6TripView trip;
+    HafasBin6PartView part;
+    guint64 off;
+    guint16 n;
+    guint j, k;
+
+    hafas_bin6_view_get_trip (view, idx, &trip);
+    for (j = 0; j < hafas_bin6_trip_view_get_n_parts (&trip); j++) {
+        hafas_bin6_trip_view_get_part (&trip, j, &part);
+
+        if (view->attrs_tbl) {
+            if (view->attrs == NULL)
+                return FALSE;
+            /* the list ends with an empty key */
+            for (k = 0; ; k++) {
+                off = VIEW_OFF(view, view->attrs) +
+                    ((guint64)part.part->attr_index + k) * sizeof (HafasBin6Attr);
+                if (!in_view (view, off, sizeof (HafasBin6Attr)))
+                    return FALSE;
+                attr = (const HafasBin6Attr*)(data + off);
+                if (attr->key_off == 0)
+                    break;
+                if (!str_available (data, view->len, attr->key_off) ||
+                    !str_available (data, view->len, attr->val_off))
+                    return FALSE;
+            }
+        }
+
+        if (view->comments_tbl) {
+            if (view->comments == NULL)
+                return FALSE;
+            off = VIEW_OFF(view, view->comments) + part.part->comments_off;
+            if (!in_view (view, off, sizeof (guint16)))
+                return FALSE;
+            n = *(const guint16*)(data + off);
+            if (!in_view (view, off + sizeof (guint16), (guint64)n * sizeof (guint16)))
+                return FALSE;
+            for (k = 0; k < n; k++) {
+                if (!str_available (data, view->len,
+                                    *(const guint16*)(data + off + sizeof (guint16) * (k + 1))))
+                    return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * hafas_bin6_view_check:
+ * @view: a #HafasBin6View on a complete response
+ * @err: #GError
+ *
+ * Make sure every table, part, stop and string offset of all trips
+ * points into the view so the cursors can do unchecked accesses.
+ *
+ * Returns: %TRUE if all trips can be accessed
+ */
+gboolean
+hafas_bin6_view_check (const HafasBin6View *view, GError **err)
+{
+    guint i;
+
+    for (i = 0; i < view->num_trips; i++) {
+        if (!hafas_bin6_view_trip_available (view, i)) {
+            g_set_error (err,
+                         LPF_PROVIDER_ERROR,
+                         LPF_PROVIDER_ERROR_PARSE_FAILED,
+                         "Corrupt Hafas blob: trip %d out of bounds", i);
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * hafas_bin6_view_rebase:
+ * @view: a #HafasBin6View
+ * @data: the new location of the view's data
+ * @len: length of @data, at least as long as the view
+ *
+ * Point the view to @data. This is used when the buffer backing
+ * the view grew and got moved.
+ */
+void
+hafas_bin6_view_rebase (HafasBin6View *view, const gchar *data, gsize len)
+{
+    g_return_if_fail (len >= view->len);
+
+#define REBASE(p) ((p) = data + ((p) - view->data))
+    REBASE(view->enc);
+    REBASE(view->trips);
+    REBASE(view->service);
+    REBASE(view->strings);
+    REBASE(view->stations);
+    REBASE(view->details_index);
+    REBASE(view->part_details);
+    REBASE(view->stops);
+#undef REBASE
+    view->data = data;
+    view->len = len;
+    view->attrs = view->comments = NULL;
+    resolve_extras (view);
+}
+
+/**
+ * hafas_bin6_charset_from_name:
+ * @enc: name of an encoding
+ *
+ * Returns: the #HafasBin6Charset that can be converted without iconv
+ *   or %HAFAS_BIN6_CHARSET_OTHER
+ */
+HafasBin6Charset
+hafas_bin6_charset_from_name (const gchar *enc)
+{
+    if (!g_ascii_strcasecmp (enc, "iso-8859-1") ||
+        !g_ascii_strcasecmp (enc, "iso8859-1") ||
+        !g_ascii_strcasecmp (enc, "latin1"))
+        return HAFAS_BIN6_CHARSET_LATIN1;
+    if (!g_ascii_strcasecmp (enc, "us-ascii") ||
+        !g_ascii_strcasecmp (enc, "ascii"))
+        return HAFAS_BIN6_CHARSET_ASCII;
+    if (!g_ascii_strcasecmp (enc, "utf-8") ||
+        !g_ascii_strcasecmp (enc, "utf8"))
+        return HAFAS_BIN6_CHARSET_UTF8;
+    return HAFAS_BIN6_CHARSET_OTHER;
+}
+
+static gchar*
+latin1_to_utf8 (const gchar *str)
+{
+    const guchar *s;
+    gchar *out, *o;
+    gsize len = 0;
+
+    for (s = (const guchar*)str; *s; s++)
+        len += (*s < 0x80) ? 1 : 2;
+
+    o = out = g_malloc (len + 1);
+    for (s = (const guchar*)str; *s; s++) {
+        if (*s < 0x80) {
+            *o++ = *s;
+        } else {
+            *o++ = 0xc0 | (*s >> 6);
+            *o++ = 0x80 | (*s & 0x3f);
+        }
+    }
+    *o = '\0';
+    return out;
+}
+
+static void
+free_iconv (gpointer data)
+{
+    g_iconv_close ((GIConv)data);
+}
+
+/**
+ * hafas_bin6_iconv_cache_new:
+ *
+ * Returns: (transfer full): an empty cache of iconv descriptors to be
+ *   used with #hafas_bin6_to_utf8
+ */
+GHashTable*
+hafas_bin6_iconv_cache_new (void)
+{
+    return g_hash_table_new_full (g_str_hash, g_str_equal, g_free, free_iconv);
+}
+
+/**
+ * hafas_bin6_to_utf8:
+ * @str: string to convert
+ * @charset: the #HafasBin6Charset of @enc
+ * @enc: the encoding of @str
+ * @iconvs: (allow-none): cache of iconv descriptors as created by
+ *   #hafas_bin6_iconv_cache_new
+ *
+ * Convert @str to UTF-8. The charsets hafas usually uses are converted
+ * by hand, for others the iconv descriptor is kept in @iconvs.
+ *
+ * Returns: (transfer full): the converted string or %NULL on error
+ */
+gchar*
+hafas_bin6_to_utf8 (const gchar *str, HafasBin6Charset charset, const gchar *enc, GHashTable *iconvs)
+{
+    const guchar *s;
+    GIConv cd;
+
+    switch (charset) {
+    case HAFAS_BIN6_CHARSET_LATIN1:
+        return latin1_to_utf8 (str);
+    case HAFAS_BIN6_CHARSET_ASCII:
+        for (s = (const guchar*)str; *s; s++)
+            if (*s >= 0x80)
+                return NULL;
+        return g_strdup (str);
+    case HAFAS_BIN6_CHARSET_UTF8:
+        return g_utf8_validate (str, -1, NULL) ? g_strdup (str) : NULL;
+    case HAFAS_BIN6_CHARSET_OTHER:
+    default:
+        break;
+    }
+
+    if (iconvs == NULL)
+        return g_convert (str, -1, "utf-8", enc, NULL, NULL, NULL);
+
+    cd = g_hash_table_lookup (iconvs, enc);
+    if (cd == NULL) {
+        cd = g_iconv_open ("utf-8", enc);
+        if (cd == (GIConv)-1)
+            return NULL;
+        g_hash_table_insert (iconvs, g_strdup (enc), cd);
+    }
+    return g_convert_with_iconv (str, -1, cd, NULL, NULL, NULL);
+}
+
+/**
+ * hafas_bin6_view_to_utf8:
+ * @view: a #HafasBin6View
+ * @str: a string in the view's encoding
+ *
+ * Returns: (transfer full): @str converted to UTF-8 or %NULL on error
+ */
+gchar*
+hafas_bin6_view_to_utf8 (const HafasBin6View *view, const gchar *str)
+{
+    return hafas_bin6_to_utf8 (str, view->charset, view->enc, view->iconvs);
+}
+
+/**
+ * hafas_bin6_service_day_offset:
+ * @sd: a service day entry
+ *
+ * Returns: the offset of the first service day from the base date in days
+ */
+guint
+hafas_bin6_service_day_offset (const HafasBin6ServiceDay *sd)
+{
+    const guchar *bits = (const guchar*)&sd->byte0;
+    guint off = sd->byte_base * 8;
+    gint i;
+
+    for (i = 0; i < sd->byte_len; i++) {
+        if (bits[i])  /* each leading zero bit means +1 day */
+            return off + i * 8 + __builtin_clz (bits[i]) - (sizeof (guint) - 1) * 8;
+    }
+    /* no service day at all */
+    return off + sd->byte_len * 8;
+}
+
+/**
+ * hafas_bin6_service_days:
+ * @sd: a service day entry
+ * @first_day: (out): offset of the first day in the bitmap from the
+ *   base date in days
+ *
+ * Get the days a trip runs on as a bitmap. The most significant bit
+ * of the first byte is @first_day, the following bits are the days
+ * after it. Trailing bytes without service days are dropped.
+ *
+ * Returns: (transfer full): the bitmap or %NULL if the trip doesn't
+ *   run at all
+ */
+GBytes*
+hafas_bin6_service_days (const HafasBin6ServiceDay *sd, guint *first_day)
+{
+    const guchar *bits = (const guchar*)&sd->byte0;
+    guint len = sd->byte_len;
+
+    while (len > 0 && bits[len-1] == 0)
+        len--;
+
+    *first_day = sd->byte_base * 8;
+    return len ? g_bytes_new (bits, len) : NULL;
+}
+
+/**
+ * hafas_bin6_view_get_trip:
+ * @view: a #HafasBin6View
+ * @idx: index of the trip
+ * @trip: (out): cursor pointing to the trip
+ */
+void
+hafas_bin6_view_get_trip (const HafasBin6View *view, guint idx, HafasBin6TripView *trip)
+{
+    g_return_if_fail (idx < view->num_trips);
+
+    trip->view = view;
+    trip->idx = idx;
+    trip->trip = (const HafasBin6Trip*)(view->trips + idx * sizeof (HafasBin6Trip));
+    trip->details_idx = *(const guint16*)(view->details_index + 2 * idx);
+    trip->day_off = hafas_bin6_service_day_offset (hafas_bin6_trip_view_get_service_day (trip));
+}
+
+/**
+ * hafas_bin6_trip_view_get_service_day:
+ * @trip: a #HafasBin6TripView
+ *
+ * Returns: (transfer none): the service days table entry of @trip
+ */
+const HafasBin6ServiceDay*
+hafas_bin6_trip_view_get_service_day (const HafasBin6TripView *trip)
+{
+    return (const HafasBin6ServiceDay*)(trip->view->service + trip->trip->service_off);
+}
+
+const HafasBin6TripDetail*
+hafas_bin6_trip_view_get_detail (const HafasBin6TripView *trip)
+{
+    return (const HafasBin6TripDetail*)(trip->view->details_index + trip->details_idx);
+}
+
+static const HafasBin6TripPartDetail*
+part_detail (const HafasBin6TripView *trip, guint idx)
+{
+    return (const HafasBin6TripPartDetail*)(trip->view->part_details + trip->details_idx +
+                                            idx * sizeof (HafasBin6TripPartDetail));
+}
+
+guint
+hafas_bin6_trip_view_get_n_parts (const HafasBin6TripView *trip)
+{
+    return trip->trip->part_cnt;
+}
+
+guint
+hafas_bin6_trip_view_get_changes (const HafasBin6TripView *trip)
+{
+    return trip->trip->changes;
+}
+
+/**
+ * hafas_bin6_trip_view_is_canceled:
+ * @trip: a #HafasBin6TripView
+ *
+ * Returns: %TRUE if any part of the trip got canceled
+ */
+gboolean
+hafas_bin6_trip_view_is_canceled (const HafasBin6TripView *trip)
+{
+    const HafasBin6TripPartDetail *pd;
+    guint j;
+
+    for (j = 0; j < trip->trip->part_cnt; j++) {
+        pd = part_detail (trip, j);
+        if (pd->flags & HAFAS_BIN6_PART_DETAIL_FLAGS_CANCELED_MASK)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+void
+hafas_bin6_trip_view_get_part (const HafasBin6TripView *trip, guint idx, HafasBin6PartView *part)
+{
+    g_return_if_fail (idx < trip->trip->part_cnt);
+
+    part->view = trip->view;
+    part->trip_idx = trip->idx;
+    part->idx = idx;
+    part->day_off = trip->day_off;
+    part->part = (const HafasBin6TripPart*)(trip->view->trips + trip->trip->parts_off +
+                                            idx * sizeof (HafasBin6TripPart));
+    part->detail = part_detail (trip, idx);
+}
+
+/**
+ * hafas_bin6_trip_view_get_departure:
+ * @trip: a #HafasBin6TripView
+ * @stop: (out): cursor pointing to the start of the trip's first part
+ */
+void
+hafas_bin6_trip_view_get_departure (const HafasBin6TripView *trip, HafasBin6StopView *stop)
+{
+    HafasBin6PartView part;
+
+    hafas_bin6_trip_view_get_part (trip, 0, &part);
+    hafas_bin6_part_view_get_start (&part, stop);
+}
+
+/**
+ * hafas_bin6_trip_view_get_arrival:
+ * @trip: a #HafasBin6TripView
+ * @stop: (out): cursor pointing to the end of the trip's last part
+ */
+void
+hafas_bin6_trip_view_get_arrival (const HafasBin6TripView *trip, HafasBin6StopView *stop)
+{
+    HafasBin6PartView part;
+
+    hafas_bin6_trip_view_get_part (trip, trip->trip->part_cnt - 1, &part);
+    hafas_bin6_part_view_get_end (&part, stop);
+}
+
+/**
+ * hafas_bin6_part_view_get_line:
+ * @part: a #HafasBin6PartView
+ *
+ * Returns: the line name in the view's encoding
+ */
+const gchar*
+hafas_bin6_part_view_get_line (const HafasBin6PartView *part)
+{
+    return HAFAS_BIN6_VIEW_STR(part->view, part->part->line_off);
+}
+
+gboolean
+hafas_bin6_part_view_is_canceled (const HafasBin6PartView *part)
+{
+    return !!(part->detail->flags & HAFAS_BIN6_PART_DETAIL_FLAGS_CANCELED_MASK);
+}
+
+void
+hafas_bin6_part_view_get_start (const HafasBin6PartView *part, HafasBin6StopView *stop)
+{
+    stop->view = part->view;
+    stop->day_off = part->day_off;
+    stop->station_idx = part->part->dep_off;
+    stop->arr = stop->rt_arr = HAFAS_BIN6_NO_TIME;
+    stop->dep = part->part->dep;
+    stop->rt_dep = part->detail->dep_pred;
+    stop->arr_plat = NULL;
+    stop->dep_plat = HAFAS_BIN6_VIEW_STR(part->view, part->part->dep_pos_off);
+}
+
+void
+hafas_bin6_part_view_get_end (const HafasBin6PartView *part, HafasBin6StopView *stop)
+{
+    stop->view = part->view;
+    stop->day_off = part->day_off;
+    stop->station_idx = part->part->arr_off;
+    stop->dep = stop->rt_dep = HAFAS_BIN6_NO_TIME;
+    stop->arr = part->part->arr;
+    stop->rt_arr = part->detail->arr_pred;
+    stop->dep_plat = NULL;
+    stop->arr_plat = HAFAS_BIN6_VIEW_STR(part->view, part->part->arr_pos_off);
+}
+
+/**
+ * hafas_bin6_part_view_get_n_stops:
+ * @part: a #HafasBin6PartView
+ *
+ * Returns: the number of intermediate stops
+ */
+guint
+hafas_bin6_part_view_get_n_stops (const HafasBin6PartView *part)
+{
+    return part->detail->stops_cnt;
+}
+
+/**
+ * hafas_bin6_part_view_get_attr:
+ * @part: a #HafasBin6PartView
+ * @n: index of the attribute
+ * @key: (out): name of the attribute in the view's encoding
+ * @val: (out): value of the attribute in the view's encoding, %NULL if unset
+ *
+ * Attributes aren't covered by #hafas_bin6_view_check so they're
+ * checked against the view's bounds here.
+ *
+ * Returns: %FALSE if the part has no @n-th attribute
+ */
+gboolean
+hafas_bin6_part_view_get_attr (const HafasBin6PartView *part, guint n, const gchar **key, const gchar **val)
+{
+    const HafasBin6View *view = part->view;
+    const HafasBin6Attr *attr;
+    guint64 off;
+
+    if (view->attrs == NULL)
+        return FALSE;
+
+    off = VIEW_OFF(view, view->attrs) +
+        ((guint64)part->part->attr_index + n) * sizeof (HafasBin6Attr);
+    if (!in_view (view, off, sizeof (HafasBin6Attr)))
+        return FALSE;
+
+    attr = (const HafasBin6Attr*)(view->data + off);
+    /* the list ends with an empty key */
+    if (attr->key_off == 0 ||
+        !str_available (view->data, view->len, attr->key_off) ||
+        !str_available (view->data, view->len, attr->val_off))
+        return FALSE;
+
+    *key = HAFAS_BIN6_VIEW_STR(view, attr->key_off);
+    *val = attr->val_off ? HAFAS_BIN6_VIEW_STR(view, attr->val_off) : NULL;
+    return TRUE;
+}
+
+/**
+ * hafas_bin6_part_view_get_n_comments:
+ * @part: a #HafasBin6PartView
+ *
+ * Returns: the number of comments of this part
+ */
+guint
+hafas_bin6_part_view_get_n_comments (const HafasBin6PartView *part)
+{
+    const HafasBin6View *view = part->view;
+    guint64 off;
+    guint16 n;
+
+    if (view->comments == NULL)
+        return 0;
+
+    off = VIEW_OFF(view, view->comments) + part->part->comments_off;
+    if (!in_view (view, off, sizeof (guint16)))
+        return 0;
+    n = *(const guint16*)(view->data + off);
+    if (!in_view (view, off + sizeof (guint16), (guint64)n * sizeof (guint16)))
+        return 0;
+    return n;
+}
+
+/**
+ * hafas_bin6_part_view_get_comment:
+ * @part: a #HafasBin6PartView
+ * @idx: index of the comment, less than #hafas_bin6_part_view_get_n_comments
+ *
+ * Returns: (transfer none): the comment in the view's encoding or
+ *   %NULL if it's not within the view
+ */
+const gchar*
+hafas_bin6_part_view_get_comment (const HafasBin6PartView *part, guint idx)
+{
+    const gchar *entry = part->view->comments + part->part->comments_off +
+        sizeof (guint16) * (idx + 1);
+    guint16 off = *(const guint16*)entry;
+
+    if (!str_available (part->view->data, part->view->len, off))
+        return NULL;
+    return HAFAS_BIN6_VIEW_STR(part->view, off);
+}
+
+void
+hafas_bin6_part_view_get_stop (const HafasBin6PartView *part, guint idx, HafasBin6StopView *stop)
+{
+    const HafasBin6TripStop *s;
+
+    g_return_if_fail (idx < part->detail->stops_cnt);
+
+    s = (const HafasBin6TripStop*)(part->view->stops +
+                                   (part->detail->stop_index + idx) * sizeof (HafasBin6TripStop));
+    stop->view = part->view;
+    stop->day_off = part->day_off;
+    stop->station_idx = s->stop_idx;
+    stop->arr = s->arr;
+    stop->dep = s->dep;
+    stop->rt_arr = s->arr_pred;
+    stop->rt_dep = s->dep_pred;
+    stop->arr_plat = HAFAS_BIN6_VIEW_STR(part->view, s->arr_pos_off);
+    stop->dep_plat = HAFAS_BIN6_VIEW_STR(part->view, s->dep_pos_off);
+}
+
+const HafasBin6Station*
+hafas_bin6_stop_view_get_station (const HafasBin6StopView *stop)
+{
+    return (const HafasBin6Station*)(stop->view->stations +
+                                     stop->station_idx * sizeof (HafasBin6Station));
+}
+
+/**
+ * hafas_bin6_stop_view_get_name:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer full): the station name converted to UTF-8
+ */
+gchar*
+hafas_bin6_stop_view_get_name (const HafasBin6StopView *stop)
+{
+    const HafasBin6Station *station = hafas_bin6_stop_view_get_station (stop);
+
+    return hafas_bin6_view_to_utf8 (stop->view,
+                                    HAFAS_BIN6_VIEW_STR(stop->view, station->name_off));
+}
+
+gdouble
+hafas_bin6_stop_view_get_long (const HafasBin6StopView *stop)
+{
+    return HAFAS_BIN6_LL_DOUBlE (hafas_bin6_stop_view_get_station (stop)->lon);
+}
+
+gdouble
+hafas_bin6_stop_view_get_lat (const HafasBin6StopView *stop)
+{
+    return HAFAS_BIN6_LL_DOUBlE (hafas_bin6_stop_view_get_station (stop)->lat);
+}
+
+static gint32
+stop_minutes (const HafasBin6StopView *stop, guint16 t)
+{
+    if (t == HAFAS_BIN6_NO_TIME)
+        return LPF_STOP_NO_TIME;
+
+    return lpf_provider_hafas_bin6_minutes (stop->view->days,
+                                            stop->day_off,
+                                            t / 100,
+                                            t % 100);
+}
+
+static GDateTime*
+stop_time (const HafasBin6StopView *stop, guint16 t)
+{
+    if (t == HAFAS_BIN6_NO_TIME)
+        return NULL;
+
+    return g_date_time_new_from_unix_utc ((gint64)stop_minutes (stop, t) * 60);
+}
+
+/**
+ * hafas_bin6_stop_view_get_arrival:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer full): the planned arrival or %NULL
+ */
+GDateTime*
+hafas_bin6_stop_view_get_arrival (const HafasBin6StopView *stop)
+{
+    return stop_time (stop, stop->arr);
+}
+
+/**
+ * hafas_bin6_stop_view_get_departure:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer full): the planned departure or %NULL
+ */
+GDateTime*
+hafas_bin6_stop_view_get_departure (const HafasBin6StopView *stop)
+{
+    return stop_time (stop, stop->dep);
+}
+
+/**
+ * hafas_bin6_stop_view_get_rt_arrival:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer full): the predicted arrival or %NULL
+ */
+GDateTime*
+hafas_bin6_stop_view_get_rt_arrival (const HafasBin6StopView *stop)
+{
+    return stop_time (stop, stop->rt_arr);
+}
+
+/**
+ * hafas_bin6_stop_view_get_rt_departure:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer full): the predicted departure or %NULL
+ */
+GDateTime*
+hafas_bin6_stop_view_get_rt_departure (const HafasBin6StopView *stop)
+{
+    return stop_time (stop, stop->rt_dep);
+}
+
+/**
+ * hafas_bin6_stop_view_get_arrival_minutes:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: the planned arrival in minutes since the Unix epoch or
+ * %LPF_STOP_NO_TIME
+ */
+gint32
+hafas_bin6_stop_view_get_arrival_minutes (const HafasBin6StopView *stop)
+{
+    return stop_minutes (stop, stop->arr);
+}
+
+/**
+ * hafas_bin6_stop_view_get_departure_minutes:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: the planned departure in minutes since the Unix epoch or
+ * %LPF_STOP_NO_TIME
+ */
+gint32
+hafas_bin6_stop_view_get_departure_minutes (const HafasBin6StopView *stop)
+{
+    return stop_minutes (stop, stop->dep);
+}
+
+/**
+ * hafas_bin6_stop_view_get_rt_arrival_minutes:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: the predicted arrival in minutes since the Unix epoch or
+ * %LPF_STOP_NO_TIME
+ */
+gint32
+hafas_bin6_stop_view_get_rt_arrival_minutes (const HafasBin6StopView *stop)
+{
+    return stop_minutes (stop, stop->rt_arr);
+}
+
+/**
+ * hafas_bin6_stop_view_get_rt_departure_minutes:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: the predicted departure in minutes since the Unix epoch or
+ * %LPF_STOP_NO_TIME
+ */
+gint32
+hafas_bin6_stop_view_get_rt_departure_minutes (const HafasBin6StopView *stop)
+{
+    return stop_minutes (stop, stop->rt_dep);
+}
+
+static const gchar*
+platform (const gchar *plat)
+{
+    if (plat == NULL || !g_strcmp0 (HAFAS_BIN6_NO_PLATFORM, plat))
+        return NULL;
+    return plat;
+}
+
+/**
+ * hafas_bin6_stop_view_get_arr_plat:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer none): the arrival platform or %NULL
+ */
+const gchar*
+hafas_bin6_stop_view_get_arr_plat (const HafasBin6StopView *stop)
+{
+    return platform (stop->arr_plat);
+}
+
+/**
+ * hafas_bin6_stop_view_get_dep_plat:
+ * @stop: a #HafasBin6StopView
+ *
+ * Returns: (transfer none): the departure platform or %NULL
+ */
+const gchar*
+hafas_bin6_stop_view_get_dep_plat (const HafasBin6StopView *stop)
+{
+    return platform (stop->dep_plat);
+}
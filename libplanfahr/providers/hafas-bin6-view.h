@@ -0,0 +1,178 @@
+/*
+ * hafas-bin6-view.h: read-only cursors into hafas binary format version 6 data
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _HAFAS_BIN6_VIEW_H
+#define _HAFAS_BIN6_VIEW_H
+
+#include <glib.h>
+
+#include "hafas-bin6-format.h"
+
+G_BEGIN_DECLS
+
+/**
+ * HAFAS_BIN6_NO_TIME: a #HafasBin6StopView doesn't carry this time
+ */
+#define HAFAS_BIN6_NO_TIME 0xFFFF
+
+/**
+ * HafasBin6Charset:
+ *
+ * Encodings of the strings table that are converted to UTF-8 without
+ * iconv
+ */
+typedef enum {
+    HAFAS_BIN6_CHARSET_OTHER = 0,
+    HAFAS_BIN6_CHARSET_ASCII,
+    HAFAS_BIN6_CHARSET_LATIN1,
+    HAFAS_BIN6_CHARSET_UTF8,
+} HafasBin6Charset;
+
+/**
+ * HafasBin6View:
+ *
+ * A read-only view of a decompressed Hafas binary format version 6
+ * buffer. Nothing is copied or converted when the view is set up,
+ * the buffer must stay valid as long as the view or any cursor
+ * derived from it is used.
+ */
+typedef struct _HafasBin6View {
+    const gchar *data;
+    gsize len;
+    const gchar *enc;    /* encoding used in the strings table */
+    HafasBin6Charset charset;
+    GHashTable *iconvs;  /* encoding -> GIConv cache, might be NULL */
+    guint16 num_trips;
+    gint16 days;         /* date base in days since 1980 */
+    /* table bases as resolved by hafas_bin6_view_init */
+    const gchar *trips;          /* trips table, parts_off is relative to it */
+    const gchar *service;        /* service days table */
+    const gchar *strings;        /* strings table */
+    const gchar *stations;       /* stations table */
+    const gchar *details_index;  /* trip details index */
+    const gchar *part_details;   /* trip part details */
+    const gchar *stops;          /* intermediate stops */
+    const gchar *attrs;          /* attribute lists, might be NULL */
+    const gchar *comments;       /* comments table, might be NULL */
+    /* offsets of the above, they might lie beyond a partial view */
+    guint32 attrs_tbl, comments_tbl;
+    const gchar *provider; /* name used for location ids, might be NULL */
+} HafasBin6View;
+
+/* Get the string at offset off of the view's strings table */
+#define HAFAS_BIN6_VIEW_STR(view, off) ((view)->strings + (off))
+
+/**
+ * HafasBin6TripView:
+ *
+ * Cursor pointing to a trip in a #HafasBin6View
+ */
+typedef struct _HafasBin6TripView {
+    const HafasBin6View *view;
+    guint idx;
+    guint day_off;       /* service day offset from view->days */
+    guint16 details_idx; /* offset into trip and part details */
+    const HafasBin6Trip *trip;
+} HafasBin6TripView;
+
+/**
+ * HafasBin6PartView:
+ *
+ * Cursor pointing to a part of a trip in a #HafasBin6View
+ */
+typedef struct _HafasBin6PartView {
+    const HafasBin6View *view;
+    guint trip_idx;
+    guint idx;
+    guint day_off;
+    const HafasBin6TripPart *part;
+    const HafasBin6TripPartDetail *detail;
+} HafasBin6PartView;
+
+/**
+ * HafasBin6StopView:
+ *
+ * Cursor pointing to a stop in a #HafasBin6View. This is either the
+ * start or end of a trip part or an intermediate stop. Times are in
+ * the hafas HHMM notation, HAFAS_BIN6_NO_TIME if not present.
+ */
+typedef struct _HafasBin6StopView {
+    const HafasBin6View *view;
+    guint day_off;
+    guint16 station_idx;
+    guint16 arr, dep;                 /* planned */
+    guint16 rt_arr, rt_dep;           /* predicted */
+    const gchar *arr_plat, *dep_plat; /* in view->enc, NULL if unset */
+} HafasBin6StopView;
+
+gboolean hafas_bin6_view_init (HafasBin6View *view, const gchar *data, gsize len, GError **err);
+gboolean hafas_bin6_view_headers_available (const gchar *data, gsize len);
+gboolean hafas_bin6_view_trip_available (const HafasBin6View *view, guint idx);
+gboolean hafas_bin6_view_trip_extras_available (const HafasBin6View *view, guint idx);
+gboolean hafas_bin6_view_check (const HafasBin6View *view, GError **err);
+void hafas_bin6_view_rebase (HafasBin6View *view, const gchar *data, gsize len);
+void hafas_bin6_view_get_trip (const HafasBin6View *view, guint idx, HafasBin6TripView *trip);
+gchar *hafas_bin6_view_to_utf8 (const HafasBin6View *view, const gchar *str);
+
+HafasBin6Charset hafas_bin6_charset_from_name (const gchar *enc);
+gchar *hafas_bin6_to_utf8 (const gchar *str, HafasBin6Charset charset, const gchar *enc, GHashTable *iconvs);
+GHashTable *hafas_bin6_iconv_cache_new (void);
+
+guint hafas_bin6_service_day_offset (const HafasBin6ServiceDay *sd);
+GBytes *hafas_bin6_service_days (const HafasBin6ServiceDay *sd, guint *first_day);
+
+const HafasBin6ServiceDay *hafas_bin6_trip_view_get_service_day (const HafasBin6TripView *trip);
+const HafasBin6TripDetail *hafas_bin6_trip_view_get_detail (const HafasBin6TripView *trip);
+guint hafas_bin6_trip_view_get_n_parts (const HafasBin6TripView *trip);
+guint hafas_bin6_trip_view_get_changes (const HafasBin6TripView *trip);
+gboolean hafas_bin6_trip_view_is_canceled (const HafasBin6TripView *trip);
+void hafas_bin6_trip_view_get_part (const HafasBin6TripView *trip, guint idx, HafasBin6PartView *part);
+void hafas_bin6_trip_view_get_departure (const HafasBin6TripView *trip, HafasBin6StopView *stop);
+void hafas_bin6_trip_view_get_arrival (const HafasBin6TripView *trip, HafasBin6StopView *stop);
+
+const gchar *hafas_bin6_part_view_get_line (const HafasBin6PartView *part);
+gboolean hafas_bin6_part_view_is_canceled (const HafasBin6PartView *part);
+void hafas_bin6_part_view_get_start (const HafasBin6PartView *part, HafasBin6StopView *stop);
+void hafas_bin6_part_view_get_end (const HafasBin6PartView *part, HafasBin6StopView *stop);
+guint hafas_bin6_part_view_get_n_stops (const HafasBin6PartView *part);
+gboolean hafas_bin6_part_view_get_attr (const HafasBin6PartView *part, guint n, const gchar **key, const gchar **val);
+guint hafas_bin6_part_view_get_n_comments (const HafasBin6PartView *part);
+const gchar *hafas_bin6_part_view_get_comment (const HafasBin6PartView *part, guint idx);
+void hafas_bin6_part_view_get_stop (const HafasBin6PartView *part, guint idx, HafasBin6StopView *stop);
+
+const HafasBin6Station *hafas_bin6_stop_view_get_station (const HafasBin6StopView *stop);
+gchar *hafas_bin6_stop_view_get_name (const HafasBin6StopView *stop);
+gdouble hafas_bin6_stop_view_get_long (const HafasBin6StopView *stop);
+gdouble hafas_bin6_stop_view_get_lat (const HafasBin6StopView *stop);
+GDateTime *hafas_bin6_stop_view_get_arrival (const HafasBin6StopView *stop);
+GDateTime *hafas_bin6_stop_view_get_departure (const HafasBin6StopView *stop);
+GDateTime *hafas_bin6_stop_view_get_rt_arrival (const HafasBin6StopView *stop);
+GDateTime *hafas_bin6_stop_view_get_rt_departure (const HafasBin6StopView *stop);
+gint32 hafas_bin6_stop_view_get_arrival_minutes (const HafasBin6StopView *stop);
+gint32 hafas_bin6_stop_view_get_departure_minutes (const HafasBin6StopView *stop);
+gint32 hafas_bin6_stop_view_get_rt_arrival_minutes (const HafasBin6StopView *stop);
+gint32 hafas_bin6_stop_view_get_rt_departure_minutes (const HafasBin6StopView *stop);
+const gchar *hafas_bin6_stop_view_get_arr_plat (const HafasBin6StopView *stop);
+const gchar *hafas_bin6_stop_view_get_dep_plat (const HafasBin6StopView *stop);
+
+G_END_DECLS
+#endif /* _HAFAS_BIN6_VIEW_H */
@@ -22,13 +22,23 @@
 
 #include <config.h>
 
+#include <math.h>
 #include <string.h>
 #include <libxml/parser.h>
-#include <libxml/xpath.h>
 
 #include <libsoup/soup.h>
 
+#ifdef HAVE_LIBDEFLATE
+# include <libdeflate.h>
+#elif defined (HAVE_ZLIB)
+# include <zlib.h>
+#endif
+
 #include "hafas-bin6.h"
+#include "hafas-bin6-locs-cache.h"
+#include "hafas-bin6-station-db.h"
+#include "hafas-bin6-station-index.h"
+#include "hafas-bin6-view.h"
 #include "lpf-loc.h"
 #include "lpf-priv.h"
 #include "lpf-provider.h"
@@ -44,9 +54,30 @@ G_DEFINE_TYPE_WITH_CODE (LpfProviderHafasBin6, lpf_provider_hafas_bin6, G_TYPE_O
 
 #define PROVIDER_NAME "hafas_bin6"
 
+/* Matches packed into a single location request */
+#define HAFAS_BIN6_LOCS_BATCH_SIZE 50
+#define HAFAS_BIN6_MAX_LOCS_BATCH_SIZE 1000
+
+/* Location lookups remembered and for how long (in seconds) */
+#define HAFAS_BIN6_LOCS_CACHE_SIZE 512
+#define HAFAS_BIN6_LOCS_CACHE_TTL (24 * 60 * 60)
+#define HAFAS_BIN6_LOCS_CACHE_FILE "locs-cache"
+
+/* Stations kept for answering type-ahead lookups locally */
+#define HAFAS_BIN6_STATION_INDEX_SIZE 20000
+
+/* Stations seen in trips, written out every that many new ones */
+#define HAFAS_BIN6_STATION_DB_FILE "stations.db"
+#define HAFAS_BIN6_STATION_DB_SYNC 256
+
 enum {
     PROP_0,
     PROP_NAME,
+    PROP_LOCS_BATCH_SIZE,
+    PROP_LOCS_CACHE_SIZE,
+    PROP_LOCS_CACHE_TTL,
+    PROP_LOCS_CACHE_PERSIST,
+    PROP_STATION_DB_ENABLED,
     LAST_PROP
 };
 
@@ -55,8 +86,16 @@ typedef struct _LpfProviderGotItUserData {
     LpfProvider *self;
     gpointer callback;
     gpointer user_data;
+    LpfProviderGetLocsFlags flags;
+    guint max_results;
+    gchar *match;
 } LpfProviderGotItUserData;
 
+/* Location types we can ask for */
+#define LOCS_TYPES (LPF_PROVIDER_GET_LOCS_STATIONS |  \
+                    LPF_PROVIDER_GET_LOCS_ADDRESSES | \
+                    LPF_PROVIDER_GET_LOCS_POIS)
+
 #define GET_PRIVATE(o) \
   (G_TYPE_INSTANCE_GET_PRIVATE ((o), LPF_TYPE_PROVIDER_HAFAS_BIN6, LpfProviderHafasBin6Private))
 
@@ -67,6 +106,17 @@ struct _LpfProviderHafasBin6Private {
     SoupSession *session;
     char *logdir;
     gboolean debug;
+    GHashTable *iconvs;     /* encoding -> GIConv */
+    xmlParserCtxtPtr locs_parser;
+    guint locs_batch_size;  /* matches per location request */
+    HafasBin6LocsCache *locs_cache;
+    guint locs_cache_size;
+    guint locs_cache_ttl;   /* in seconds */
+    gboolean locs_cache_persist;
+    HafasBin6StationIndex *station_index;
+    HafasBin6StationDb *station_db;
+    gboolean station_db_enabled;
+    guint station_db_sync_id;   /* idle source writing the database */
 };
 
 
@@ -100,70 +150,285 @@ lpf_provider_hafas_bin6_trips_url(LpfProviderHafasBin6 *self)
 }
 
 
-static GSList*
-parse_locs_xml (const char *xml)
-{
-    gint i = 0;
-    xmlDocPtr doc = NULL;
-    xmlChar *xpath = (xmlChar*) "//MLc[@t=\"ST\"]";
-    xmlXPathContextPtr context = NULL;
-    xmlXPathObjectPtr result = NULL;
-    xmlNodeSetPtr nodeset = NULL;
-    gchar *name, *x, *y;
-    gdouble lo, la;
+/* Numeric attribute values aren't NUL terminated in SAX2 */
+static gdouble
+attr_to_double (const xmlChar *value, const xmlChar *end)
+{
+    gchar buf[G_ASCII_DTOSTR_BUF_SIZE];
+    gsize len = MIN((gsize)(end - value), sizeof(buf) - 1);
+
+    memcpy (buf, value, len);
+    buf[len] = '\0';
+    return g_ascii_strtod (buf, NULL);
+}
+
+
+static gboolean
+attr_equal (const xmlChar *value, const xmlChar *end, const char *str)
+{
+    gsize len = strlen (str);
+
+    return (gsize)(end - value) == len && !memcmp (value, str, len);
+}
+
+
+/* State while streaming through the MLcRes of one or more matches */
+typedef struct _HafasBin6LocsParse {
+    GSList **results;   /* one list per match */
+    guint n_results;
+    LpfProviderGetLocsFlags types;
+    guint max_results;  /* per match, 0 for no limit */
+    guint n_res;        /* MLcRes elements seen so far */
+    guint n_locs;       /* locations in the current MLcRes */
+    gboolean stopped;   /* all wanted locations were seen */
+} HafasBin6LocsParse;
+
+
+/* Map the MLc type attribute to our location types */
+static LpfProviderGetLocsFlags
+attr_to_loc_type (const xmlChar *value, const xmlChar *end)
+{
+    if (attr_equal (value, end, "ST"))
+        return LPF_PROVIDER_GET_LOCS_STATIONS;
+    else if (attr_equal (value, end, "ADR"))
+        return LPF_PROVIDER_GET_LOCS_ADDRESSES;
+    else if (attr_equal (value, end, "POI"))
+        return LPF_PROVIDER_GET_LOCS_POIS;
+    return LPF_PROVIDER_GET_LOCS_NONE;
+}
+
+
+/* Create a LpfLoc for every wanted location as soon as its MLc element starts */
+static void
+locs_start_element (void *ctx,
+                    const xmlChar *localname,
+                    const xmlChar *prefix,
+                    const xmlChar *uri,
+                    int nb_namespaces,
+                    const xmlChar **namespaces,
+                    int nb_attributes,
+                    int nb_defaulted,
+                    const xmlChar **attrs)
+{
+    xmlParserCtxtPtr ctxt = ctx;
+    HafasBin6LocsParse *parse = ctxt->_private;
+    GSList **locs;
+    const xmlChar *name = NULL, *name_end = NULL, *id = NULL, *id_end = NULL;
+    const xmlChar *value, *end;
+    LpfProviderGetLocsFlags type = LPF_PROVIDER_GET_LOCS_NONE;
+    gdouble lo = 0.0, la = 0.0;
+    gchar *n, *i;
     LpfLoc *loc;
-    char *id;
-    GSList *locs = NULL;
+    gint a;
 
-    g_return_val_if_fail (xml, NULL);
+    /* Each match gets its own MLcRes in request order */
+    if (!strcmp ((const char*)localname, "MLcRes")) {
+        parse->n_res++;
+        parse->n_locs = 0;
+        return;
+    }
 
-    LPF_DEBUG("%s", xml);
-    doc = xmlParseMemory(xml, strlen(xml));
-    if (doc == NULL ) {
-        g_warning("Document not parsed successfully");
+    if (strcmp ((const char*)localname, "MLc"))
+        return;
+
+    if (parse->n_res > parse->n_results)
+        return;
+    /* Don't even look at locations past the cap */
+    if (parse->max_results && parse->n_locs >= parse->max_results)
+        return;
+    locs = &parse->results[parse->n_res ? parse->n_res - 1 : 0];
+
+    /* attributes come as (localname, prefix, URI, value, end) */
+    for (a = 0; a < nb_attributes; a++, attrs += 5) {
+        value = attrs[3];
+        end = attrs[4];
+
+        /* all attributes we care about have single letter names */
+        if (attrs[0][0] == '\0' || attrs[0][1] != '\0')
+            continue;
+
+        switch (attrs[0][0]) {
+        case 't':
+            type = attr_to_loc_type (value, end);
+            break;
+        case 'n':
+            name = value;
+            name_end = end;
+            break;
+        case 'i':
+            id = value;
+            id_end = end;
+            break;
+        case 'x':
+            lo = attr_to_double (value, end) / 1000000.0;
+            break;
+        case 'y':
+            la = attr_to_double (value, end) / 1000000.0;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (!(type & parse->types))
+        return;
+
+    n = name ? g_strndup ((const gchar*)name, name_end - name) : NULL;
+    i = id ? g_strndup ((const gchar*)id, id_end - id) : NULL;
+
+    LPF_DEBUG ("%s (%lf, %lf) - %s", n, lo, la, i);
+
+    loc = lpf_loc_new_full (n, lo, la);
+    lpf_loc_set_opaque (loc, i);
+    *locs = g_slist_prepend (*locs, loc);
+    g_free (n);
+
+    /* Skip the rest of the document once the last match is complete */
+    if (++parse->n_locs == parse->max_results &&
+        parse->n_res >= parse->n_results) {
+        parse->stopped = TRUE;
+        xmlStopParser (ctxt);
+    }
+}
+
+
+/*
+ * A parser context that only reports location elements. It can be
+ * reused for any number of responses so the dictionary and input
+ * buffers don't need to be set up again each time.
+ */
+static xmlParserCtxtPtr
+locs_parser_new (void)
+{
+    xmlParserCtxtPtr ctxt;
+
+    ctxt = xmlNewParserCtxt ();
+    if (ctxt == NULL)
         return NULL;
+
+    memset (ctxt->sax, 0, sizeof (xmlSAXHandler));
+    ctxt->sax->initialized = XML_SAX2_MAGIC;
+    ctxt->sax->startElementNs = locs_start_element;
+    return ctxt;
+}
+
+
+/*
+ * Parse a response to a request with @n_results matches into
+ * @results keeping at most @max_results locations of @types per
+ * match. Returns %FALSE if the document isn't well formed in which
+ * case @results is left empty.
+ */
+static gboolean
+parse_locs_xml_multi (xmlParserCtxtPtr parser, const char *xml,
+                      LpfProviderGetLocsFlags types, guint max_results,
+                      GSList **results, guint n_results)
+{
+    xmlParserCtxtPtr ctxt = parser;
+    HafasBin6LocsParse parse = { results, n_results, types, max_results };
+    gboolean ret = FALSE, ok;
+    xmlDocPtr doc;
+    guint i;
+
+    g_return_val_if_fail (xml, FALSE);
+
+    LPF_DEBUG("%s", xml);
+
+    if (ctxt == NULL && (ctxt = locs_parser_new ()) == NULL) {
+        g_warning("Failed to create parser context");
+        return FALSE;
     }
 
-    context = xmlXPathNewContext(doc);
-    if (context == NULL) {
-        g_warning("Error in xmlXPathNewContext\n");
-        goto out;
+    memset (results, 0, n_results * sizeof (GSList*));
+    ctxt->_private = &parse;
+    /* NOENT makes SAX2 hand out "&amp;" decoded, there are no entity
+       handlers so nothing external gets loaded */
+    doc = xmlCtxtReadMemory (ctxt, xml, strlen(xml), NULL, NULL,
+                             XML_PARSE_NOENT | XML_PARSE_NONET);
+    ctxt->_private = NULL;
+    /* Nothing builds a tree but be safe against a default handler */
+    if (doc)
+        xmlFreeDoc (doc);
+    ok = ctxt->wellFormed || parse.stopped;
+
+    for (i = 0; i < n_results; i++) {
+        if (ok)
+            results[i] = g_slist_reverse (results[i]);
+        else {
+            g_slist_free_full (results[i], g_object_unref);
+            results[i] = NULL;
+        }
     }
 
-    result = xmlXPathEvalExpression(xpath, context);
-    if (result == NULL) {
-        g_warning("Error in xmlXPathEvalExpression\n");
+    if (!ok) {
+        g_warning("Document not parsed successfully");
         goto out;
     }
+    ret = TRUE;
+ out:
+    if (parser == NULL)
+        xmlFreeParserCtxt (ctxt);
+    return ret;
+}
+
 
-    if(xmlXPathNodeSetIsEmpty(result->nodesetval)){
+static GSList*
+parse_locs_xml (xmlParserCtxtPtr parser, const char *xml,
+                LpfProviderGetLocsFlags types, guint max_results)
+{
+    GSList *locs = NULL;
+
+    if (!parse_locs_xml_multi (parser, xml, types, max_results, &locs, 1))
+        return NULL;
+
+    if (locs == NULL)
         g_warning("No result\n");
-        goto out;
-    }
+    return locs;
+}
+
 
-    nodeset = result->nodesetval;
-    for (i=0; i < nodeset->nodeNr; i++) {
-        name = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "n");
-        x = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "x");
-        y = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "y");
-        id = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "i");
+/* Only stations unless asked otherwise */
+static LpfProviderGetLocsFlags
+locs_types (LpfProviderGetLocsFlags flags)
+{
+    return (flags & LOCS_TYPES) ? (flags & LOCS_TYPES) : LPF_PROVIDER_GET_LOCS_STATIONS;
+}
 
-        lo = (gdouble) g_ascii_strtod(x, NULL) / 1000000.0;
-        la = (gdouble) g_ascii_strtod(y, NULL) / 1000000.0;
 
-        LPF_DEBUG ("%s (%lf, %lf) - %s", name, lo, la, id);
+/* A location request for @n matches of @types with one MLcReq each */
+static gchar*
+locs_request_new (const gchar * const *matches, guint n, LpfProviderGetLocsFlags types)
+{
+    const char *t;
+    GString *xml;
+    gchar *match;
+    guint i;
+
+    /* Mixed types need filtering while parsing */
+    switch (types) {
+    case LPF_PROVIDER_GET_LOCS_STATIONS:
+        t = "ST";
+        break;
+    case LPF_PROVIDER_GET_LOCS_ADDRESSES:
+        t = "ADR";
+        break;
+    case LPF_PROVIDER_GET_LOCS_POIS:
+        t = "POI";
+        break;
+    default:
+        t = "ALLTYPE";
+        break;
+    }
 
-        loc = (LpfLoc*) g_object_new (LPF_TYPE_LOC, "name", name, "long", lo, "lat", la, NULL);
-        lpf_loc_set_opaque (loc, id);
-        locs = g_slist_append(locs, loc);
-        g_free(x);
-        g_free(y);
+    xml = g_string_new ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+                        "<ReqC ver=\"1.1\" prod=\"String\" lang=\"EN\">");
+    for (i = 0; i < n; i++) {
+        match = g_markup_escape_text (matches[i], -1);
+        g_string_append_printf (xml, "<MLcReq><MLc n=\"%s\" t=\"%s\"/></MLcReq>", match, t);
+        g_free (match);
     }
- out:
-     xmlXPathFreeContext(context);
-     xmlXPathFreeObject(result);
-     xmlFreeDoc(doc);
-     return locs;
+    g_string_append (xml, "</ReqC>");
+    return g_string_free (xml, FALSE);
 }
 
 
@@ -199,6 +464,118 @@ log_response_body(LpfProviderHafasBin6 *self, SoupMessage *msg, const char* type
 }
 
 
+/* Namespace of location ids, only subclasses have a name */
+static const gchar*
+provider_name (LpfProvider *self)
+{
+    if (LPF_PROVIDER_GET_INTERFACE (self)->get_name == NULL)
+        return NULL;
+    return lpf_provider_get_name (self);
+}
+
+
+/* The station id in the L= field of a location's opaque data */
+static guint32
+opaque_station_id (const gchar *opaque)
+{
+    const gchar *l;
+
+    if (opaque == NULL)
+        return 0;
+
+    if (g_str_has_prefix (opaque, "L="))
+        l = opaque + 2;
+    else if ((l = strstr (opaque, "@L=")) != NULL)
+        l += 3;
+    else
+        return 0;
+    return (guint32)g_ascii_strtoull (l, NULL, 10);
+}
+
+
+/* Give locations a compact identity */
+static void
+locs_set_ids (LpfProvider *self, GSList *locs)
+{
+    LpfLoc *loc;
+    guint32 id;
+
+    for (; locs; locs = g_slist_next (locs)) {
+        loc = LPF_LOC (locs->data);
+        if (!lpf_loc_get_id (loc) && (id = opaque_station_id (lpf_loc_get_opaque (loc))))
+            lpf_loc_set_id (loc, provider_name (self), id);
+    }
+}
+
+
+static gboolean
+station_db_sync_idle (gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = user_data;
+    GError *err = NULL;
+
+    priv->station_db_sync_id = 0;
+    if (!hafas_bin6_station_db_sync (priv->station_db, &err)) {
+        g_warning ("Failed to write station database: %s", err->message);
+        g_clear_error (&err);
+    }
+    return FALSE;
+}
+
+
+/* Remember a station in the database. It is written from
+ * an idle handler so responses aren't held up by it. */
+static void
+station_db_add (LpfProviderHafasBin6Private *priv, guint32 id, const gchar *name,
+                gdouble lon, gdouble lat)
+{
+    if (!hafas_bin6_station_db_add (priv->station_db, id, name,
+                                    lround (lon * 1000000.0),
+                                    lround (lat * 1000000.0)))
+        return;
+
+    if (!priv->station_db_sync_id &&
+        hafas_bin6_station_db_get_n_pending (priv->station_db) >= HAFAS_BIN6_STATION_DB_SYNC)
+        priv->station_db_sync_id = g_idle_add_full (G_PRIORITY_LOW, station_db_sync_idle,
+                                                    priv, NULL);
+}
+
+
+static void
+station_db_add_locs (LpfProviderHafasBin6Private *priv, GSList *locs)
+{
+    LpfLoc *loc;
+
+    for (; locs; locs = g_slist_next (locs)) {
+        loc = LPF_LOC (locs->data);
+        /* without a provider name there's no station id */
+        if (lpf_loc_get_provider (loc) == NULL)
+            continue;
+        station_db_add (priv, lpf_loc_get_id (loc), lpf_loc_get_name (loc),
+                        lpf_loc_get_long (loc), lpf_loc_get_lat (loc));
+    }
+}
+
+
+/* Remember the result of a location lookup for later lookups */
+static void
+remember_locs (LpfProviderHafasBin6Private *priv, const gchar *match,
+               LpfProviderGetLocsFlags types, guint max_results, GSList *locs)
+{
+    /* Remember lookups without result too */
+    if (priv->locs_cache)
+        hafas_bin6_locs_cache_insert (priv->locs_cache, match, types,
+                                      max_results, locs, g_get_real_time ());
+
+    if (types != LPF_PROVIDER_GET_LOCS_STATIONS)
+        return;
+    if (priv->station_index)
+        hafas_bin6_station_index_add_locs (priv->station_index, locs);
+    if (priv->station_db)
+        station_db_add_locs (priv, locs);
+}
+
+
 static void
 got_locs (SoupSession *session, SoupMessage *msg, gpointer user_data)
 {
@@ -206,6 +583,10 @@ got_locs (SoupSession *session, SoupMessage *msg, gpointer user_data)
     LpfProviderGotItUserData *locs_data = (LpfProviderGotItUserData*)user_data;
     LpfProviderGotLocsNotify callback;
     LpfProviderHafasBin6 *self;
+    LpfProviderHafasBin6Private *priv;
+    LpfProviderGetLocsFlags flags;
+    guint max_results;
+    gchar *match;
     gpointer data;
     GError *err = NULL;
 
@@ -216,7 +597,11 @@ got_locs (SoupSession *session, SoupMessage *msg, gpointer user_data)
     callback = locs_data->callback;
     data = locs_data->user_data;
     self = LPF_PROVIDER_HAFAS_BIN6(locs_data->self);
+    flags = locs_data->flags;
+    max_results = locs_data->max_results;
+    match = locs_data->match;
     g_free (locs_data);
+    priv = GET_PRIVATE(self);
 
     LPF_DEBUG("Status: %d", msg->status_code);
     if (!SOUP_STATUS_IS_SUCCESSFUL(msg->status_code)) {
@@ -231,7 +616,22 @@ got_locs (SoupSession *session, SoupMessage *msg, gpointer user_data)
 
     log_response_body (self, msg, "station");
 
-    if ((locs = parse_locs_xml(msg->response_body->data)) == NULL) {
+    if (!parse_locs_xml_multi (priv->locs_parser,
+                               msg->response_body->data,
+                               locs_types (flags),
+                               max_results,
+                               &locs, 1)) {
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Failed to parse locations");
+        goto out;
+    }
+
+    locs_set_ids (LPF_PROVIDER (self), locs);
+    remember_locs (priv, match, locs_types (flags), max_results, locs);
+
+    if (locs == NULL) {
         g_set_error (&err,
                      LPF_PROVIDER_ERROR,
                      LPF_PROVIDER_ERROR_PARSE_FAILED,
@@ -240,12 +640,60 @@ got_locs (SoupSession *session, SoupMessage *msg, gpointer user_data)
     }
 
 out:
+    g_free (match);
     (*callback)(locs, data, err);
 }
 
 
+/* transfers a cache hit to the idle callback */
+typedef struct _HafasBin6CachedLocs {
+    LpfProvider *self;      /* reffed until the callback ran */
+    LpfProviderGotLocsNotify callback;
+    gpointer user_data;
+    GSList *locs;
+    gboolean empty_ok;      /* whether no locations is a valid answer */
+} HafasBin6CachedLocs;
+
+
+/* Invoke the callback for a cache hit like for a network reply */
+static gboolean
+got_cached_locs (gpointer user_data)
+{
+    HafasBin6CachedLocs *cached = user_data;
+    GError *err = NULL;
+
+    locs_set_ids (cached->self, cached->locs);
+    if (cached->locs == NULL && !cached->empty_ok)
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Failed to parse locations");
+
+    (*cached->callback)(cached->locs, cached->user_data, err);
+    g_object_unref (cached->self);
+    g_free (cached);
+    return FALSE;
+}
+
+
+/* Answer with locs from an idle, takes ownership of locs */
+static void
+cached_locs_idle_add (LpfProvider *self, GSList *locs, gboolean empty_ok,
+                      LpfProviderGotLocsNotify callback, gpointer user_data)
+{
+    HafasBin6CachedLocs *cached = g_new0 (HafasBin6CachedLocs, 1);
+
+    cached->self = g_object_ref (self);
+    cached->callback = callback;
+    cached->user_data = user_data;
+    cached->locs = locs;
+    cached->empty_ok = empty_ok;
+    g_idle_add (got_cached_locs, cached);
+}
+
+
 static gint
-lpf_provider_hafas_bin6_get_locs (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data)
+lpf_provider_hafas_bin6_get_locs_full (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, guint max_results, LpfProviderGotLocsNotify callback, gpointer user_data)
 {
     LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
     SoupMessage *msg;
@@ -254,24 +702,61 @@ lpf_provider_hafas_bin6_get_locs (LpfProvider *self, const char* match, LpfProvi
     gint ret = -1;
 
     g_return_val_if_fail (priv->session, -1);
-    g_return_val_if_fail (!flags, -1);
+    g_return_val_if_fail (!(flags & ~LOCS_TYPES), -1);
+
+    if (priv->locs_cache) {
+        GSList *locs;
+
+        if (hafas_bin6_locs_cache_lookup (priv->locs_cache, match, locs_types (flags),
+                                          max_results, g_get_real_time (), &locs)) {
+            cached_locs_idle_add (self, locs, FALSE, callback, user_data);
+            return 0;
+        }
+    }
+
+    /* Answer from the stations we already know if they match exactly */
+    if (priv->station_index && max_results &&
+        locs_types (flags) == LPF_PROVIDER_GET_LOCS_STATIONS) {
+        GSList *locs;
+
+        if (hafas_bin6_station_index_lookup (priv->station_index, match, max_results, &locs)) {
+            cached_locs_idle_add (self, locs, FALSE, callback, user_data);
+            return 0;
+        }
+        g_slist_free_full (locs, g_object_unref);
+    }
+
+    /* A station seen in an earlier trip by its exact name */
+    if (priv->station_db && max_results == 1 &&
+        locs_types (flags) == LPF_PROVIDER_GET_LOCS_STATIONS) {
+        guint32 id;
+
+        if (hafas_bin6_station_db_lookup_name (priv->station_db, match, &id, NULL, NULL)) {
+            LpfLoc *loc;
+
+            loc = lpf_provider_hafas_bin6_loc_new_from_station_id (LPF_PROVIDER_HAFAS_BIN6 (self), id);
+            cached_locs_idle_add (self, g_slist_prepend (NULL, loc), FALSE, callback, user_data);
+            return 0;
+        }
+    }
 
     locs_data = g_try_malloc(sizeof(LpfProviderGotItUserData));
     if (!locs_data)
         goto out;
-    xml = g_strdup_printf ("<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-                           "<ReqC ver=\"1.1\" prod=\"String\" lang=\"EN\">"
-                           "<MLcReq><MLc n=\"%s\" t=\"ST\"/>"
-                           "</MLcReq></ReqC>", match);
 
     msg = soup_message_new ("POST", lpf_provider_hafas_bin6_locs_url(LPF_PROVIDER_HAFAS_BIN6(self)));
     if (!msg)
         goto out;
+    /* The MLcReq has no result limit so we apply it while parsing */
+    xml = locs_request_new (&match, 1, locs_types (flags));
     soup_message_set_request (msg, "text/xml", SOUP_MEMORY_TAKE, xml, strlen (xml));
 
     locs_data->user_data = user_data;
     locs_data->callback = callback;
     locs_data->self = self;
+    locs_data->flags = flags;
+    locs_data->max_results = max_results;
+    locs_data->match = g_strdup (match);
 
     soup_session_queue_message (priv->session, msg, got_locs, locs_data);
     ret = 0;
@@ -282,337 +767,943 @@ lpf_provider_hafas_bin6_get_locs (LpfProvider *self, const char* match, LpfProvi
 }
 
 
-static GSList*
-hafas_bin6_parse_each_trip (const gchar *data, gsize num, guint base, const char *enc)
+static gint
+lpf_provider_hafas_bin6_get_locs (LpfProvider *self, const char* match, LpfProviderGetLocsFlags flags, LpfProviderGotLocsNotify callback, gpointer user_data)
 {
-    gint i, j, k;
-    const HafasBin6Trip *t;
-    const HafasBin6TripPartDetail *pd;
-    const HafasBin6TripPart *p;
-    const HafasBin6TripStop *stop;
-    guint16 day_off;
-
-#ifdef ENABLE_DEBUG
-    const HafasBin6TripDetail *d;
-#endif
-    guint h, m;
-    LpfTrip *trip = NULL;
-    LpfTripPart *part = NULL;
-    LpfStop *start = NULL, *end = NULL, *astop = NULL;
-    LpfTripStatusFlags status;
-    GDateTime *dt;
-    GSList *trips = NULL, *parts = NULL, *stops = NULL;
-    const char *line;
-
-    for (i = 0; i < num; i++) {
-        status = LPF_TRIP_STATUS_FLAGS_NONE;
-
-        /* The trips itself */
-        t = HAFAS_BIN6_TRIP(data, i);
-        day_off = lpf_provider_hafas_bin6_parse_service_day(data, i);
-
-        LPF_DEBUG("Trip #%d, Changes:            %4d", i, t->changes);
-#ifdef ENABLE_DEBUG
-        /* trip details */
-        d = HAFAS_BIN6_TRIP_DETAIL(data, i);
-        LPF_DEBUG("Trip #%d, Status:             %4d", i, d->rt_status);
-        LPF_DEBUG("Trip #%d, Delay:              %4d", i, d->delay);
-#endif
-        /* trip parts */
-        for (j = 0; j < t->part_cnt; j++) {
-            p = HAFAS_BIN6_TRIP_PART(data, i, j);
-            start = g_object_new(LPF_TYPE_STOP, NULL);
-            if (lpf_provider_hafas_bin6_parse_station(data, p->dep_off, LPF_LOC(start), enc) < 0) {
-                g_warning("Failed to parse start station %d/%d", i, j);
-                goto error;
-            }
-            end = g_object_new(LPF_TYPE_STOP, NULL);
-            if (lpf_provider_hafas_bin6_parse_station(data, p->arr_off, LPF_LOC(end), enc) < 0) {
-                g_warning("Failed to parse end station %d/%d", i, j);
-                goto error;
-            }
-            line = HAFAS_BIN6_STR(data, p->line_off);
+    return lpf_provider_hafas_bin6_get_locs_full (self, match, flags, 0, callback, user_data);
+}
 
-            h = p->dep / 100;
-            m = p->dep % 100;
-            dt = lpf_provider_hafas_bin6_date_time (base, day_off, h, m);
-            g_object_set (start, "departure", dt, NULL);
 
-            if (g_strcmp0 (HAFAS_BIN6_NO_PLATFORM, HAFAS_BIN6_STR(data, p->dep_pos_off))) {
-                g_object_set (start,
-                              "dep_plat", HAFAS_BIN6_STR(data, p->dep_pos_off),
-                              NULL);
-            }
+/* transfers data between a batch location lookup and its requests */
+typedef struct _HafasBin6LocsBatch {
+    LpfProviderHafasBin6 *self;
+    guint pending;      /* requests in flight */
+    LpfProviderGetLocsFlags types;
+    gchar **matches;
+    LpfProviderGotLocsBatchNotify locs_callback;
+    LpfProviderGotLocsNotify callback;
+    gpointer user_data;
+} HafasBin6LocsBatch;
 
-            h = p->arr / 100;
-            m = p->arr % 100;
-            dt = lpf_provider_hafas_bin6_date_time (base, day_off, h, m);
-            g_object_set (end, "arrival", dt, NULL);
+typedef struct _HafasBin6LocsBatchReq {
+    HafasBin6LocsBatch *batch;
+    guint first;        /* index of the first match in this request */
+    guint n;
+} HafasBin6LocsBatchReq;
 
-            if (g_strcmp0 (HAFAS_BIN6_NO_PLATFORM, HAFAS_BIN6_STR(data, p->arr_pos_off))) {
-                g_object_set (end,
-                              "arr_plat", HAFAS_BIN6_STR(data, p->arr_pos_off),
-                              NULL);
-            }
 
-            /* trip part details */
-            pd = HAFAS_BIN6_TRIP_PART_DETAIL(data, i, j);
+static void
+got_locs_batch (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+    HafasBin6LocsBatchReq *req = user_data;
+    HafasBin6LocsBatch *batch = req->batch;
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(batch->self);
+    GSList **results;
+    GError *err = NULL;
+    guint i;
 
-            LPF_DEBUG("Trip-Part #%d, Flags:            %4d", j, pd->flags);
-            if (pd->flags & HAFAS_BIN6_PART_DETAIL_FLAGS_CANCELED_MASK) {
-                status = LPF_TRIP_STATUS_FLAGS_CANCELED;
-            }
+    results = g_new0 (GSList*, req->n);
 
-            if (pd->arr_pred != HAFAS_BIN6_NO_REALTIME) {
-                h = pd->arr_pred / 100;
-                m = pd->arr_pred % 100;
-                dt = lpf_provider_hafas_bin6_date_time (base, day_off, h, m);
-                g_object_set (end, "rt_arrival", dt, NULL);
-            }
+    LPF_DEBUG("Status: %d", msg->status_code);
+    if (!SOUP_STATUS_IS_SUCCESSFUL(msg->status_code)) {
+        LPF_DEBUG("HTTP request failed");
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_REQUEST_FAILED,
+                     "Cannot get location: %s",
+                     soup_status_get_phrase(msg->status_code));
+        goto out;
+    }
 
-            if (pd->dep_pred != HAFAS_BIN6_NO_REALTIME) {
-                h = pd->dep_pred / 100;
-                m = pd->dep_pred % 100;
-                dt = lpf_provider_hafas_bin6_date_time (base, day_off, h, m);
-                g_object_set (start, "rt_departure", dt, NULL);
-            }
+    log_response_body (batch->self, msg, "station");
 
-            LPF_DEBUG("Trip #%d, part #%d, Pred. Dep Plat: %s, Pred. Arr Plat: %s", i, j,
-                      HAFAS_BIN6_STR(data, pd->dep_pos_pred_off),
-                      HAFAS_BIN6_STR(data, pd->arr_pos_pred_off));
-
-            for (k = 0; k < pd->stops_cnt; k++) {
-                stop = HAFAS_BIN6_STOP(data, i, j, k);
-
-                astop = g_object_new (LPF_TYPE_STOP,
-                                      "arrival", lpf_provider_hafas_bin6_date_time (base,
-                                                                                    day_off,
-                                                                                    stop->arr / 100,
-                                                                                    stop->arr % 100),
-                                      "departure", lpf_provider_hafas_bin6_date_time (base,
-                                                                                      day_off,
-                                                                                      stop->dep / 100,
-                                                                                      stop->dep % 100),
-                                      NULL
-                    );
-
-                if (lpf_provider_hafas_bin6_parse_station(data, stop->stop_idx, LPF_LOC(astop), enc) < 0) {
-                    g_warning("Failed to parse stop %d/%d", i, j);
-                    goto error;
-                }
+    if (!parse_locs_xml_multi (priv->locs_parser, msg->response_body->data,
+                               batch->types, 0, results, req->n)) {
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Failed to parse locations");
+        goto out;
+    }
 
-#ifdef ENABLE_DEBUG
-                /* FIXME: add these and predicted dep/arr/plat to LpfStop too */
-                LPF_DEBUG("Trip #%d, part #%d,"
-                          "Dep: %.6s Arr: %.6s", i, j,
-                          HAFAS_BIN6_STR(data, stop->dep_pos_off),
-                          HAFAS_BIN6_STR(data, stop->arr_pos_off));
-#endif
-                stops = g_slist_append (stops, astop);
-                astop = NULL;
-            }
-            part = g_object_new (LPF_TYPE_TRIP_PART,
-                                 "start", start,
-                                 "end", end,
-                                 "line", line,
-                                 "stops", stops,
-                                 NULL);
-            start = end = NULL;
-            line = NULL;
-            stops = NULL;
-
-            parts = g_slist_append (parts, part);
-            part = NULL;
-        }
+    for (i = 0; i < req->n; i++) {
+        locs_set_ids (LPF_PROVIDER (batch->self), results[i]);
+        remember_locs (priv, batch->matches[req->first + i], batch->types, 0, results[i]);
+    }
 
-        trip = g_object_new (LPF_TYPE_TRIP,
-                             "parts", parts,
-                             "status", status,
-                             NULL);
-        parts = NULL;
-        trips = g_slist_append (trips, trip);
-        trip = NULL;
+out:
+    for (i = 0; i < req->n; i++)
+        (*batch->locs_callback)(req->first + i, results[i], batch->user_data,
+                                err ? g_error_copy (err) : NULL);
+    g_clear_error (&err);
+    g_free (results);
+    g_free (req);
+
+    if (--batch->pending == 0) {
+        (*batch->callback)(NULL, batch->user_data, NULL);
+        g_strfreev (batch->matches);
+        g_free (batch);
     }
+}
 
-    return trips;
 
-error:
-    if (trips)
-        g_slist_free_full (trips, g_object_unref);
-    if (parts)
-        g_slist_free_full (parts, g_object_unref);
-    if (stops)
-        g_slist_free_full (stops, g_object_unref);
-    if (start)
-        g_object_unref (start);
-    if (trip)
-        g_object_unref (trip);
-    if (part)
-        g_object_unref (part);
-    if (astop)
-        g_object_unref (astop);
+/* transfers data between a progressive lookup and its callbacks */
+typedef struct _HafasBin6ProgressiveLocs {
+    LpfProvider *self;
+    LpfProviderGotLocsProgressNotify callback;
+    gpointer user_data;
+    GSList *locs;           /* preliminary locations */
+    guint source;           /* idle delivering them */
+} HafasBin6ProgressiveLocs;
 
-    return NULL;
+
+static gboolean
+got_preliminary_locs (gpointer user_data)
+{
+    HafasBin6ProgressiveLocs *progressive = user_data;
+
+    progressive->source = 0;
+    locs_set_ids (progressive->self, progressive->locs);
+    (*progressive->callback)(progressive->locs, FALSE, progressive->user_data, NULL);
+    progressive->locs = NULL;
+    return FALSE;
 }
 
 
-static GSList*
-hafas_binary_parse_trips (const char *data, gsize length, GError **err)
+static void
+progressive_locs_free (HafasBin6ProgressiveLocs *progressive)
 {
-    HafasBin6Header *header;
-#ifdef ENABLE_DEBUG
-    HafasBin6Loc *start, *end;
-#endif
-    HafasBin6ExtHeader *ext;
-    HafasBin6TripDetailsHeader *details;
-    GSList *trips = NULL;
-    guint16 version;
-    const gchar *encoding;
+    if (progressive->source)
+        g_source_remove (progressive->source);
+    g_slist_free_full (progressive->locs, g_object_unref);
+    g_free (progressive);
+}
 
-    g_return_val_if_fail (data, NULL);
+
+/* The final answer supersedes preliminary locations not delivered yet */
+static void
+got_final_locs (GSList *locs, gpointer user_data, GError *err)
+{
+    HafasBin6ProgressiveLocs *progressive = user_data;
+
+    (*progressive->callback)(locs, TRUE, progressive->user_data, err);
+    progressive_locs_free (progressive);
+}
+
+
+/* Answer from the station index first, then like get_locs_full */
+static gint
+lpf_provider_hafas_bin6_get_locs_progressive (LpfProvider *self,
+                                              const gchar *match,
+                                              LpfProviderGetLocsFlags flags,
+                                              guint max_results,
+                                              LpfProviderGotLocsProgressNotify callback,
+                                              gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    HafasBin6ProgressiveLocs *progressive;
+    GSList *locs = NULL;
+
+    g_return_val_if_fail (priv->session, -1);
+    g_return_val_if_fail (!(flags & ~LOCS_TYPES), -1);
+
+    progressive = g_new0 (HafasBin6ProgressiveLocs, 1);
+    progressive->self = self;
+    progressive->callback = callback;
+    progressive->user_data = user_data;
+
+    /* Cache hits and confident index lookups are final already */
+    if (priv->locs_cache &&
+        hafas_bin6_locs_cache_lookup (priv->locs_cache, match, locs_types (flags),
+                                      max_results, g_get_real_time (), &locs)) {
+        g_slist_free_full (locs, g_object_unref);
+    } else if (priv->station_index &&
+               locs_types (flags) == LPF_PROVIDER_GET_LOCS_STATIONS) {
+        if (!hafas_bin6_station_index_lookup (priv->station_index, match, max_results, &locs) && locs) {
+            progressive->locs = locs;
+            progressive->source = g_idle_add (got_preliminary_locs, progressive);
+        } else {
+            g_slist_free_full (locs, g_object_unref);
+        }
+    }
+
+    if (lpf_provider_hafas_bin6_get_locs_full (self, match, flags, max_results,
+                                               got_final_locs, progressive) < 0) {
+        progressive_locs_free (progressive);
+        return -1;
+    }
+    return 0;
+}
+
+
+/* Stations near a point are only looked up in the station index */
+static gint
+lpf_provider_hafas_bin6_get_locs_near (LpfProvider *self,
+                                       gdouble lon,
+                                       gdouble lat,
+                                       guint radius,
+                                       guint max_results,
+                                       LpfProviderGotLocsNotify callback,
+                                       gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    GSList *locs;
+
+    g_return_val_if_fail (priv->station_index, -1);
+
+    locs = hafas_bin6_station_index_nearest (priv->station_index, lon, lat,
+                                             radius, max_results);
+    cached_locs_idle_add (self, locs, TRUE, callback, user_data);
+    return 0;
+}
+
+
+/* Pack up to locs-batch-size matches into each request */
+static gint
+lpf_provider_hafas_bin6_get_locs_batch (LpfProvider *self,
+                                        const gchar * const *matches,
+                                        LpfProviderGetLocsFlags flags,
+                                        LpfProviderGotLocsBatchNotify locs_callback,
+                                        LpfProviderGotLocsNotify callback,
+                                        gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    HafasBin6LocsBatch *batch = NULL;
+    HafasBin6LocsBatchReq *req;
+    SoupMessage **msgs = NULL;
+    guint n, n_reqs, i;
+    char *xml;
+    gint ret = -1;
+
+    g_return_val_if_fail (priv->session, -1);
+    g_return_val_if_fail (!(flags & ~LOCS_TYPES), -1);
+
+    n = g_strv_length ((gchar **)matches);
+    n_reqs = (n + priv->locs_batch_size - 1) / priv->locs_batch_size;
+
+    /* Create all messages upfront so we either queue all or nothing */
+    msgs = g_new0 (SoupMessage*, n_reqs);
+    for (i = 0; i < n_reqs; i++) {
+        msgs[i] = soup_message_new ("POST", lpf_provider_hafas_bin6_locs_url(LPF_PROVIDER_HAFAS_BIN6(self)));
+        if (!msgs[i])
+            goto out;
+        xml = locs_request_new (matches + i * priv->locs_batch_size,
+                                MIN(priv->locs_batch_size, n - i * priv->locs_batch_size),
+                                locs_types (flags));
+        soup_message_set_request (msgs[i], "text/xml", SOUP_MEMORY_TAKE, xml, strlen (xml));
+    }
+
+    batch = g_new0 (HafasBin6LocsBatch, 1);
+    batch->self = LPF_PROVIDER_HAFAS_BIN6(self);
+    batch->pending = n_reqs;
+    batch->types = locs_types (flags);
+    batch->matches = g_strdupv ((gchar **)matches);
+    batch->locs_callback = locs_callback;
+    batch->callback = callback;
+    batch->user_data = user_data;
+
+    for (i = 0; i < n_reqs; i++) {
+        req = g_new0 (HafasBin6LocsBatchReq, 1);
+        req->batch = batch;
+        req->first = i * priv->locs_batch_size;
+        req->n = MIN(priv->locs_batch_size, n - req->first);
+        soup_session_queue_message (priv->session, msgs[i], got_locs_batch, req);
+        msgs[i] = NULL;
+    }
+    ret = 0;
+ out:
+    for (i = 0; i < n_reqs; i++) {
+        if (msgs[i])
+            g_object_unref (msgs[i]);
+    }
+    g_free (msgs);
+    return ret;
+}
+
+
+/* A station as decoded once per response */
+typedef struct _HafasBin6DecodedStation {
+    gchar *name;      /* UTF-8 */
+    gdouble lon, lat;
+    gchar *opaque;    /* usable as trip endpoint, shared by all stops */
+    guint32 id;
+} HafasBin6DecodedStation;
+
+
+static void
+decoded_station_free (gpointer data)
+{
+    HafasBin6DecodedStation *station = data;
+
+    g_free (station->name);
+    g_ref_string_release (station->opaque);
+    g_slice_free (HafasBin6DecodedStation, station);
+}
+
+
+/*
+ * The location id of a station as used in trip requests. It has
+ * the same format as the ids returned by location lookups. Only
+ * the station id is needed, the rest is informational.
+ */
+static gchar*
+station_opaque_new (guint32 id, const gchar *name, gint32 lon, gint32 lat)
+{
+    if (name == NULL || strchr (name, '@'))
+        return g_strdup_printf ("A=1@L=%09u@", id);
+    return g_strdup_printf ("A=1@O=%s@X=%d@Y=%d@L=%09u@", name, lon, lat, id);
+}
+
+
+/* Cache of decoded stations keyed by their index in the stations table */
+static GHashTable*
+station_cache_new (void)
+{
+    return g_hash_table_new_full (g_direct_hash, g_direct_equal,
+                                  NULL, decoded_station_free);
+}
+
+
+/* Decode the station of a stop unless it's in the cache already */
+static const HafasBin6DecodedStation*
+decode_station (GHashTable *stations, const HafasBin6StopView *sv)
+{
+    HafasBin6DecodedStation *station;
+    const HafasBin6Station *raw;
+    gchar *name, *opaque;
+
+    station = g_hash_table_lookup (stations, GUINT_TO_POINTER (sv->station_idx));
+    if (station)
+        return station;
+
+    if ((name = hafas_bin6_stop_view_get_name (sv)) == NULL) {
+        g_warning ("Failed to convert station name at %d", sv->station_idx);
+        return NULL;
+    }
+    LPF_DEBUG("name: %s", name);
+
+    raw = hafas_bin6_stop_view_get_station (sv);
+    station = g_slice_new (HafasBin6DecodedStation);
+    station->name = name;
+    station->lon = hafas_bin6_stop_view_get_long (sv);
+    station->lat = hafas_bin6_stop_view_get_lat (sv);
+    opaque = station_opaque_new (raw->id, name, raw->lon, raw->lat);
+    station->opaque = g_ref_string_new (opaque);
+    g_free (opaque);
+    station->id = raw->id;
+    g_hash_table_insert (stations, GUINT_TO_POINTER (sv->station_idx), station);
+    return station;
+}
+
+
+static LpfStop*
+hafas_bin6_build_stop (const HafasBin6StopView *sv, GHashTable *stations)
+{
+    const HafasBin6DecodedStation *station;
+    LpfStop *stop;
+
+    if ((station = decode_station (stations, sv)) == NULL)
+        return NULL;
+
+    stop = lpf_stop_new_full (station->name, station->lon, station->lat,
+                              hafas_bin6_stop_view_get_arrival_minutes (sv),
+                              hafas_bin6_stop_view_get_departure_minutes (sv),
+                              hafas_bin6_stop_view_get_rt_arrival_minutes (sv),
+                              hafas_bin6_stop_view_get_rt_departure_minutes (sv),
+                              hafas_bin6_stop_view_get_arr_plat (sv),
+                              hafas_bin6_stop_view_get_dep_plat (sv));
+    lpf_loc_set_opaque_full (LPF_LOC (stop), g_ref_string_acquire (station->opaque),
+                             (GDestroyNotify) g_ref_string_release);
+    if (sv->view->provider)
+        lpf_loc_set_id (LPF_LOC (stop), sv->view->provider, station->id);
+
+    return stop;
+}
+
+
+/* Comment codes mapped to flags */
+static const struct {
+    const gchar *code;
+    LpfTripPartAttrFlags flags;
+} note_codes[] = {
+    { "FB", LPF_TRIP_PART_ATTR_FLAGS_BICYCLES },
+    { "FK", LPF_TRIP_PART_ATTR_FLAGS_BICYCLES },
+    { "FR", LPF_TRIP_PART_ATTR_FLAGS_BICYCLES | LPF_TRIP_PART_ATTR_FLAGS_RESERVATION },
+    { "RZ", LPF_TRIP_PART_ATTR_FLAGS_RESERVATION },
+    { "EH", LPF_TRIP_PART_ATTR_FLAGS_ACCESSIBLE },
+    { "RO", LPF_TRIP_PART_ATTR_FLAGS_ACCESSIBLE },
+    { "KL", LPF_TRIP_PART_ATTR_FLAGS_AIR_CONDITIONING },
+};
+
+/* Comments look like "FB - Number of bicycles conveyed limited" */
+static LpfTripPartAttrFlags
+note_flags (const gchar *note)
+{
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (note_codes); i++) {
+        if (g_str_has_prefix (note, note_codes[i].code) &&
+            g_str_has_prefix (note + strlen (note_codes[i].code), " - "))
+            return note_codes[i].flags;
+    }
+    return LPF_TRIP_PART_ATTR_FLAGS_NONE;
+}
+
+
+/*
+ * The raw attributes and comments of a part. Keys and values come
+ * first, then the comments, all NUL terminated and in the encoding
+ * of the response.
+ */
+typedef struct _HafasBin6PartAttrs {
+    const gchar *enc;     /* interned */
+    HafasBin6Charset charset;
+    guint n_attrs;        /* key value pairs */
+    guint n_notes;
+    gchar strs[];
+} HafasBin6PartAttrs;
+
+
+/* Copy out what's needed to decode the part's attributes later on */
+static HafasBin6PartAttrs*
+part_attrs_new (const HafasBin6PartView *pv)
+{
+    HafasBin6PartAttrs *pa;
+    GString *strs = g_string_new (NULL);
+    const gchar *key, *val;
+    guint i, n, n_attrs = 0, n_notes = 0;
+
+    for (i = 0; hafas_bin6_part_view_get_attr (pv, i, &key, &val); i++) {
+        if (val == NULL)
+            continue;
+        g_string_append_len (strs, key, strlen (key) + 1);
+        g_string_append_len (strs, val, strlen (val) + 1);
+        n_attrs++;
+    }
+
+    n = hafas_bin6_part_view_get_n_comments (pv);
+    for (i = 0; i < n; i++) {
+        if ((key = hafas_bin6_part_view_get_comment (pv, i)) == NULL)
+            continue;
+        g_string_append_len (strs, key, strlen (key) + 1);
+        n_notes++;
+    }
+
+    pa = g_malloc (sizeof (HafasBin6PartAttrs) + strs->len);
+    pa->enc = g_intern_string (pv->view->enc);
+    pa->charset = pv->view->charset;
+    pa->n_attrs = n_attrs;
+    pa->n_notes = n_notes;
+    memcpy (pa->strs, strs->str, strs->len);
+    g_string_free (strs, TRUE);
+    return pa;
+}
+
+
+/* Convert the part's attributes and comments and attach them to part */
+static void
+load_part_attrs (LpfTripPart *part, gpointer data)
+{
+    const HafasBin6PartAttrs *pa = data;
+    LpfTripPartAttrFlags flags = LPF_TRIP_PART_ATTR_FLAGS_NONE;
+    GPtrArray *attrs = g_ptr_array_new_with_free_func (g_free);
+    GPtrArray *notes = g_ptr_array_new_with_free_func (g_free);
+    const gchar *str = pa->strs;
+    gchar *k, *v, *note;
+    guint i;
+
+    for (i = 0; i < pa->n_attrs; i++) {
+        k = hafas_bin6_to_utf8 (str, pa->charset, pa->enc, NULL);
+        str += strlen (str) + 1;
+        v = hafas_bin6_to_utf8 (str, pa->charset, pa->enc, NULL);
+        str += strlen (str) + 1;
+        if (k && v) {
+            g_ptr_array_add (attrs, k);
+            g_ptr_array_add (attrs, v);
+        } else {
+            g_free (k);
+            g_free (v);
+        }
+    }
+    g_ptr_array_add (attrs, NULL);
+
+    for (i = 0; i < pa->n_notes; i++) {
+        note = hafas_bin6_to_utf8 (str, pa->charset, pa->enc, NULL);
+        str += strlen (str) + 1;
+        if (note == NULL)
+            continue;
+        flags |= note_flags (note);
+        g_ptr_array_add (notes, note);
+    }
+    g_ptr_array_add (notes, NULL);
+
+    lpf_trip_part_set_attrs (part, flags,
+                             (const gchar * const *)attrs->pdata,
+                             (const gchar * const *)notes->pdata);
+    g_ptr_array_free (attrs, TRUE);
+    g_ptr_array_free (notes, TRUE);
+}
+
+
+static LpfTripPart*
+hafas_bin6_build_part (const HafasBin6PartView *pv, GHashTable *stations)
+{
+    HafasBin6StopView sv;
+    LpfStop *start = NULL, *end = NULL, *astop;
+    LpfTripPart *part;
+    GSList *stops = NULL;
+    guint k;
+
+    hafas_bin6_part_view_get_start (pv, &sv);
+    if ((start = hafas_bin6_build_stop (&sv, stations)) == NULL) {
+        g_warning("Failed to parse start station %d/%d", pv->trip_idx, pv->idx);
+        goto error;
+    }
+
+    hafas_bin6_part_view_get_end (pv, &sv);
+    if ((end = hafas_bin6_build_stop (&sv, stations)) == NULL) {
+        g_warning("Failed to parse end station %d/%d", pv->trip_idx, pv->idx);
+        goto error;
+    }
+
+    LPF_DEBUG("Trip-Part #%d, Flags:            %4d", pv->idx, pv->detail->flags);
+    LPF_DEBUG("Trip #%d, part #%d, Pred. Dep Plat: %s, Pred. Arr Plat: %s",
+              pv->trip_idx, pv->idx,
+              HAFAS_BIN6_VIEW_STR(pv->view, pv->detail->dep_pos_pred_off),
+              HAFAS_BIN6_VIEW_STR(pv->view, pv->detail->arr_pos_pred_off));
+
+    for (k = 0; k < hafas_bin6_part_view_get_n_stops (pv); k++) {
+        hafas_bin6_part_view_get_stop (pv, k, &sv);
+        if ((astop = hafas_bin6_build_stop (&sv, stations)) == NULL) {
+            g_warning("Failed to parse stop %d/%d", pv->trip_idx, pv->idx);
+            goto error;
+        }
+        stops = g_slist_prepend (stops, astop);
+    }
+    stops = g_slist_reverse (stops);
+
+    part = lpf_trip_part_new_take (start, end, hafas_bin6_part_view_get_line (pv), stops);
+
+    /*
+     * Most attributes are never looked at so only decode them on
+     * demand. Copying out the raw strings keeps the response from
+     * being held on to by every part.
+     */
+    lpf_trip_part_set_attrs_loader (part, load_part_attrs, part_attrs_new (pv), g_free);
+
+    return part;
+error:
+    if (stops)
+        g_slist_free_full (stops, g_object_unref);
+    if (start)
+        g_object_unref (start);
+    if (end)
+        g_object_unref (end);
+    return NULL;
+}
+
+
+/*
+ * Build the #LpfTrip object graph for the idx-th trip of view.
+ * Stations are decoded only once per response via the stations cache.
+ */
+static LpfTrip*
+hafas_bin6_build_trip (const HafasBin6View *view, guint idx, GHashTable *stations)
+{
+    HafasBin6TripView tv;
+    HafasBin6PartView pv;
+    LpfTripPart *part;
+    LpfTripStatusFlags status = LPF_TRIP_STATUS_FLAGS_NONE;
+    GSList *parts = NULL;
+    GDateTime *start;
+    GBytes *days;
+    guint j, first_day;
+
+    hafas_bin6_view_get_trip (view, idx, &tv);
+
+    LPF_DEBUG("Trip #%d, Changes:            %4d", idx, hafas_bin6_trip_view_get_changes (&tv));
+#ifdef ENABLE_DEBUG
+    /* trip details */
+    LPF_DEBUG("Trip #%d, Status:             %4d", idx, hafas_bin6_trip_view_get_detail (&tv)->rt_status);
+    LPF_DEBUG("Trip #%d, Delay:              %4d", idx, hafas_bin6_trip_view_get_detail (&tv)->delay);
+#endif
+
+    for (j = 0; j < hafas_bin6_trip_view_get_n_parts (&tv); j++) {
+        hafas_bin6_trip_view_get_part (&tv, j, &pv);
+        if (hafas_bin6_part_view_is_canceled (&pv))
+            status = LPF_TRIP_STATUS_FLAGS_CANCELED;
+
+        if ((part = hafas_bin6_build_part (&pv, stations)) == NULL) {
+            g_slist_free_full (parts, g_object_unref);
+            return NULL;
+        }
+        parts = g_slist_prepend (parts, part);
+    }
+    parts = g_slist_reverse (parts);
+
+    days = hafas_bin6_service_days (hafas_bin6_trip_view_get_service_day (&tv), &first_day);
+    start = lpf_provider_hafas_bin6_date_time (view->days, first_day, 0, 0);
+    return lpf_trip_new_take (parts, status, start, days);
+}
+
+
+/* Minimum number of trips handed to a worker thread */
+#define HAFAS_BIN6_TRIPS_PER_CHUNK 8
+
+/* A range of trips built by one worker thread */
+typedef struct _HafasBin6TripChunk {
+    const HafasBin6View *view;
+    guint first, last;        /* [first, last) */
+    LpfTrip **trips;          /* shared result array indexed by trip */
+    gboolean failed;
+} HafasBin6TripChunk;
+
+
+/*
+ * Build the trips of a chunk. Every chunk has its own station and
+ * iconv cache so no locking is needed, the results go to the chunk's
+ * slots of the shared array so the original order is kept.
+ */
+static void
+build_trip_chunk (gpointer data, gpointer user_data G_GNUC_UNUSED)
+{
+    HafasBin6TripChunk *chunk = data;
+    HafasBin6View view = *chunk->view;
+    GHashTable *stations = station_cache_new ();
+    guint i;
+
+    view.iconvs = hafas_bin6_iconv_cache_new ();
+    for (i = chunk->first; i < chunk->last; i++) {
+        if ((chunk->trips[i] = hafas_bin6_build_trip (&view, i, stations)) == NULL) {
+            chunk->failed = TRUE;
+            break;
+        }
+    }
+
+    g_hash_table_destroy (view.iconvs);
+    g_hash_table_destroy (stations);
+}
+
+
+/* Build the trips of view in n_chunks ranges on a thread pool */
+static LpfTripList*
+hafas_bin6_parse_trips_parallel (const HafasBin6View *view, guint n_chunks)
+{
+    HafasBin6TripChunk *chunks;
+    GThreadPool *pool;
+    LpfTrip **trips;
+    LpfTripList *ret = NULL;
+    GPtrArray *array;
+    gboolean failed = FALSE;
+    guint i, first = 0;
+    GError *err = NULL;
+
+    /* make sure type registration doesn't happen in the workers */
+    g_type_ensure (LPF_TYPE_TRIP);
+    g_type_ensure (LPF_TYPE_TRIP_PART);
+    g_type_ensure (LPF_TYPE_STOP);
+
+    pool = g_thread_pool_new (build_trip_chunk, NULL, n_chunks, FALSE, &err);
+    if (pool == NULL) {
+        g_warning ("Failed to create thread pool: %s", err->message);
+        g_clear_error (&err);
+        return NULL;
+    }
+
+    trips = g_new0 (LpfTrip*, view->num_trips);
+    chunks = g_new0 (HafasBin6TripChunk, n_chunks);
+    for (i = 0; i < n_chunks; i++) {
+        chunks[i].view = view;
+        chunks[i].trips = trips;
+        chunks[i].first = first;
+        chunks[i].last = first = (guint)((guint64)view->num_trips * (i + 1) / n_chunks);
+        g_thread_pool_push (pool, &chunks[i], NULL);
+    }
+    /* wait for all chunks to finish */
+    g_thread_pool_free (pool, FALSE, TRUE);
+
+    for (i = 0; i < n_chunks; i++)
+        failed |= chunks[i].failed;
+
+    array = g_ptr_array_new_full (view->num_trips, g_object_unref);
+    for (i = 0; i < view->num_trips; i++) {
+        if (trips[i])
+            g_ptr_array_add (array, trips[i]);
+    }
+    if (failed)
+        g_ptr_array_unref (array);
+    else
+        ret = lpf_trip_list_new_take (array);
+
+    g_free (chunks);
+    g_free (trips);
+    return ret;
+}
+
+
+/*
+ * Turn all trips of the view into #LpfTrip objects. Large responses
+ * are split across a thread pool, one chunk per processor.
+ */
+static LpfTripList*
+hafas_bin6_parse_each_trip (const HafasBin6View *view)
+{
+    GHashTable *stations;
+    GPtrArray *trips;
+    LpfTrip *trip;
+    guint i, n_chunks;
+
+    n_chunks = MIN (g_get_num_processors (),
+                    view->num_trips / HAFAS_BIN6_TRIPS_PER_CHUNK);
+    if (n_chunks > 1)
+        return hafas_bin6_parse_trips_parallel (view, n_chunks);
+
+    /* Build the list before handing it out so nobody gets signaled per trip */
+    stations = station_cache_new ();
+    trips = g_ptr_array_new_full (view->num_trips, g_object_unref);
+    for (i = 0; i < view->num_trips; i++) {
+        if ((trip = hafas_bin6_build_trip (view, i, stations)) == NULL) {
+            g_clear_pointer (&trips, g_ptr_array_unref);
+            break;
+        }
+        g_ptr_array_add (trips, trip);
+    }
+
+    g_hash_table_destroy (stations);
+    return trips ? lpf_trip_list_new_take (trips) : NULL;
+}
+
+
+/* Parse the trips in data, locations get ids in provider's namespace */
+static LpfTripList*
+parse_trips (const char *data, gsize length, const gchar *provider,
+             GHashTable *iconvs, GError **err)
+{
+    HafasBin6View view;
+    LpfTripList *trips = NULL;
+
+    g_return_val_if_fail (data, NULL);
     g_return_val_if_fail (length, NULL);
 
-    version = *(guint16*)data;
-    if (version != 6) {
+    if (!hafas_bin6_view_init (&view, data, length, err))
+        goto out;
+    /* validate once so building the trips needs no further checks */
+    if (!hafas_bin6_view_check (&view, err))
+        goto out;
+    view.iconvs = iconvs;
+    view.provider = provider;
+
+    trips = hafas_bin6_parse_each_trip (&view);
+    g_return_val_if_fail (trips, NULL);
+ out:
+    return trips;
+}
+
+
+static LpfTripList*
+hafas_binary_parse_trips (const char *data, gsize length, GHashTable *iconvs, GError **err)
+{
+    return parse_trips (data, length, NULL, iconvs, err);
+}
+
+/* gzip stores the uncompressed size modulo 2^32 in the last four bytes */
+static gsize
+gzip_isize (const gchar *in, gsize inlen)
+{
+    guint32 isize;
+
+    /* 10 bytes header, 8 bytes trailer */
+    if (inlen < 18)
+        return 0;
+
+    memcpy (&isize, in + inlen - sizeof (isize), sizeof (isize));
+    return GUINT32_FROM_LE (isize);
+}
+
+#ifdef HAVE_LIBDEFLATE
+static gboolean
+inflate_gzip (const gchar *in, gsize inlen, gchar *out, gsize outlen, GError **err)
+{
+    struct libdeflate_decompressor *decomp;
+    enum libdeflate_result res;
+
+    decomp = libdeflate_alloc_decompressor ();
+    if (decomp == NULL) {
         g_set_error (err,
                      LPF_PROVIDER_ERROR,
                      LPF_PROVIDER_ERROR_PARSE_FAILED,
-                     "Incorrect Hafas Binary version %d", version);
-        goto out;
+                     "Failed to allocate decompressor");
+        return FALSE;
     }
 
-    g_return_val_if_fail(sizeof (HafasBin6Header) < length, NULL);
-    header = (HafasBin6Header*) data;
-#ifdef ENABLE_DEBUG
-    start = (HafasBin6Loc*)&header->start;
-    end = (HafasBin6Loc*)&header->end;
-#endif
-    LPF_DEBUG("%d Trips from '%s' to '%s'",
-              header->num_trips,
-              HAFAS_BIN6_STR(data, start->name_off),
-              HAFAS_BIN6_STR(data, end->name_off));
-
-    g_return_val_if_fail ((sizeof (HafasBin6Header) +
-                           sizeof(HafasBin6Header) * header->num_trips) < length,
-                          NULL);
-
-    ext = HAFAS_BIN6_EXT_HEADER(data);
-    g_return_val_if_fail (header->ext +
-                          sizeof(HafasBin6ExtHeader) < length, NULL);
-
-    /* We might not have attrs_index0 */
-    g_return_val_if_fail(sizeof (HafasBin6ExtHeader) - 1 < ext->length, NULL);
-
-    LPF_DEBUG("Ext length:       0x%.4x", ext->length);
-    LPF_DEBUG("Errors:           0x%.4x", ext->err);
-    LPF_DEBUG("Sequence:         0x%.4x", ext->seq);
-    LPF_DEBUG("Detail table:     0x%.4x", ext->details_tbl);
-    encoding = HAFAS_BIN6_STR(data,  ext->enc_off);
-    LPF_DEBUG("Encoding: %s", encoding);
-    LPF_DEBUG("Request Id: %s", HAFAS_BIN6_STR(data, ext->req_id_off));
-
-    if (ext->err) {
+    /* without actual_out the output must fill outlen exactly */
+    res = libdeflate_gzip_decompress (decomp, in, inlen, out, outlen, NULL);
+    libdeflate_free_decompressor (decomp);
+
+    if (res != LIBDEFLATE_SUCCESS) {
         g_set_error (err,
                      LPF_PROVIDER_ERROR,
                      LPF_PROVIDER_ERROR_PARSE_FAILED,
-                     "Hafas Blob has error code %d", ext->err);
-        goto out;
+                     "Failed to decompress: libdeflate error %d", res);
+        return FALSE;
     }
+    return TRUE;
+}
+#elif defined (HAVE_ZLIB)
+static gboolean
+inflate_gzip (const gchar *in, gsize inlen, gchar *out, gsize outlen, GError **err)
+{
+    z_stream zs;
+    gint res;
+    gboolean ret = FALSE;
 
-    if (ext->seq <= 0) {
+    memset (&zs, 0, sizeof (zs));
+    /* +16: expect a gzip header */
+    if (inflateInit2 (&zs, 16 + MAX_WBITS) != Z_OK) {
         g_set_error (err,
                      LPF_PROVIDER_ERROR,
                      LPF_PROVIDER_ERROR_PARSE_FAILED,
-                     "Illegal sequence number %d", ext->seq);
-        goto out;
+                     "Failed to initialize decompressor");
+        return FALSE;
     }
 
-    g_return_val_if_fail (ext->details_tbl +
-                          sizeof (HafasBin6TripDetailsHeader) < length, NULL);
-    details = HAFAS_BIN6_TRIP_DETAILS_HEADER(data);
-    LPF_DEBUG("Trip detail version: %d", details->version);
-    g_return_val_if_fail (details->version == 1, NULL);
-    g_return_val_if_fail (details->stop_size == sizeof(HafasBin6TripStop), NULL);
-    g_return_val_if_fail (details->part_detail_size == sizeof(HafasBin6TripPartDetail), NULL);
+    zs.next_in = (Bytef *)in;
+    zs.avail_in = inlen;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = outlen;
 
-    trips = hafas_bin6_parse_each_trip (data, header->num_trips, header->days, encoding);
-    g_return_val_if_fail (trips, NULL);
+    res = inflate (&zs, Z_FINISH);
+    if (res != Z_STREAM_END || zs.avail_out != 0) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Failed to decompress: %s",
+                     zs.msg ? zs.msg : "size mismatch");
+        goto out;
+    }
+    ret = TRUE;
  out:
-    return trips;
+    inflateEnd (&zs);
+    return ret;
 }
+#else
+static gboolean
+inflate_gzip (const gchar *in, gsize inlen, gchar *out, gsize outlen, GError **err)
+{
+    GConverter *decomp;
+    GConverterResult conv;
+    gsize read_, written;
+    gboolean ret = FALSE;
 
+    decomp = (GConverter *)g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+    conv = g_converter_convert (decomp,
+                                in, inlen,
+                                out, outlen,
+                                G_CONVERTER_INPUT_AT_END,
+                                &read_, &written,
+                                err);
+    switch (conv) {
+    case G_CONVERTER_ERROR:
+        goto out;
+    case G_CONVERTER_FINISHED:
+        if (written == outlen) {
+            ret = TRUE;
+            break;
+        }
+        /* fallthrough */
+    default:
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Failed to decompress: size mismatch");
+        break;
+    }
+ out:
+    g_object_unref (decomp);
+    return ret;
+}
+#endif
+
+/*
+ * Decompress a gzipped response in one go. The output buffer is
+ * sized according to the gzip trailer so no reallocation is needed.
+ */
 static gint
 decompress (const gchar *in, gsize inlen,
             gchar **out, gsize *outlen,
             GError **err) {
-    gint ret = -1;
-    gsize read_, written;
-    GConverter *decomp = NULL;
-    GConverterResult conv;
-    gsize outbuflen, buflen, outpos = 0, inpos = 0;
-    gchar *outbuf = NULL;
+    gsize outbuflen;
+    gchar *outbuf;
 
-    g_return_val_if_fail (inlen > 0, ret);
-    g_return_val_if_fail (in, ret);
-    g_return_val_if_fail (err, ret);
+    g_return_val_if_fail (inlen > 0, -1);
+    g_return_val_if_fail (in, -1);
+    g_return_val_if_fail (err, -1);
 
-    decomp = (GConverter *)g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+    outbuflen = gzip_isize (in, inlen);
+    /* deflate can't compress better than 1032:1, don't trust bogus trailers */
+    if (outbuflen == 0 || outbuflen / 1032 > inlen) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Invalid gzip size %" G_GSIZE_FORMAT, outbuflen);
+        return -1;
+    }
 
-    outbuflen = buflen = inlen * 2;
     outbuf = g_try_malloc (outbuflen);
-    if (outbuf == NULL)
-        goto out;
+    if (outbuf == NULL) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Cannot allocate %" G_GSIZE_FORMAT " bytes", outbuflen);
+        return -1;
+    }
 
-    do {
-        conv = g_converter_convert (decomp,
-                                    (in + inpos), inlen,
-                                    (outbuf + outpos), buflen,
-                                    G_CONVERTER_INPUT_AT_END,
-                                    &read_, &written,
-                                    err);
+    if (!inflate_gzip (in, inlen, outbuf, outbuflen, err)) {
+        g_free (outbuf);
+        return -1;
+    }
 
-        switch (conv) {
-        case G_CONVERTER_ERROR:
-                goto out;
-        case G_CONVERTER_FINISHED:
-            outpos += written;
-            ret = 0;
-            goto out;
-        case G_CONVERTER_CONVERTED:
-            outpos += written;
-            inpos += read_;
-            inlen -= read_;
-            if (outbuflen - written < buflen) {
-                outbuflen += buflen;
-                outbuf = g_try_realloc (outbuf, outbuflen);
-                if (outbuf == NULL)
-                    goto out;
-            }
-            break;
-        case G_CONVERTER_FLUSHED:
-        default:
-            g_warning ("Unhandled condition %d", conv);
-            goto out;
-        }
-    } while (TRUE);
+    *out = outbuf;
+    *outlen = outbuflen;
+    return 0;
+}
 
-out:
-    if (ret == 0) {
-        *out = outbuf;
-        *outlen = outpos;
-    } else
-        g_free (outbuf);
+/* Feed the stations passed by trips into the station index and database */
+static void
+remember_trip_stops (LpfProviderHafasBin6Private *priv, LpfTripList *trips)
+{
+    GSList *p, *ends;
+    LpfTripPart *part;
+    guint i;
 
-    g_object_unref (decomp);
-    return ret;
+    if (priv->station_index == NULL && priv->station_db == NULL)
+        return;
+
+    for (i = 0; i < lpf_trip_list_get_length (trips); i++) {
+        for (p = lpf_trip_get_parts (lpf_trip_list_get (trips, i)); p; p = g_slist_next (p)) {
+            part = LPF_TRIP_PART (p->data);
+            ends = g_slist_prepend (NULL, lpf_trip_part_get_end (part));
+            ends = g_slist_prepend (ends, lpf_trip_part_get_start (part));
+            if (priv->station_index) {
+                hafas_bin6_station_index_add_locs (priv->station_index, ends);
+                hafas_bin6_station_index_add_locs (priv->station_index, lpf_trip_part_get_stops (part));
+            }
+            if (priv->station_db) {
+                station_db_add_locs (priv, ends);
+                station_db_add_locs (priv, lpf_trip_part_get_stops (part));
+            }
+            g_slist_free_full (ends, g_object_unref);
+        }
+    }
 }
 
+
 static void
 got_trips (SoupSession *session, SoupMessage *msg, gpointer user_data)
 {
-    GSList *trips = NULL;
+    LpfTripList *trips = NULL;
     LpfProviderGotItUserData *trips_data = (LpfProviderGotItUserData*)user_data;
-    LpfProviderGotTripsNotify callback;
+    LpfProviderGotTripListNotify callback;
     LpfProviderHafasBin6 *self;
     gpointer data;
     gchar *decomp = NULL;
@@ -647,7 +1738,9 @@ got_trips (SoupSession *session, SoupMessage *msg, gpointer user_data)
     }
 
     LPF_DEBUG("Decompressed to %" G_GSIZE_FORMAT " bytes", len);
-    if ((trips = hafas_binary_parse_trips(decomp, len, &err)) == NULL) {
+    if ((trips = parse_trips (decomp, len,
+                              provider_name (LPF_PROVIDER (self)),
+                              GET_PRIVATE(self)->iconvs, &err)) == NULL) {
         if (err == NULL) {
             g_set_error (&err,
                          LPF_PROVIDER_ERROR,
@@ -656,6 +1749,7 @@ got_trips (SoupSession *session, SoupMessage *msg, gpointer user_data)
         }
         goto out;
     }
+    remember_trip_stops (GET_PRIVATE(self), trips);
 
 out:
     g_object_unref (msg);
@@ -665,20 +1759,257 @@ out:
 }
 
 
-static gint
-lpf_provider_hafas_bin6_get_trips (LpfProvider *self,
-                                   LpfLoc *start,
-                                   LpfLoc *end,
-                                   GDateTime *date,
-                                   LpfProviderGetTripsFlags flags,
-                                   LpfProviderGotTripsNotify callback,
-                                   gpointer user_data)
+/* incremental inflate and parse state of a streamed trips response */
+typedef struct _HafasBin6TripStream {
+    GConverter *decomp;
+    GByteArray *buf;        /* decompressed data received so far */
+    gboolean inflated;      /* decompressor saw the end of the data */
+    gboolean have_view;
+    HafasBin6View view;
+    guint next_trip;        /* next trip to hand out */
+    GHashTable *stations;   /* decoded stations */
+    GHashTable *iconvs;
+    const gchar *provider;  /* name used for the stops' ids, might be NULL */
+    LpfProviderGotTripNotify trip_callback;
+    gpointer user_data;
+} HafasBin6TripStream;
+
+
+static HafasBin6TripStream*
+trip_stream_new (GHashTable *iconvs, LpfProviderGotTripNotify trip_callback, gpointer user_data)
 {
-    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
-    SoupMessage *msg;
+    HafasBin6TripStream *stream = g_new0 (HafasBin6TripStream, 1);
+
+    stream->iconvs = iconvs;
+    stream->decomp = (GConverter *)g_zlib_decompressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP);
+    stream->buf = g_byte_array_new ();
+    stream->stations = station_cache_new ();
+    stream->trip_callback = trip_callback;
+    stream->user_data = user_data;
+    return stream;
+}
+
+
+static void
+trip_stream_free (HafasBin6TripStream *stream)
+{
+    g_object_unref (stream->decomp);
+    g_byte_array_free (stream->buf, TRUE);
+    g_hash_table_destroy (stream->stations);
+    g_free (stream);
+}
+
+
+/* Hand out all trips that are completely available */
+static gboolean
+trip_stream_deliver (HafasBin6TripStream *stream, gboolean at_end, GError **err)
+{
+    const gchar *data = (const gchar*)stream->buf->data;
+    gsize len = stream->buf->len;
+    LpfTrip *trip;
+
+    if (stream->have_view) {
+        /* the buffer might have moved while growing */
+        hafas_bin6_view_rebase (&stream->view, data, len);
+    } else {
+        if (!at_end && !hafas_bin6_view_headers_available (data, len))
+            return TRUE;
+        if (len == 0) {
+            g_set_error (err,
+                         LPF_PROVIDER_ERROR,
+                         LPF_PROVIDER_ERROR_PARSE_FAILED,
+                         "Empty Hafas blob");
+            return FALSE;
+        }
+        if (!hafas_bin6_view_init (&stream->view, data, len, err))
+            return FALSE;
+        stream->view.iconvs = stream->iconvs;
+        stream->view.provider = stream->provider;
+        stream->have_view = TRUE;
+    }
+
+    while (stream->next_trip < stream->view.num_trips) {
+        if (!hafas_bin6_view_trip_available (&stream->view, stream->next_trip)) {
+            if (!at_end)
+                break;
+            g_set_error (err,
+                         LPF_PROVIDER_ERROR,
+                         LPF_PROVIDER_ERROR_PARSE_FAILED,
+                         "Truncated Hafas blob at trip %d", stream->next_trip);
+            return FALSE;
+        }
+        /* attributes are decoded right away so wait for them too */
+        if (!at_end && !hafas_bin6_view_trip_extras_available (&stream->view, stream->next_trip))
+            break;
+
+        if ((trip = hafas_bin6_build_trip (&stream->view, stream->next_trip, stream->stations)) == NULL) {
+            g_set_error (err,
+                         LPF_PROVIDER_ERROR,
+                         LPF_PROVIDER_ERROR_PARSE_FAILED,
+                         "Failed to parse trip %d", stream->next_trip);
+            return FALSE;
+        }
+        stream->next_trip++;
+        (*stream->trip_callback)(trip, stream->user_data);
+    }
+    return TRUE;
+}
+
+
+/* Inflate the next chunk of compressed data and hand out new trips */
+static gboolean
+trip_stream_feed (HafasBin6TripStream *stream, const gchar *in, gsize inlen, GError **err)
+{
+    GConverterResult conv;
+    GError *error = NULL;
+    gsize read_, written, room, pos = 0;
+    guint oldlen;
+
+    if (stream->inflated || inlen == 0)
+        return TRUE;
+
+    do {
+        room = MAX (2 * (inlen - pos), 4096);
+        oldlen = stream->buf->len;
+        g_byte_array_set_size (stream->buf, oldlen + room);
+
+        conv = g_converter_convert (stream->decomp,
+                                    in + pos, inlen - pos,
+                                    stream->buf->data + oldlen, room,
+                                    G_CONVERTER_NO_FLAGS,
+                                    &read_, &written,
+                                    &error);
+        if (conv == G_CONVERTER_ERROR)
+            written = 0;
+        g_byte_array_set_size (stream->buf, oldlen + written);
+
+        switch (conv) {
+        case G_CONVERTER_ERROR:
+            /* all input consumed */
+            if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT)) {
+                g_clear_error (&error);
+                goto deliver;
+            }
+            g_propagate_error (err, error);
+            return FALSE;
+        case G_CONVERTER_FINISHED:
+            stream->inflated = TRUE;
+            goto deliver;
+        case G_CONVERTER_CONVERTED:
+            pos += read_;
+            break;
+        case G_CONVERTER_FLUSHED:
+        default:
+            g_warning ("Unhandled condition %d", conv);
+            g_set_error (err,
+                         LPF_PROVIDER_ERROR,
+                         LPF_PROVIDER_ERROR_PARSE_FAILED,
+                         "Failed to decompress trips");
+            return FALSE;
+        }
+    /* a full output buffer might leave data in the decompressor */
+    } while (pos < inlen || written == room);
+
+ deliver:
+    return trip_stream_deliver (stream, FALSE, err);
+}
+
+
+/* All data received, hand out the remaining trips */
+static gboolean
+trip_stream_finish (HafasBin6TripStream *stream, GError **err)
+{
+    if (!stream->inflated) {
+        g_set_error (err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_PARSE_FAILED,
+                     "Truncated compressed Hafas blob");
+        return FALSE;
+    }
+
+    LPF_DEBUG("Decompressed to %u bytes", stream->buf->len);
+    return trip_stream_deliver (stream, TRUE, err);
+}
+
+
+/* transfers data between the streaming invocation and the passed in callbacks */
+typedef struct _LpfProviderHafasBin6StreamData {
+    LpfProvider *self;
+    HafasBin6TripStream *stream;
+    LpfProviderGotTripsNotify callback;
+    gpointer user_data;
+    GError *err;            /* first error while receiving the data */
+} LpfProviderHafasBin6StreamData;
+
+
+static void
+got_trips_chunk (SoupMessage *msg, SoupBuffer *chunk, gpointer user_data)
+{
+    LpfProviderHafasBin6StreamData *stream_data = user_data;
+
+    if (stream_data->err || !SOUP_STATUS_IS_SUCCESSFUL(msg->status_code))
+        return;
+
+    if (!trip_stream_feed (stream_data->stream, chunk->data, chunk->length, &stream_data->err))
+        LPF_DEBUG("Streaming trips failed: %s", stream_data->err->message);
+}
+
+
+static void
+got_trips_stream (SoupSession *session, SoupMessage *msg, gpointer user_data)
+{
+    LpfProviderHafasBin6StreamData *stream_data = user_data;
+    LpfProviderHafasBin6Private *priv;
+    GError *err = NULL;
+
+    g_return_if_fail(session);
+    g_return_if_fail(msg);
+    g_return_if_fail(user_data);
+
+    LPF_DEBUG("Status: %d", msg->status_code);
+    if (!SOUP_STATUS_IS_SUCCESSFUL(msg->status_code)) {
+        g_set_error (&err,
+                     LPF_PROVIDER_ERROR,
+                     LPF_PROVIDER_ERROR_REQUEST_FAILED,
+                     "Cannot get trips: %s",
+                     soup_status_get_phrase(msg->status_code));
+    } else if (stream_data->err) {
+        err = stream_data->err;
+    } else {
+        trip_stream_finish (stream_data->stream, &err);
+    }
+
+    priv = GET_PRIVATE(stream_data->self);
+    if (priv->station_index || priv->station_db) {
+        HafasBin6DecodedStation *station;
+        GHashTableIter iter;
+
+        g_hash_table_iter_init (&iter, stream_data->stream->stations);
+        while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&station)) {
+            if (priv->station_index)
+                hafas_bin6_station_index_add (priv->station_index, station->name,
+                                              station->lon, station->lat, station->opaque);
+            if (priv->station_db)
+                station_db_add (priv, station->id, station->name, station->lon, station->lat);
+        }
+    }
+
+    trip_stream_free (stream_data->stream);
+    (*stream_data->callback)(NULL, stream_data->user_data, err);
+    g_free (stream_data);
+}
+
+
+/* Build the request for trips from start to end */
+static SoupMessage*
+trips_message_new (LpfProvider *self,
+                   LpfLoc *start,
+                   LpfLoc *end,
+                   GDateTime *date,
+                   LpfProviderGetTripsFlags flags)
+{
+    SoupMessage *msg = NULL;
     SoupURI *uri = NULL;
-    LpfProviderGotItUserData *trips_data = NULL;
-    gint ret = -1;
     gchar *datestr = NULL, *timestr = NULL;
     /* allowed vehicle types */
     const gchar *train_restriction = "11111111111111";
@@ -686,29 +2017,15 @@ lpf_provider_hafas_bin6_get_trips (LpfProvider *self,
     const gchar *by_departure;
     char *start_id = NULL, *end_id = NULL;
 
-    g_return_val_if_fail (start, -1);
-    g_return_val_if_fail (end, -1);
-    g_return_val_if_fail (callback, -1);
-    g_return_val_if_fail (priv->session, -1);
-    g_return_val_if_fail (date, -1);
-
-    g_object_ref (start);
-    g_object_ref (end);
-    g_date_time_ref (date);
-
-    trips_data = g_try_malloc(sizeof(LpfProviderGotItUserData));
-    if (!trips_data)
-        goto out;
-
-    datestr = g_date_time_format (date, "%d.%m.%y");
-    timestr = g_date_time_format (date, "%H:%M");
-
     start_id = lpf_loc_get_opaque(start);
     end_id = lpf_loc_get_opaque(end);
     if (start_id == NULL || end_id == NULL) {
         g_warning ("Details missing.");
         goto out;
     }
+
+    datestr = g_date_time_format (date, "%d.%m.%y");
+    timestr = g_date_time_format (date, "%H:%M");
     by_departure = (flags & LPF_PROVIDER_GET_TRIPS_ARRIVAL) ? "0" : "1";
 
     uri = soup_uri_new (lpf_provider_hafas_bin6_trips_url(LPF_PROVIDER_HAFAS_BIN6(self)));
@@ -727,6 +2044,40 @@ lpf_provider_hafas_bin6_get_trips (LpfProvider *self,
     LPF_DEBUG ("URI: %s", soup_uri_to_string (uri, FALSE));
 
     msg = soup_message_new_from_uri ("GET", uri);
+ out:
+    if (uri)
+        soup_uri_free (uri);
+    g_free (datestr);
+    g_free (timestr);
+    return msg;
+}
+
+
+static gint
+lpf_provider_hafas_bin6_get_trip_list (LpfProvider *self,
+                                       LpfLoc *start,
+                                       LpfLoc *end,
+                                       GDateTime *date,
+                                       LpfProviderGetTripsFlags flags,
+                                       LpfProviderGotTripListNotify callback,
+                                       gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    SoupMessage *msg;
+    LpfProviderGotItUserData *trips_data = NULL;
+    gint ret = -1;
+
+    g_return_val_if_fail (start, -1);
+    g_return_val_if_fail (end, -1);
+    g_return_val_if_fail (callback, -1);
+    g_return_val_if_fail (priv->session, -1);
+    g_return_val_if_fail (date, -1);
+
+    trips_data = g_try_malloc(sizeof(LpfProviderGotItUserData));
+    if (!trips_data)
+        goto out;
+
+    msg = trips_message_new (self, start, end, date, flags);
     if (!msg)
         goto out;
 
@@ -737,26 +2088,150 @@ lpf_provider_hafas_bin6_get_trips (LpfProvider *self,
     soup_session_queue_message (priv->session, msg, got_trips, trips_data);
     ret = 0;
  out:
-    soup_uri_free (uri);
-    g_free (datestr);
-    g_free (timestr);
-    g_object_unref (start);
-    g_object_unref (end);
-    g_date_time_unref (date);
     if (ret < 0)
         g_free (trips_data);
     return ret;
 }
 
 
+static gint
+lpf_provider_hafas_bin6_get_trips_stream (LpfProvider *self,
+                                          LpfLoc *start,
+                                          LpfLoc *end,
+                                          GDateTime *date,
+                                          LpfProviderGetTripsFlags flags,
+                                          LpfProviderGotTripNotify trip_callback,
+                                          LpfProviderGotTripsNotify callback,
+                                          gpointer user_data)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    SoupMessage *msg;
+    LpfProviderHafasBin6StreamData *stream_data;
+
+    g_return_val_if_fail (start, -1);
+    g_return_val_if_fail (end, -1);
+    g_return_val_if_fail (trip_callback, -1);
+    g_return_val_if_fail (callback, -1);
+    g_return_val_if_fail (priv->session, -1);
+    g_return_val_if_fail (date, -1);
+
+    msg = trips_message_new (self, start, end, date, flags);
+    if (!msg)
+        return -1;
+
+    stream_data = g_new0 (LpfProviderHafasBin6StreamData, 1);
+    stream_data->self = self;
+    stream_data->stream = trip_stream_new (priv->iconvs, trip_callback, user_data);
+    stream_data->stream->provider = provider_name (LPF_PROVIDER (self));
+    stream_data->callback = callback;
+    stream_data->user_data = user_data;
+
+    /* Inflate and parse as data arrives instead of keeping the whole body */
+    soup_message_body_set_accumulate (msg->response_body, FALSE);
+    g_signal_connect (msg, "got-chunk", G_CALLBACK (got_trips_chunk), stream_data);
+
+    soup_session_queue_message (priv->session, msg, got_trips_stream, stream_data);
+    return 0;
+}
+
+
+/* Warm start from the lookups of the last run */
+static void
+locs_cache_load (LpfProviderHafasBin6Private *priv)
+{
+    gchar *cachefile;
+    GError *err = NULL;
+
+    cachefile = g_build_filename (priv->logdir, HAFAS_BIN6_LOCS_CACHE_FILE, NULL);
+    if (g_file_test (cachefile, G_FILE_TEST_EXISTS) &&
+        !hafas_bin6_locs_cache_load (priv->locs_cache, cachefile, g_get_real_time (), &err)) {
+        LPF_DEBUG ("Failed to load location cache: %s", err->message);
+        g_clear_error (&err);
+    }
+    g_free (cachefile);
+}
+
+
+/* The database of stations seen in trip responses */
+static void
+station_db_open (LpfProviderHafasBin6Private *priv)
+{
+    gchar *dbfile;
+    GError *err = NULL;
+
+    dbfile = g_build_filename (priv->logdir, HAFAS_BIN6_STATION_DB_FILE, NULL);
+    priv->station_db = hafas_bin6_station_db_new (dbfile);
+    if (!hafas_bin6_station_db_load (priv->station_db, &err)) {
+        LPF_DEBUG ("Failed to load station database: %s", err->message);
+        g_clear_error (&err);
+    }
+    g_free (dbfile);
+}
+
+
+static void
+station_db_close (LpfProviderHafasBin6Private *priv)
+{
+    GError *err = NULL;
+
+    if (priv->station_db_sync_id) {
+        g_source_remove (priv->station_db_sync_id);
+        priv->station_db_sync_id = 0;
+    }
+
+    if (priv->station_db == NULL)
+        return;
+
+    if (!hafas_bin6_station_db_sync (priv->station_db, &err)) {
+        g_warning ("Failed to write station database: %s", err->message);
+        g_clear_error (&err);
+    }
+    hafas_bin6_station_db_free (priv->station_db);
+    priv->station_db = NULL;
+}
+
+
 static void
 lpf_provider_hafas_bin6_set_property (GObject *object, guint prop_id,
                                       const GValue *value, GParamSpec *pspec)
 {
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(object);
+    gboolean persist;
+
     switch (prop_id) {
     case PROP_NAME:
 	g_warn_if_reached ();
         break;
+    case PROP_LOCS_BATCH_SIZE:
+        priv->locs_batch_size = g_value_get_uint (value);
+        break;
+    case PROP_LOCS_CACHE_SIZE:
+        priv->locs_cache_size = g_value_get_uint (value);
+        if (priv->locs_cache)
+            hafas_bin6_locs_cache_set_max_entries (priv->locs_cache, priv->locs_cache_size);
+        break;
+    case PROP_LOCS_CACHE_TTL:
+        priv->locs_cache_ttl = g_value_get_uint (value);
+        if (priv->locs_cache)
+            hafas_bin6_locs_cache_set_ttl (priv->locs_cache,
+                                           (gint64)priv->locs_cache_ttl * G_USEC_PER_SEC);
+        break;
+    case PROP_LOCS_CACHE_PERSIST:
+        persist = g_value_get_boolean (value);
+        if (persist && !priv->locs_cache_persist && priv->locs_cache)
+            locs_cache_load (priv);
+        priv->locs_cache_persist = persist;
+        break;
+    case PROP_STATION_DB_ENABLED:
+        priv->station_db_enabled = g_value_get_boolean (value);
+        /* only open or close the database while activated */
+        if (priv->logdir == NULL)
+            break;
+        if (priv->station_db_enabled && priv->station_db == NULL)
+            station_db_open (priv);
+        else if (!priv->station_db_enabled)
+            station_db_close (priv);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
@@ -768,16 +2243,71 @@ static void
 lpf_provider_hafas_bin6_get_property (GObject *object, guint prop_id,
                                       GValue *value, GParamSpec *pspec)
 {
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(object);
+
     switch (prop_id) {
     case PROP_NAME:
         g_value_set_string (value, PROVIDER_NAME);
         break;
+    case PROP_LOCS_BATCH_SIZE:
+        g_value_set_uint (value, priv->locs_batch_size);
+        break;
+    case PROP_LOCS_CACHE_SIZE:
+        g_value_set_uint (value, priv->locs_cache_size);
+        break;
+    case PROP_LOCS_CACHE_TTL:
+        g_value_set_uint (value, priv->locs_cache_ttl);
+        break;
+    case PROP_LOCS_CACHE_PERSIST:
+        g_value_set_boolean (value, priv->locs_cache_persist);
+        break;
+    case PROP_STATION_DB_ENABLED:
+        g_value_set_boolean (value, priv->station_db_enabled);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
         break;
     }
 }
 
+/**
+ * lpf_provider_hafas_bin6_loc_new_from_station_id:
+ * @self: a #LpfProviderHafasBin6
+ * @id: a HAFAS station id
+ *
+ * Build a location that can be used as trip endpoint right away.
+ * Name and position are filled in if the station is in the
+ * station database.
+ *
+ * Returns: (transfer full): a new #LpfLoc
+ */
+LpfLoc*
+lpf_provider_hafas_bin6_loc_new_from_station_id (LpfProviderHafasBin6 *self, guint32 id)
+{
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    const gchar *name = NULL;
+    gint32 lon = 0, lat = 0;
+    LpfLoc *loc;
+
+    if (priv->station_db)
+        hafas_bin6_station_db_lookup_id (priv->station_db, id, &name, &lon, &lat);
+
+    loc = lpf_loc_new_full (name ? name : "",
+                            HAFAS_BIN6_LL_DOUBlE (lon),
+                            HAFAS_BIN6_LL_DOUBlE (lat));
+    lpf_loc_set_opaque (loc, station_opaque_new (id, name, lon, lat));
+    lpf_loc_set_id (loc, provider_name (LPF_PROVIDER (self)), id);
+    return loc;
+}
+
+
+static LpfLoc*
+lpf_provider_hafas_bin6_loc_new_from_id (LpfProvider *self, guint32 id)
+{
+    return lpf_provider_hafas_bin6_loc_new_from_station_id (LPF_PROVIDER_HAFAS_BIN6 (self), id);
+}
+
+
 gint
 lpf_provider_hafas_bin6_parse_station(const gchar *data, guint16 off, LpfLoc *loc, const char *enc)
 {
@@ -788,11 +2318,10 @@ lpf_provider_hafas_bin6_parse_station(const gchar *data, guint16 off, LpfLoc *lo
 
     station = HAFAS_BIN6_STATION(data, off);
 
-    name = g_convert (HAFAS_BIN6_STR(data, station->name_off),
-                      -1,
-                      "utf-8",
-                      enc,
-                      NULL, NULL, NULL);
+    name = hafas_bin6_to_utf8 (HAFAS_BIN6_STR(data, station->name_off),
+                               hafas_bin6_charset_from_name (enc),
+                               enc,
+                               NULL);
     if (name == NULL) {
         g_warning ("Failed to convert station name at %d", off);
         goto err;
@@ -803,6 +2332,8 @@ lpf_provider_hafas_bin6_parse_station(const gchar *data, guint16 off, LpfLoc *lo
     LPF_DEBUG("name: %s", name);
     g_object_set (loc, "name", name, "long", lon, "lat", lat,
                   NULL);
+    g_free (lpf_loc_get_opaque (loc));
+    lpf_loc_set_opaque (loc, station_opaque_new (station->id, name, station->lon, station->lat));
     ret = 0;
 err:
     g_free (name);
@@ -818,30 +2349,28 @@ err:
 guint
 lpf_provider_hafas_bin6_parse_service_day (const char *data, int idx)
 {
-    gint i;
-    gchar bits;
-    guint off;
-    const HafasBin6ServiceDay *s;
-
-    s = HAFAS_BIN6_SERVICE_DAY(data, idx);
-    off = s->byte_base * 8;
+    return hafas_bin6_service_day_offset (HAFAS_BIN6_SERVICE_DAY(data, idx));
+}
 
-    /* look at all service bytes */
-    for (i = 0; i < s->byte_len; i++) {
-        bits = (&(s->byte0))[i];
-        if (bits == 0) { /* zero means +8 days */
-            off += 8;
-            continue;
-        }
+/* Days from the Unix epoch to 1979-12-31, day 0 of hafas bin 6 */
+#define HAFAS_BIN6_EPOCH_DAYS 3651
 
-        /* count leading zeros meaning +1 day */
-        while ((bits & 0x80) == 0) {
-            bits <<= 1;
-            off++;
-        }
-        break;
-    }
-    return off;
+/**
+ * lpf_provider_hafas_bin6_minutes:
+ * @base_days: day off set from 1980-01-01
+ * @off_days: day offset from base_days
+ * @hours: hour trip starts/ends
+ * @minutes: minute the trip starts/ends
+ *
+ * Calculate date and time from hafas bin 6 input without going
+ * through #GDateTime
+ *
+ * Returns: the travel date and time in minutes since the Unix epoch
+ */
+gint32
+lpf_provider_hafas_bin6_minutes(guint base_days, guint off_days, guint hours, guint min)
+{
+    return ((HAFAS_BIN6_EPOCH_DAYS + base_days + off_days) * 24 + hours) * 60 + min;
 }
 
 /**
@@ -858,14 +2387,9 @@ lpf_provider_hafas_bin6_parse_service_day (const char *data, int idx)
 GDateTime*
 lpf_provider_hafas_bin6_date_time(guint base_days, guint off_days, guint hours, guint min)
 {
-    GDateTime *dt, *base = g_date_time_new_utc (1979, 12, 31, 0, 0, 0);
+    gint64 t = lpf_provider_hafas_bin6_minutes (base_days, off_days, hours, min);
 
-    dt = g_date_time_add (base,
-                          (base_days + off_days) * G_TIME_SPAN_DAY +
-                          hours * G_TIME_SPAN_HOUR +
-                          min * G_TIME_SPAN_MINUTE);
-    g_date_time_unref (base);
-    return dt;
+    return g_date_time_new_from_unix_utc (t * 60);
 }
 
 static void
@@ -880,6 +2404,8 @@ lpf_provider_hafas_bin6_activate (LpfProvider *self, GObject *obj)
 #else
     priv->session = soup_session_async_new();
 #endif
+    priv->iconvs = hafas_bin6_iconv_cache_new ();
+    priv->locs_parser = locs_parser_new ();
     priv->logdir = g_build_path(G_DIR_SEPARATOR_S,
                                 g_get_user_cache_dir(),
                                 PACKAGE,
@@ -899,6 +2425,15 @@ lpf_provider_hafas_bin6_activate (LpfProvider *self, GObject *obj)
     g_file_make_directory_with_parents (dir, NULL, NULL);
     g_object_unref (dir);
 
+    priv->locs_cache = hafas_bin6_locs_cache_new (priv->locs_cache_size,
+                                                  (gint64)priv->locs_cache_ttl * G_USEC_PER_SEC);
+    if (priv->locs_cache_persist)
+        locs_cache_load (priv);
+
+    priv->station_index = hafas_bin6_station_index_new (HAFAS_BIN6_STATION_INDEX_SIZE);
+
+    if (priv->station_db_enabled)
+        station_db_open (priv);
 }
 
 
@@ -906,11 +2441,30 @@ static void
 lpf_provider_hafas_bin6_deactivate (LpfProvider *self, GObject *obj)
 {
     LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+    gchar *cachefile;
+    GError *err = NULL;
+
+    g_clear_object (&priv->session);
+
+    if (priv->locs_cache && priv->locs_cache_persist && priv->locs_cache_size) {
+        cachefile = g_build_filename (priv->logdir, HAFAS_BIN6_LOCS_CACHE_FILE, NULL);
+        if (!hafas_bin6_locs_cache_save (priv->locs_cache, cachefile, g_get_real_time (), &err)) {
+            g_warning ("Failed to save location cache: %s", err->message);
+            g_clear_error (&err);
+        }
+        g_free (cachefile);
+    }
+    hafas_bin6_locs_cache_free (priv->locs_cache);
+    priv->locs_cache = NULL;
+    hafas_bin6_station_index_free (priv->station_index);
+    priv->station_index = NULL;
 
-    if (priv->session)
-        g_object_unref (priv->session);
+    station_db_close (priv);
 
     g_free (priv->logdir);
+    priv->logdir = NULL;
+    g_clear_pointer (&priv->iconvs, g_hash_table_destroy);
+    g_clear_pointer (&priv->locs_parser, xmlFreeParserCtxt);
 }
 
 
@@ -930,6 +2484,52 @@ lpf_provider_hafas_bin6_class_init (LpfProviderHafasBin6Class *klass)
     g_object_class_override_property (object_class,
                                       PROP_NAME,
                                       "name");
+
+    g_object_class_install_property (object_class,
+                                     PROP_LOCS_BATCH_SIZE,
+                                     g_param_spec_uint ("locs-batch-size",
+                                                        "Locations batch size",
+                                                        "Maximum number of matches per location request",
+                                                        1,
+                                                        HAFAS_BIN6_MAX_LOCS_BATCH_SIZE,
+                                                        HAFAS_BIN6_LOCS_BATCH_SIZE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (object_class,
+                                     PROP_LOCS_CACHE_SIZE,
+                                     g_param_spec_uint ("locs-cache-size",
+                                                        "Locations cache size",
+                                                        "Number of location lookups to remember, 0 to disable",
+                                                        0,
+                                                        G_MAXUINT,
+                                                        HAFAS_BIN6_LOCS_CACHE_SIZE,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (object_class,
+                                     PROP_LOCS_CACHE_TTL,
+                                     g_param_spec_uint ("locs-cache-ttl",
+                                                        "Locations cache TTL",
+                                                        "Seconds a location lookup is remembered",
+                                                        0,
+                                                        G_MAXUINT,
+                                                        HAFAS_BIN6_LOCS_CACHE_TTL,
+                                                        G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (object_class,
+                                     PROP_LOCS_CACHE_PERSIST,
+                                     g_param_spec_boolean ("locs-cache-persist",
+                                                           "Persist locations cache",
+                                                           "Whether to keep the location cache on disk between runs",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (object_class,
+                                     PROP_STATION_DB_ENABLED,
+                                     g_param_spec_boolean ("station-db-enabled",
+                                                           "Station database",
+                                                           "Whether to keep the stations of trip responses on disk",
+                                                           FALSE,
+                                                           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 }
 
 static void
@@ -941,10 +2541,22 @@ lpf_provider_hafas_bin6_interface_init (LpfProviderInterface *iface)
 
     /* To be implemented by each provider */
     iface->get_locs = lpf_provider_hafas_bin6_get_locs;
-    iface->get_trips = lpf_provider_hafas_bin6_get_trips;
+    iface->get_trip_list = lpf_provider_hafas_bin6_get_trip_list;
+    iface->get_trips_stream = lpf_provider_hafas_bin6_get_trips_stream;
+    iface->get_locs_batch = lpf_provider_hafas_bin6_get_locs_batch;
+    iface->get_locs_full = lpf_provider_hafas_bin6_get_locs_full;
+    iface->get_locs_near = lpf_provider_hafas_bin6_get_locs_near;
+    iface->get_locs_progressive = lpf_provider_hafas_bin6_get_locs_progressive;
+    iface->loc_new_from_id = lpf_provider_hafas_bin6_loc_new_from_id;
 }
 
 static void
 lpf_provider_hafas_bin6_init (LpfProviderHafasBin6 *self)
 {
+    LpfProviderHafasBin6Private *priv = GET_PRIVATE(self);
+
+    priv->locs_batch_size = HAFAS_BIN6_LOCS_BATCH_SIZE;
+    priv->locs_cache_size = HAFAS_BIN6_LOCS_CACHE_SIZE;
+    priv->locs_cache_ttl = HAFAS_BIN6_LOCS_CACHE_TTL;
+    priv->locs_cache_persist = FALSE;
 }
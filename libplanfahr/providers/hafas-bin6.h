@@ -53,7 +53,9 @@ typedef struct {
 GType lpf_provider_hafas_bin6_get_type (void);
 
 gint lpf_provider_hafas_bin6_parse_station(const gchar *data, guint16 off, LpfLoc *station, const char *enc);
+LpfLoc *lpf_provider_hafas_bin6_loc_new_from_station_id (LpfProviderHafasBin6 *self, guint32 id);
 guint lpf_provider_hafas_bin6_parse_service_day (const char *data, int idx);
+gint32 lpf_provider_hafas_bin6_minutes(guint base_days, guint off_days, guint hours, guint min);
 GDateTime* lpf_provider_hafas_bin6_date_time(guint base_days, guint off_days, guint hours, guint min);
 
 /* Pure virtual methods */
@@ -69,7 +69,7 @@ typedef struct _LpfProviderTestTestPrivate LpfProviderTestTestPrivate;
 
 struct _LpfProviderTestTestPrivate {
     GSList *locs;
-    GSList *trips;
+    LpfTripList *trips;
     gboolean debug;
 };
 
@@ -106,8 +106,9 @@ got_locs (gpointer user_data)
     for (loclist = priv->locs; loclist; loclist = g_slist_next (loclist)) {
         loc = loclist->data;
         if (strstr (name, lpf_loc_get_name(loc)))
-            locs = g_slist_append (locs, loc);
+            locs = g_slist_prepend (locs, g_object_ref (loc));
     }
+    locs = g_slist_reverse (locs);
 
     (*callback)(locs, data, err);
     return FALSE;
@@ -145,9 +146,9 @@ lpf_provider_test_test_get_locs (LpfProvider *self,
 static gboolean
 got_trips (gpointer user_data)
 {
-    GSList *trips = NULL;
+    LpfTripList *trips;
     LpfProviderGotItUserData *trips_data = (LpfProviderGotItUserData*)user_data;
-    LpfProviderGotTripsNotify callback;
+    LpfProviderGotTripListNotify callback;
     LpfProviderTestTest *self;
     gpointer data;
     GError *err = NULL;
@@ -164,9 +165,13 @@ got_trips (gpointer user_data)
     end = trips_data->end;
     g_free (trips_data);
 
+    trips = lpf_trip_list_new (0);
     if (!g_strcmp0 (lpf_loc_get_name(start), "testloc1") &&
         !g_strcmp0 (lpf_loc_get_name(end), "testloc2")) {
-        trips = priv->trips;
+        guint i;
+
+        for (i = 0; i < lpf_trip_list_get_length (priv->trips); i++)
+            lpf_trip_list_add (trips, g_object_ref (lpf_trip_list_get (priv->trips, i)));
     }
 
     (*callback)(trips, data, err);
@@ -175,13 +180,13 @@ got_trips (gpointer user_data)
 
 
 static gint
-lpf_provider_test_test_get_trips (LpfProvider *self,
-                                  LpfLoc *start,
-                                  LpfLoc *end,
-                                  GDateTime *date,
-                                  LpfProviderGetTripsFlags flags,
-                                  LpfProviderGotTripsNotify callback,
-                                  gpointer user_data)
+lpf_provider_test_test_get_trip_list (LpfProvider *self,
+                                      LpfLoc *start,
+                                      LpfLoc *end,
+                                      GDateTime *date,
+                                      LpfProviderGetTripsFlags flags,
+                                      LpfProviderGotTripListNotify callback,
+                                      gpointer user_data)
 {
     LpfProviderGotItUserData *trips_data = NULL;
     LpfProviderTestTestPrivate *priv = GET_PRIVATE(self);
@@ -270,8 +275,7 @@ lpf_provider_test_test_deactivate (LpfProvider *self, GObject *obj G_GNUC_UNUSED
     if (priv->locs)
         g_slist_free_full (priv->locs, g_object_unref);
 
-    if (priv->trips)
-        g_slist_free_full (priv->trips, g_object_unref);
+    g_clear_object (&priv->trips);
 }
 
 
@@ -302,7 +306,7 @@ lpf_provider_test_test_interface_init (LpfProviderInterface *iface)
 
     /* To be implemented by each provider */
     iface->get_locs = lpf_provider_test_test_get_locs;
-    iface->get_trips = lpf_provider_test_test_get_trips;
+    iface->get_trip_list = lpf_provider_test_test_get_trip_list;
 }
 
 static void
@@ -316,15 +320,17 @@ lpf_provider_test_test_init (LpfProviderTestTest *self)
 
     /* For now we just add two boring locations */
     loc = LPF_LOC(g_object_new (LPF_TYPE_LOC, "name", "testloc1", "long", 3.14, "lat", 15.0, NULL));
-    priv->locs = g_slist_append(priv->locs, loc);
+    priv->locs = g_slist_prepend(priv->locs, loc);
     loc = LPF_LOC(g_object_new (LPF_TYPE_LOC, "name", "testloc2", "long", 2.71, "lat", 82.0, NULL));
-    priv->locs = g_slist_append(priv->locs, loc);
+    priv->locs = g_slist_prepend(priv->locs, loc);
+    priv->locs = g_slist_reverse(priv->locs);
 
     /* For now we have single trip with just enough data to identify it */
     part = g_object_new(LPF_TYPE_TRIP_PART, "line", "at the end of the longest", NULL);
-    parts = g_slist_append (parts, part);
+    parts = g_slist_prepend (parts, part);
     trip = g_object_new(LPF_TYPE_TRIP, "parts", parts, NULL);
-    priv->trips = g_slist_append (priv->trips, trip);
+    priv->trips = lpf_trip_list_new (1);
+    lpf_trip_list_add (priv->trips, trip);
 }
 
 LpfProviderTestTest *
@@ -0,0 +1,446 @@
+/*
+ * hafas-bin6-writer.c: write synthetic hafas binary format version 6 data
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+/*
+ * The inverse of the layouts in hafas-bin6-format.h. Tables that are
+ * referenced via 16 bit offsets (attributes, strings) go first, the
+ * ones that grow with the number of trips (stops, parts) go last:
+ *
+ *   header | trips | attrs | comments | service days | strings |
+ *   stations | ext header | trip attrs index | details header |
+ *   details index | details | stops | parts
+ *
+ * Trip details and part details share the index so each trip gets a
+ * record of a #HafasBin6TripDetail followed by its part details.
+ */
+
+#include <string.h>
+#include <gio/gio.h>
+
+#include "../hafas-bin6-format.h"
+#include "hafas-bin6-writer.h"
+
+#define NO_TIME 0xFFFF
+/* Number of distinct lines, attribute lists are shared per line */
+#define N_LINES 16
+/* Number of distinct platforms */
+#define N_PLATFORMS 12
+
+static const gchar *places[] = {
+    "Köln", "Düsseldorf", "Gießen", "Bonn", "Münster",
+    "Erpel", "Unkel", "Linz", "Bad Honnef", "Königswinter",
+};
+
+static const gchar *notes[] = {
+    "FB - Number of bicycles conveyed limited",
+    "KL - air conditioning",
+};
+
+typedef struct _Writer {
+    const HafasBin6WriterParams *params;
+    GByteArray *strings;
+    GHashTable *offsets;    /* UTF-8 string -> offset + 1 */
+    gboolean overflow;
+} Writer;
+
+
+/* Add a string converted to the target encoding unless already there */
+static guint16
+add_str (Writer *w, const gchar *str)
+{
+    gpointer off;
+    gchar *conv;
+    gsize len;
+
+    if ((off = g_hash_table_lookup (w->offsets, str)) != NULL)
+        return GPOINTER_TO_UINT (off) - 1;
+
+    conv = g_convert_with_fallback (str, -1, w->params->encoding, "UTF-8",
+                                    "?", NULL, &len, NULL);
+    if (conv == NULL) {
+        conv = g_strdup (str);
+        len = strlen (str);
+    }
+
+    off = GUINT_TO_POINTER (w->strings->len + 1);
+    if (w->strings->len + len + 1 > G_MAXUINT16)
+        w->overflow = TRUE;
+    g_byte_array_append (w->strings, (guint8*)conv, len + 1);
+    g_hash_table_insert (w->offsets, g_strdup (str), off);
+    g_free (conv);
+    return GPOINTER_TO_UINT (off) - 1;
+}
+
+
+static guint16
+add_fmt (Writer *w, const gchar *fmt, guint n)
+{
+    gchar *str = g_strdup_printf (fmt, n);
+    guint16 off = add_str (w, str);
+
+    g_free (str);
+    return off;
+}
+
+
+static void
+append (GByteArray *a, gconstpointer data, gsize len)
+{
+    g_byte_array_append (a, data, len);
+}
+
+
+/* minutes since midnight to hafas HHMM notation */
+static guint16
+hhmm (guint min)
+{
+    return (min / 60) * 100 + min % 60;
+}
+
+
+/**
+ * hafas_bin6_writer_station_name:
+ * @idx: index into the stations table
+ *
+ * Returns: (transfer full): the UTF-8 name of the @idx-th station
+ */
+gchar*
+hafas_bin6_writer_station_name (guint idx)
+{
+    return g_strdup_printf ("%s %u", places[idx % G_N_ELEMENTS (places)], idx);
+}
+
+
+/* Station the k-th stop (0 being the part's start) of a part is at */
+static guint16
+station_idx (const HafasBin6WriterParams *p, guint trip, guint part, guint k)
+{
+    return (trip * 7 + part * (p->n_stops + 1) + k) % p->n_stations;
+}
+
+
+/**
+ * hafas_bin6_writer_build:
+ * @params: shape of the response
+ * @err: #GError
+ *
+ * Build an uncompressed response that parses like one from a hafas
+ * server. Stations, lines and times follow a fixed pattern so the
+ * parsed trips can be checked.
+ *
+ * Returns: (transfer full): the response or %NULL if it doesn't fit
+ *   the format's limits
+ */
+GBytes*
+hafas_bin6_writer_build (const HafasBin6WriterParams *params, GError **err)
+{
+    Writer w = { params, NULL, NULL, FALSE };
+    GByteArray *out, *trips, *attrs, *comments, *service, *stations;
+    GByteArray *trip_attrs, *details, *stops, *parts;
+    HafasBin6Header header;
+    HafasBin6ExtHeader ext;
+    HafasBin6TripDetailsHeader dh;
+    HafasBin6Loc loc;
+    guint16 line_attrs[N_LINES], trip_attrs_idx, plat[N_PLATFORMS + 1];
+    guint16 no_comments, with_comments, val;
+    guint32 stations_pos, comments_pos, service_pos, strings_pos, attrs_pos;
+    guint32 ext_pos, details_pos, parts_pos;
+    guint record_size, i, j, k, n_stops = 0;
+    gchar *name;
+
+    g_return_val_if_fail (params->n_trips > 0 && params->n_parts > 0, NULL);
+    g_return_val_if_fail (params->n_stations > 0, NULL);
+
+    record_size = sizeof (HafasBin6TripDetail) + params->n_parts * sizeof (HafasBin6TripPartDetail);
+    if (params->n_trips > G_MAXUINT16 ||
+        params->n_stations > G_MAXUINT16 ||
+        params->n_parts > G_MAXUINT16 ||
+        (guint64)params->n_trips * params->n_parts * params->n_stops > G_MAXUINT16 ||
+        sizeof (HafasBin6TripDetailsHeader) + 2 * params->n_trips +
+        (guint64)params->n_trips * record_size > G_MAXUINT16) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     "Too many trips, parts or stops for 16 bit offsets");
+        return NULL;
+    }
+
+    w.strings = g_byte_array_new ();
+    w.offsets = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+    out = g_byte_array_new ();
+    trips = g_byte_array_new ();
+    attrs = g_byte_array_new ();
+    comments = g_byte_array_new ();
+    service = g_byte_array_new ();
+    stations = g_byte_array_new ();
+    trip_attrs = g_byte_array_new ();
+    details = g_byte_array_new ();
+    stops = g_byte_array_new ();
+    parts = g_byte_array_new ();
+
+    /* offset 0 is the empty attribute key and "no platform" */
+    add_str (&w, HAFAS_BIN6_NO_PLATFORM);
+    for (i = 0; i <= N_PLATFORMS; i++)
+        plat[i] = i ? add_fmt (&w, "%u", i) : 0;
+
+    /* attribute lists, one per line followed by one per trip */
+    for (i = 0; i < N_LINES; i++) {
+        HafasBin6Attr a[] = {
+            { add_str (&w, "Operator"), add_str (&w, "Synthetic Rail") },
+            { add_str (&w, "Number"), add_fmt (&w, "%u", 10000 + i) },
+            { add_str (&w, "Direction"), add_fmt (&w, "Direction %u", i) },
+            { 0, 0 },
+        };
+        line_attrs[i] = attrs->len / sizeof (HafasBin6Attr);
+        append (attrs, a, sizeof (a));
+    }
+    trip_attrs_idx = attrs->len / sizeof (HafasBin6Attr);
+    for (i = 0; i < params->n_trips; i++) {
+        HafasBin6Attr a[] = {
+            { add_str (&w, "ConnectionId"), add_fmt (&w, "C0-%u", i) },
+            { 0, 0 },
+        };
+        val = trip_attrs_idx + 2 * i;
+        append (trip_attrs, &val, sizeof (val));
+        append (attrs, a, sizeof (a));
+    }
+
+    /* comments: an empty list and one with all notes */
+    no_comments = comments->len;
+    val = 0;
+    append (comments, &val, sizeof (val));
+    with_comments = comments->len;
+    val = G_N_ELEMENTS (notes);
+    append (comments, &val, sizeof (val));
+    for (i = 0; i < G_N_ELEMENTS (notes); i++) {
+        val = add_str (&w, notes[i]);
+        append (comments, &val, sizeof (val));
+    }
+
+    for (i = 0; i < params->n_stations; i++) {
+        HafasBin6Station s;
+
+        name = hafas_bin6_writer_station_name (i);
+        s.name_off = add_str (&w, name);
+        s.id = 8000000 + i;
+        s.lon = 7000000 + i * 100;
+        s.lat = 50000000 + i * 100;
+        append (stations, &s, sizeof (s));
+        g_free (name);
+    }
+
+    /* trip details index is followed by the trip's records */
+    memset (&dh, 0, sizeof (dh));
+    dh.version = 1;
+    dh.details_index_off = sizeof (dh);
+    dh.part_details_off = dh.details_index_off + sizeof (HafasBin6TripDetail);
+    dh.part_detail_size = sizeof (HafasBin6TripPartDetail);
+    dh.stop_size = sizeof (HafasBin6TripStop);
+    append (details, &dh, sizeof (dh));
+    for (i = 0; i < params->n_trips; i++) {
+        val = 2 * params->n_trips + i * record_size;
+        append (details, &val, sizeof (val));
+    }
+
+    for (i = 0; i < params->n_trips; i++) {
+        HafasBin6Trip t;
+        HafasBin6TripDetail td = { HAFAS_BIN6_RTSTATUS_NORMAL, 0 };
+        guint8 sd[sizeof (HafasBin6ServiceDay)];
+        guint min = 6 * 60 + i * 10;
+
+        /* trip i runs on day i % 8 */
+        memset (sd, 0, sizeof (sd));
+        ((HafasBin6ServiceDay*)sd)->byte_len = 1;
+        ((HafasBin6ServiceDay*)sd)->byte0 = 0x80 >> (i % 8);
+
+        t.service_off = service->len;
+        t.parts_off = parts->len; /* relocated below */
+        t.part_cnt = params->n_parts;
+        t.changes = params->n_parts - 1;
+        t.unknown0 = 0;
+        append (service, sd, sizeof (sd));
+        append (trips, &t, sizeof (t));
+        append (details, &td, sizeof (td));
+
+        for (j = 0; j < params->n_parts; j++) {
+            HafasBin6TripPart tp;
+            HafasBin6TripPartDetail pd;
+            guint line = (i + j) % N_LINES;
+
+            memset (&tp, 0, sizeof (tp));
+            memset (&pd, 0, sizeof (pd));
+            tp.dep = hhmm (min);
+            tp.dep_off = station_idx (params, i, j, 0);
+            tp.type = 2;
+            tp.line_off = add_fmt (&w, "RB %u", 10000 + line);
+            tp.dep_pos_off = plat[1 + (i + j) % N_PLATFORMS];
+            tp.attr_index = line_attrs[line];
+            tp.comments_off = (j % 2) ? no_comments : with_comments;
+
+            pd.dep_pred = (i % 3) ? NO_TIME : hhmm (min + 1);
+            pd.stop_index = n_stops;
+            pd.stops_cnt = params->n_stops;
+
+            for (k = 1; k <= params->n_stops; k++) {
+                HafasBin6TripStop s;
+
+                memset (&s, 0, sizeof (s));
+                min += 2;
+                s.arr = hhmm (min);
+                s.dep = hhmm (min + 1);
+                s.arr_pos_off = s.dep_pos_off = plat[1 + k % N_PLATFORMS];
+                s.arr_pred = s.dep_pred = NO_TIME;
+                s.stop_idx = station_idx (params, i, j, k);
+                append (stops, &s, sizeof (s));
+                min++;
+                n_stops++;
+            }
+
+            min += 2;
+            tp.arr = hhmm (min);
+            tp.arr_off = station_idx (params, i, j, params->n_stops + 1);
+            tp.arr_pos_off = plat[1 + (i + j + 1) % N_PLATFORMS];
+            pd.arr_pred = NO_TIME;
+            /* change trains */
+            min += 5;
+
+            append (parts, &tp, sizeof (tp));
+            append (details, &pd, sizeof (pd));
+        }
+    }
+
+    memset (&ext, 0, sizeof (ext));
+    ext.length = sizeof (ext);
+    ext.seq = 1;
+    ext.req_id_off = add_str (&w, "synthetic");
+    ext.enc_off = add_str (&w, params->encoding);
+    ext.ld_off = add_str (&w, "synthetic");
+
+    if (w.overflow) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     "Strings table exceeds 16 bit offsets");
+        g_byte_array_unref (out);
+        out = NULL;
+        goto out;
+    }
+
+    /* lay out the tables */
+    attrs_pos = sizeof (HafasBin6Header) + trips->len;
+    comments_pos = attrs_pos + attrs->len;
+    service_pos = comments_pos + comments->len;
+    strings_pos = service_pos + service->len;
+    stations_pos = strings_pos + w.strings->len;
+    ext_pos = stations_pos + stations->len;
+    details_pos = ext_pos + sizeof (ext) + trip_attrs->len;
+    parts_pos = details_pos + details->len + stops->len;
+
+    ext.details_tbl = details_pos;
+    ext.attrs_off = attrs_pos;
+    ext.attrs_index0 = ext_pos + sizeof (ext);
+    ((HafasBin6TripDetailsHeader*)details->data)->stops_off = details->len;
+    if (attrs_pos > G_MAXUINT16 || details->len > G_MAXUINT16) {
+        g_set_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_ARGUMENT,
+                     "Tables exceed 16 bit offsets");
+        g_byte_array_unref (out);
+        out = NULL;
+        goto out;
+    }
+
+    for (i = 0; i < params->n_trips; i++)
+        ((HafasBin6Trip*)trips->data)[i].parts_off += parts_pos - sizeof (HafasBin6Header);
+
+    memset (&header, 0, sizeof (header));
+    header.version = 6;
+    memset (&loc, 0, sizeof (loc));
+    loc.type = HAFAS_BIN6_LOC_TYPE_STATION;
+    loc.name_off = ((HafasBin6Station*)stations->data)[station_idx (params, 0, 0, 0)].name_off;
+    memcpy (header.start, &loc, sizeof (loc));
+    loc.name_off = ((HafasBin6Station*)stations->data)[
+        station_idx (params, 0, params->n_parts - 1, params->n_stops + 1)].name_off;
+    memcpy (header.end, &loc, sizeof (loc));
+    header.num_trips = params->n_trips;
+    header.service_tbl = service_pos;
+    header.strings_tbl = strings_pos;
+    header.days = params->days;
+    header.stations_tbl = stations_pos;
+    header.comments_tbl = comments_pos;
+    header.ext = ext_pos;
+
+    append (out, &header, sizeof (header));
+    append (out, trips->data, trips->len);
+    append (out, attrs->data, attrs->len);
+    append (out, comments->data, comments->len);
+    append (out, service->data, service->len);
+    append (out, w.strings->data, w.strings->len);
+    append (out, stations->data, stations->len);
+    append (out, &ext, sizeof (ext));
+    append (out, trip_attrs->data, trip_attrs->len);
+    append (out, details->data, details->len);
+    append (out, stops->data, stops->len);
+    append (out, parts->data, parts->len);
+    g_assert (out->len == parts_pos + parts->len);
+
+ out:
+    g_byte_array_unref (trips);
+    g_byte_array_unref (attrs);
+    g_byte_array_unref (comments);
+    g_byte_array_unref (service);
+    g_byte_array_unref (stations);
+    g_byte_array_unref (trip_attrs);
+    g_byte_array_unref (details);
+    g_byte_array_unref (stops);
+    g_byte_array_unref (parts);
+    g_byte_array_unref (w.strings);
+    g_hash_table_destroy (w.offsets);
+    return out ? g_byte_array_free_to_bytes (out) : NULL;
+}
+
+
+/**
+ * hafas_bin6_writer_gzip:
+ * @data: the data to compress
+ * @err: #GError
+ *
+ * Returns: (transfer full): @data compressed like a server response
+ */
+GBytes*
+hafas_bin6_writer_gzip (GBytes *data, GError **err)
+{
+    GOutputStream *mem, *gz;
+    GConverter *comp;
+    GBytes *ret = NULL;
+    gsize written;
+
+    mem = g_memory_output_stream_new_resizable ();
+    comp = (GConverter *)g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+    gz = g_converter_output_stream_new (mem, comp);
+
+    if (g_output_stream_write_all (gz,
+                                   g_bytes_get_data (data, NULL),
+                                   g_bytes_get_size (data),
+                                   &written, NULL, err) &&
+        g_output_stream_close (gz, NULL, err))
+        ret = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (mem));
+
+    g_object_unref (gz);
+    g_object_unref (comp);
+    g_object_unref (mem);
+    return ret;
+}
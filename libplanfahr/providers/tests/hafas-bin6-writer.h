@@ -0,0 +1,57 @@
+/*
+ * hafas-bin6-writer.h: write synthetic hafas binary format version 6 data
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#ifndef _HAFAS_BIN6_WRITER_H
+#define _HAFAS_BIN6_WRITER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * HafasBin6WriterParams:
+ * @n_trips: number of trips
+ * @n_parts: parts per trip
+ * @n_stops: intermediate stops per part
+ * @n_stations: size of the stations table
+ * @encoding: encoding of the strings table, e.g. "iso-8859-1"
+ * @days: date base in days since 1980
+ *
+ * Shape of the response built by #hafas_bin6_writer_build
+ */
+typedef struct _HafasBin6WriterParams {
+    guint n_trips;
+    guint n_parts;
+    guint n_stops;
+    guint n_stations;
+    const gchar *encoding;
+    gint16 days;
+} HafasBin6WriterParams;
+
+#define HAFAS_BIN6_WRITER_PARAMS_INIT { 3, 2, 5, 100, "iso-8859-1", 12419 }
+
+GBytes *hafas_bin6_writer_build (const HafasBin6WriterParams *params, GError **err);
+GBytes *hafas_bin6_writer_gzip (GBytes *data, GError **err);
+gchar *hafas_bin6_writer_station_name (guint idx);
+
+G_END_DECLS
+#endif /* _HAFAS_BIN6_WRITER_H */
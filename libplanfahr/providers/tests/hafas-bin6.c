@@ -22,6 +22,9 @@
 
 #include "../hafas-bin6.c"
 
+#include <glib/gstdio.h>
+#include "hafas-bin6-writer.h"
+
 /* Make sure we can parse the station xml list as returned by the current Deutsche Bahn Hafas */
 static void
 test_parse_locs (void)
@@ -30,6 +33,8 @@ test_parse_locs (void)
     LpfLoc *loc;
     char *name;
     double lon, lat;
+    xmlParserCtxtPtr parser;
+    gint i;
 
     char *xml = g_strjoin(NULL,
 "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>",
@@ -45,7 +50,7 @@ test_parse_locs (void)
 "  </MLcRes>",
 "</ResC>", NULL);
 
-    locs = parse_locs_xml(xml);
+    locs = parse_locs_xml(NULL, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
 #if GLIB_CHECK_VERSION (2, 40, 0)
     g_assert_nonnull (locs);
 #else
@@ -59,17 +64,517 @@ test_parse_locs (void)
     g_assert_cmpstr (name, ==, "Orsberg Ort, Erpel");
     g_assert_cmpint (lon, ==, 7);
     g_assert_cmpint (lat, ==, 50);
+    g_assert_cmpstr (lpf_loc_get_opaque (loc), ==,
+                     "A=1@O=Orsberg Ort, Erpel@X=7243399@Y=50593061@U=81@L=000454657@B=1@p=1387219918@");
+    g_free (name);
+    g_slist_free_full (locs, g_object_unref);
+
+    /* A reused parser gives the same result, also after a broken document */
+    parser = locs_parser_new ();
+    for (i = 0; i < 2; i++) {
+        locs = parse_locs_xml (parser, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+        g_assert_cmpint (g_slist_length (locs), ==, 7);
+        g_slist_free_full (locs, g_object_unref);
+        g_test_expect_message (G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "Document not parsed*");
+        g_assert (parse_locs_xml (parser, "<ResC><MLc t=\"ST\" n=\"x\"></ResC>",
+                                  LPF_PROVIDER_GET_LOCS_STATIONS, 0) == NULL);
+        g_test_assert_expected_messages ();
+    }
 
+    locs = parse_locs_xml (parser, "<ResC><MLc t=\"ADR\" n=\"a\"/>"
+                                   "<MLc t=\"ST\" n=\"K&amp;M\" x=\"1\" y=\"2\" i=\"x\"/></ResC>",
+                            LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_object_get (locs->data, "name", &name, NULL);
+    g_assert_cmpstr (name, ==, "K&M");
+    g_free (name);
     g_slist_free_full (locs, g_object_unref);
+
+    xmlFreeParserCtxt (parser);
     g_free (xml);
-    g_free (name);
 }
 
+
+/* Several matches go into one request and come back split per match */
+static void
+test_locs_batch (void)
+{
+    const gchar *matches[] = { "Erpel", "A&B \"<C>\"", "Köln", NULL };
+    GSList *results[3];
+    gchar *req;
+
+    req = locs_request_new (matches, 3, LPF_PROVIDER_GET_LOCS_STATIONS);
+    g_assert (strstr (req, "<MLcReq><MLc n=\"Erpel\" t=\"ST\"/></MLcReq>"));
+    g_assert (strstr (req, "<MLc n=\"A&amp;B &quot;&lt;C&gt;&quot;\" t=\"ST\"/>"));
+    g_assert (strstr (req, "<MLc n=\"Köln\" t=\"ST\"/>"));
+    g_free (req);
+
+    g_assert_true (parse_locs_xml_multi (NULL,
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+"<ResC ver=\"1.1\" prod=\"String\" lang=\"EN\">"
+"  <MLcRes flag=\"FINAL\">"
+"    <MLc t=\"ST\" n=\"Erpel(Rhein)\" i=\"A=1@L=008001858@\" x=\"7241593\" y=\"50582067\" />"
+"    <MLc t=\"ST\" n=\"Erpel B42\" i=\"A=1@L=000441204@\" x=\"7231174\" y=\"50583649\" />"
+"  </MLcRes>"
+"  <MLcRes flag=\"FINAL\"><Err code=\"K1\" /></MLcRes>"
+"  <MLcRes flag=\"FINAL\">"
+"    <MLc t=\"ST\" n=\"Köln Hbf\" i=\"A=1@L=008000207@\" x=\"6958730\" y=\"50943029\" />"
+"  </MLcRes>"
+"</ResC>", LPF_PROVIDER_GET_LOCS_STATIONS, 0, results, 3));
+
+    g_assert_cmpint (g_slist_length (results[0]), ==, 2);
+    g_assert_cmpstr (lpf_loc_get_name (results[0]->data), ==, "Erpel(Rhein)");
+    g_assert_cmpstr (lpf_loc_get_name (results[0]->next->data), ==, "Erpel B42");
+    g_assert_null (results[1]);
+    g_assert_cmpint (g_slist_length (results[2]), ==, 1);
+    g_assert_cmpstr (lpf_loc_get_name (results[2]->data), ==, "Köln Hbf");
+    g_assert_cmpstr (lpf_loc_get_opaque (results[2]->data), ==, "A=1@L=008000207@");
+
+    g_slist_free_full (results[0], g_object_unref);
+    g_slist_free_full (results[2], g_object_unref);
+}
+
+
+/* Location types get filtered and results capped while parsing */
+static void
+test_locs_shape (void)
+{
+    const gchar *match = "Erpel";
+    const char *xml =
+"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+"<ResC ver=\"1.1\" prod=\"String\" lang=\"EN\">"
+"  <MLcRes flag=\"FINAL\">"
+"    <MLc t=\"ST\" n=\"Erpel(Rhein)\" i=\"A=1@L=008001858@\" x=\"7241593\" y=\"50582067\" />"
+"    <MLc t=\"ADR\" n=\"Erpel, Bahnhofstr.\" i=\"A=2@\" x=\"7243175\" y=\"50580943\" />"
+"    <MLc t=\"POI\" n=\"Erpel, Kirche\" i=\"A=4@\" x=\"7235282\" y=\"50584108\" />"
+"    <MLc t=\"ST\" n=\"Erpel B42\" i=\"A=1@L=000441204@\" x=\"7231174\" y=\"50583649\" />"
+"    <MLc t=\"ST\" n=\"Neutor, Erpel\" i=\"A=1@L=000454652@\" x=\"7235282\" y=\"50584108\" />"
+"  </MLcRes>"
+"</ResC>";
+    GSList *locs;
+    gchar *req;
+
+    req = locs_request_new (&match, 1, locs_types (LPF_PROVIDER_GET_LOCS_NONE));
+    g_assert (strstr (req, "t=\"ST\""));
+    g_free (req);
+    req = locs_request_new (&match, 1, locs_types (LPF_PROVIDER_GET_LOCS_ADDRESSES));
+    g_assert (strstr (req, "t=\"ADR\""));
+    g_free (req);
+    req = locs_request_new (&match, 1, locs_types (LPF_PROVIDER_GET_LOCS_STATIONS |
+                                                   LPF_PROVIDER_GET_LOCS_POIS));
+    g_assert (strstr (req, "t=\"ALLTYPE\""));
+    g_free (req);
+
+    locs = parse_locs_xml (NULL, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+    g_assert_cmpint (g_slist_length (locs), ==, 3);
+    g_slist_free_full (locs, g_object_unref);
+
+    locs = parse_locs_xml (NULL, xml, LPF_PROVIDER_GET_LOCS_STATIONS |
+                           LPF_PROVIDER_GET_LOCS_POIS, 0);
+    g_assert_cmpint (g_slist_length (locs), ==, 4);
+    g_assert_cmpstr (lpf_loc_get_name (g_slist_nth_data (locs, 1)), ==, "Erpel, Kirche");
+    g_slist_free_full (locs, g_object_unref);
+
+    /* parsing stops early but the result is still good */
+    locs = parse_locs_xml (NULL, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 2);
+    g_assert_cmpint (g_slist_length (locs), ==, 2);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Erpel(Rhein)");
+    g_assert_cmpstr (lpf_loc_get_name (locs->next->data), ==, "Erpel B42");
+    g_slist_free_full (locs, g_object_unref);
+
+    locs = parse_locs_xml (NULL, xml, LOCS_TYPES, 1);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_slist_free_full (locs, g_object_unref);
+}
+
+
+static LpfLoc*
+cache_test_loc (const char *name, const char *opaque)
+{
+    LpfLoc *loc = g_object_new (LPF_TYPE_LOC, "name", name, "long", 6.9, "lat", 50.9, NULL);
+
+    lpf_loc_set_opaque (loc, g_strdup (opaque));
+    return loc;
+}
+
+
+/* Location lookups are remembered, including ones without result */
+static void
+test_locs_cache (void)
+{
+    const gint64 s = G_USEC_PER_SEC;
+    HafasBin6LocsCache *cache;
+    GSList *in = NULL, *locs;
+    gchar *dir, *path;
+    GError *err = NULL;
+
+    cache = hafas_bin6_locs_cache_new (2, 10 * s);
+    g_assert_false (hafas_bin6_locs_cache_lookup (cache, "Köln Hbf", LPF_PROVIDER_GET_LOCS_STATIONS, 0, 0, &locs));
+
+    in = g_slist_append (in, cache_test_loc ("Köln Hbf", "A=1@L=008000207@"));
+    in = g_slist_append (in, cache_test_loc ("Köln Messe/Deutz", "A=1@L=008003368@"));
+    hafas_bin6_locs_cache_insert (cache, "Köln Hbf", LPF_PROVIDER_GET_LOCS_STATIONS, 0, in, 0);
+    g_slist_free_full (in, g_object_unref);
+
+    /* case and whitespace don't matter, the types do */
+    g_assert_true (hafas_bin6_locs_cache_lookup (cache, "  köln   HBF ", LPF_PROVIDER_GET_LOCS_STATIONS, 0, 1 * s, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 2);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Hbf");
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=008000207@");
+    g_assert_cmpstr (lpf_loc_get_name (locs->next->data), ==, "Köln Messe/Deutz");
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_locs_cache_lookup (cache, "Köln Hbf", LPF_PROVIDER_GET_LOCS_POIS, 0, 1 * s, &locs));
+
+    g_assert_true (hafas_bin6_locs_cache_lookup (cache, "Köln Hbf", LPF_PROVIDER_GET_LOCS_STATIONS, 1, 1 * s, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_slist_free_full (locs, g_object_unref);
+
+    /* negative entry */
+    hafas_bin6_locs_cache_insert (cache, "Nirgendwo", LPF_PROVIDER_GET_LOCS_STATIONS, 0, NULL, 2 * s);
+    g_assert_true (hafas_bin6_locs_cache_lookup (cache, "Nirgendwo", LPF_PROVIDER_GET_LOCS_STATIONS, 0, 3 * s, &locs));
+    g_assert_null (locs);
+
+    /* a capped result can't answer for more locations, evicts "Köln Hbf" */
+    in = g_slist_append (NULL, cache_test_loc ("Erpel(Rhein)", "A=1@L=008001858@"));
+    hafas_bin6_locs_cache_insert (cache, "Erpel", LPF_PROVIDER_GET_LOCS_STATIONS, 1, in, 4 * s);
+    g_slist_free_full (in, g_object_unref);
+    g_assert_false (hafas_bin6_locs_cache_lookup (cache, "Erpel", LPF_PROVIDER_GET_LOCS_STATIONS, 0, 5 * s, &locs));
+    g_assert_true (hafas_bin6_locs_cache_lookup (cache, "Erpel", LPF_PROVIDER_GET_LOCS_STATIONS, 1, 5 * s, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_cmpint (hafas_bin6_locs_cache_get_size (cache), ==, 2);
+    g_assert_false (hafas_bin6_locs_cache_lookup (cache, "Köln Hbf", LPF_PROVIDER_GET_LOCS_STATIONS, 0, 5 * s, &locs));
+
+    /* persisted entries survive, expired ones don't */
+    dir = g_dir_make_tmp ("lpf-locs-cache-XXXXXX", &err);
+    g_assert_no_error (err);
+    path = g_build_filename (dir, HAFAS_BIN6_LOCS_CACHE_FILE, NULL);
+    g_assert_true (hafas_bin6_locs_cache_save (cache, path, 6 * s, &err));
+    g_assert_no_error (err);
+    hafas_bin6_locs_cache_free (cache);
+
+    cache = hafas_bin6_locs_cache_new (10, 10 * s);
+    g_assert_true (hafas_bin6_locs_cache_load (cache, path, 13 * s, &err));
+    g_assert_no_error (err);
+    g_assert_cmpint (hafas_bin6_locs_cache_get_size (cache), ==, 1);
+    g_assert_true (hafas_bin6_locs_cache_lookup (cache, "ERPEL", LPF_PROVIDER_GET_LOCS_STATIONS, 1, 13 * s, &locs));
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=008001858@");
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_locs_cache_lookup (cache, "Erpel", LPF_PROVIDER_GET_LOCS_STATIONS, 1, 15 * s, &locs));
+    g_assert_cmpint (hafas_bin6_locs_cache_get_size (cache), ==, 0);
+    hafas_bin6_locs_cache_free (cache);
+
+    g_unlink (path);
+    g_rmdir (dir);
+    g_free (path);
+    g_free (dir);
+}
+
+
+/* Known stations answer type-ahead lookups */
+static void
+test_station_index (void)
+{
+    HafasBin6StationIndex *index;
+    GSList *locs;
+    gchar *folded;
+
+    folded = hafas_bin6_station_index_fold ("  Köln Messe/Deutz ");
+    g_assert_cmpstr (folded, ==, "koln messe deutz");
+    g_free (folded);
+
+    index = hafas_bin6_station_index_new (10);
+    hafas_bin6_station_index_add (index, "Köln Hbf", 6.9, 50.9, "A=1@L=008000207@");
+    hafas_bin6_station_index_add (index, "Köln Messe/Deutz", 6.9, 50.9, "A=1@L=008003368@");
+    hafas_bin6_station_index_add (index, "Köln-Ehrenfeld", 6.9, 50.9, "A=1@L=008000208@");
+    hafas_bin6_station_index_add (index, "Bonn Hbf", 7.1, 50.7, "A=1@L=008000044@");
+    /* only seen in a trip so far */
+    hafas_bin6_station_index_add (index, "Erpel(Rhein)", 7.2, 50.6, NULL);
+    g_assert_cmpint (hafas_bin6_station_index_get_size (index), ==, 5);
+
+    /* names starting with the match come first, shorter ones before longer ones */
+    g_assert_false (hafas_bin6_station_index_lookup (index, "koln", 2, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 2);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Hbf");
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=008000207@");
+    g_assert_cmpstr (lpf_loc_get_name (locs->next->data), ==, "Köln-Ehrenfeld");
+    g_slist_free_full (locs, g_object_unref);
+
+    /* only exact matches stand in for the provider */
+    g_assert_true (hafas_bin6_station_index_lookup (index, "köln  HBF", 1, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Hbf");
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "köln hbf", 2, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "KÖLN", 5, &locs));
+    g_assert_cmpint (g_slist_length (locs), ==, 3);
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "koln", 0, &locs));
+    g_slist_free_full (locs, g_object_unref);
+
+    /* any word matches, in any order */
+    g_assert_false (hafas_bin6_station_index_lookup (index, "hbf", 2, &locs));
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Hbf");
+    g_assert_cmpstr (lpf_loc_get_name (locs->next->data), ==, "Bonn Hbf");
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "deutz mes", 1, &locs));
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Messe/Deutz");
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "deutz hbf", 1, &locs));
+    g_assert_null (locs);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "k", 1, &locs));
+    g_assert_null (locs);
+
+    /* stations without opaque data can't be used for trips */
+    g_assert_false (hafas_bin6_station_index_lookup (index, "Erpel", 1, &locs));
+    g_assert_null (locs);
+    hafas_bin6_station_index_add (index, "Erpel(Rhein)", 7.2, 50.6, "A=1@L=008001858@");
+    g_assert_cmpint (hafas_bin6_station_index_get_size (index), ==, 5);
+    g_assert_false (hafas_bin6_station_index_lookup (index, "Erpel", 1, &locs));
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=008001858@");
+    g_slist_free_full (locs, g_object_unref);
+    hafas_bin6_station_index_free (index);
+
+    index = hafas_bin6_station_index_new (1);
+    hafas_bin6_station_index_add (index, "Köln Hbf", 6.9, 50.9, "A=1@L=008000207@");
+    hafas_bin6_station_index_add (index, "Bonn Hbf", 7.1, 50.7, "A=1@L=008000044@");
+    g_assert_cmpint (hafas_bin6_station_index_get_size (index), ==, 1);
+    hafas_bin6_station_index_free (index);
+}
+
+
+/* Known stations can be looked up by distance */
+static void
+test_station_near (void)
+{
+    HafasBin6StationIndex *index;
+    GSList *locs;
+
+    index = hafas_bin6_station_index_new (10);
+    g_assert_null (hafas_bin6_station_index_nearest (index, 6.958, 50.943, 0, 1));
+
+    hafas_bin6_station_index_add (index, "Köln Hbf", 6.958730, 50.943029, "A=1@L=008000207@");
+    hafas_bin6_station_index_add (index, "Köln Messe/Deutz", 6.975000, 50.940871, "A=1@L=008003368@");
+    hafas_bin6_station_index_add (index, "Bonn Hbf", 7.097136, 50.732007, "A=1@L=008000044@");
+    hafas_bin6_station_index_add (index, "Berlin Hbf", 13.369548, 52.525589, "A=1@L=008011160@");
+    /* no position, no opaque data */
+    hafas_bin6_station_index_add (index, "Nirgendwo", 0.0, 0.0, "A=1@L=000000001@");
+    hafas_bin6_station_index_add (index, "Köln Süd", 6.934000, 50.926000, NULL);
+
+    /* k nearest */
+    locs = hafas_bin6_station_index_nearest (index, 6.960, 50.943, 0, 2);
+    g_assert_cmpint (g_slist_length (locs), ==, 2);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Köln Hbf");
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=008000207@");
+    g_assert_cmpstr (lpf_loc_get_name (locs->next->data), ==, "Köln Messe/Deutz");
+    g_slist_free_full (locs, g_object_unref);
+
+    /* far away stations are found too */
+    locs = hafas_bin6_station_index_nearest (index, 13.0, 52.0, 0, 1);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_assert_cmpstr (lpf_loc_get_name (locs->data), ==, "Berlin Hbf");
+    g_slist_free_full (locs, g_object_unref);
+
+    /* radius */
+    locs = hafas_bin6_station_index_nearest (index, 6.960, 50.943, 30000, 0);
+    g_assert_cmpint (g_slist_length (locs), ==, 3);
+    g_assert_cmpstr (lpf_loc_get_name (g_slist_nth_data (locs, 2)), ==, "Bonn Hbf");
+    g_slist_free_full (locs, g_object_unref);
+    locs = hafas_bin6_station_index_nearest (index, 6.960, 50.943, 1000, 5);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_slist_free_full (locs, g_object_unref);
+    g_assert_null (hafas_bin6_station_index_nearest (index, 7.5, 51.5, 1000, 5));
+
+    /* position filled in later */
+    hafas_bin6_station_index_add (index, "Nirgendwo", 7.500000, 51.500000, NULL);
+    locs = hafas_bin6_station_index_nearest (index, 7.5, 51.5, 1000, 5);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_assert_cmpstr (lpf_loc_get_opaque (locs->data), ==, "A=1@L=000000001@");
+    g_slist_free_full (locs, g_object_unref);
+
+    hafas_bin6_station_index_free (index);
+}
+
+static void
+got_progressive_locs (GSList *locs, gboolean final, gpointer user_data, GError *err)
+{
+    gint *answers = user_data;
+
+    g_assert_no_error (err);
+    answers[final ? 1 : 0]++;
+    g_slist_free_full (locs, g_object_unref);
+}
+
+/* A final answer arriving first drops the preliminary one */
+static void
+test_locs_progressive (void)
+{
+    LpfProviderHafasBin6 *provider;
+    HafasBin6ProgressiveLocs *progressive;
+    gint answers[2] = { 0, 0 };
+
+    provider = g_object_new (LPF_TYPE_PROVIDER_HAFAS_BIN6, NULL);
+    progressive = g_new0 (HafasBin6ProgressiveLocs, 1);
+    progressive->self = LPF_PROVIDER (provider);
+    progressive->callback = got_progressive_locs;
+    progressive->user_data = answers;
+    progressive->locs = g_slist_prepend (NULL, cache_test_loc ("Köln Hbf", "A=1@L=008000207@"));
+    progressive->source = g_idle_add (got_preliminary_locs, progressive);
+
+    got_final_locs (g_slist_prepend (NULL, cache_test_loc ("Köln Hbf", "A=1@L=008000207@")),
+                    progressive, NULL);
+    g_assert_cmpint (answers[1], ==, 1);
+
+    while (g_main_context_iteration (NULL, FALSE))
+        ;
+    g_assert_cmpint (answers[0], ==, 0);
+    g_assert_cmpint (answers[1], ==, 1);
+    g_object_unref (provider);
+}
+
+/* Stations from trips end up in the station database */
+static void
+test_station_db (void)
+{
+    HafasBin6StationDb *db, *other;
+    HafasBin6View view;
+    LpfTripPart *part;
+    LpfStop *start;
+    LpfTripList *trips;
+    gchar *dir, *path, *lockpath, *binary;
+    const gchar *name;
+    gint32 lon, lat;
+    guint32 id;
+    gsize length;
+    GError *err = NULL;
+
+    dir = g_dir_make_tmp ("lpf-station-db-XXXXXX", &err);
+    g_assert_no_error (err);
+    path = g_build_filename (dir, HAFAS_BIN6_STATION_DB_FILE, NULL);
+
+    /* no file yet */
+    db = hafas_bin6_station_db_new (path);
+    g_assert_true (hafas_bin6_station_db_load (db, &err));
+    g_assert_no_error (err);
+    g_assert_cmpint (hafas_bin6_station_db_get_size (db), ==, 0);
+
+    g_assert_true (hafas_bin6_station_db_add (db, 8000207, "Köln Hbf", 6958730, 50943029));
+    g_assert_false (hafas_bin6_station_db_add (db, 8000207, "Köln Hbf", 6958730, 50943029));
+    g_assert_true (hafas_bin6_station_db_add (db, 8000044, "Bonn Hbf", 7097136, 50732007));
+    g_assert_cmpint (hafas_bin6_station_db_get_n_pending (db), ==, 2);
+    g_assert_true (hafas_bin6_station_db_lookup_id (db, 8000207, &name, &lon, &lat));
+    g_assert_cmpstr (name, ==, "Köln Hbf");
+
+    g_assert_true (hafas_bin6_station_db_sync (db, &err));
+    g_assert_no_error (err);
+    g_assert_cmpint (hafas_bin6_station_db_get_n_pending (db), ==, 0);
+    g_assert_cmpint (hafas_bin6_station_db_get_size (db), ==, 2);
+    g_assert_true (hafas_bin6_station_db_lookup_name (db, "Bonn Hbf", &id, &lon, &lat));
+    g_assert_cmpint (id, ==, 8000044);
+    g_assert_cmpint (lon, ==, 7097136);
+    g_assert_cmpint (lat, ==, 50732007);
+    g_assert_true (hafas_bin6_station_db_lookup_id (db, 8000207, &name, NULL, NULL));
+    g_assert_cmpstr (name, ==, "Köln Hbf");
+    g_assert_false (hafas_bin6_station_db_lookup_id (db, 8000208, NULL, NULL, NULL));
+    g_assert_false (hafas_bin6_station_db_lookup_name (db, "Köln", NULL, NULL, NULL));
+
+    /* stations written by others are kept */
+    other = hafas_bin6_station_db_new (path);
+    g_assert_true (hafas_bin6_station_db_load (other, &err));
+    g_assert_cmpint (hafas_bin6_station_db_get_size (other), ==, 2);
+    g_assert_true (hafas_bin6_station_db_add (other, 8011160, "Berlin Hbf", 13369548, 52525589));
+    g_assert_true (hafas_bin6_station_db_sync (other, &err));
+    g_assert_no_error (err);
+    g_assert_true (hafas_bin6_station_db_add (db, 8000001, "Aachen Hbf", 6091495, 50767803));
+    g_assert_true (hafas_bin6_station_db_sync (db, &err));
+    g_assert_no_error (err);
+    g_assert_cmpint (hafas_bin6_station_db_get_size (db), ==, 4);
+    g_assert_true (hafas_bin6_station_db_lookup_name (db, "Berlin Hbf", &id, NULL, NULL));
+    g_assert_cmpint (id, ==, 8011160);
+    hafas_bin6_station_db_free (other);
+
+    /* stations of a trip response */
+    g_assert_true (g_file_get_contents (LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL));
+    g_assert_true (hafas_bin6_view_init (&view, binary, length, NULL));
+    hafas_bin6_station_db_add_view (db, &view);
+    g_assert_cmpint (hafas_bin6_station_db_get_n_pending (db), >, 0);
+
+    trips = hafas_binary_parse_trips (binary, length, NULL, NULL);
+    part = LPF_TRIP_PART (lpf_trip_get_parts (lpf_trip_list_get (trips, 0))->data);
+    start = lpf_trip_part_get_start (part);
+    g_assert_true (hafas_bin6_station_db_lookup_name (db, lpf_loc_get_name (LPF_LOC (start)), &id, NULL, NULL));
+    g_assert_true (hafas_bin6_station_db_lookup_id (db, id, &name, NULL, NULL));
+    g_assert_cmpstr (name, ==, lpf_loc_get_name (LPF_LOC (start)));
+    g_object_unref (start);
+    g_object_unref (trips);
+
+    g_assert_true (hafas_bin6_station_db_sync (db, &err));
+    g_assert_no_error (err);
+    hafas_bin6_station_db_free (db);
+
+    db = hafas_bin6_station_db_new (path);
+    g_assert_true (hafas_bin6_station_db_load (db, &err));
+    g_assert_cmpint (hafas_bin6_station_db_get_n_pending (db), ==, 0);
+    g_assert_cmpint (hafas_bin6_station_db_get_size (db), >, 4);
+    hafas_bin6_station_db_free (db);
+
+    /* broken files are rejected */
+    g_assert_true (g_file_set_contents (path, "LPSD\1\0\0\0\1\0\0\0", 12, NULL));
+    db = hafas_bin6_station_db_new (path);
+    g_assert_false (hafas_bin6_station_db_load (db, &err));
+    g_assert_error (err, G_IO_ERROR, G_IO_ERROR_INVALID_DATA);
+    g_clear_error (&err);
+    hafas_bin6_station_db_free (db);
+
+    g_free (binary);
+    g_unlink (path);
+    lockpath = g_strconcat (path, ".lock", NULL);
+    g_assert_true (g_file_test (lockpath, G_FILE_TEST_EXISTS));
+    g_unlink (lockpath);
+    g_free (lockpath);
+    g_rmdir (dir);
+    g_free (path);
+    g_free (dir);
+}
+
+/* Stations from trips and station ids are usable as trip endpoints */
+static void
+test_station_opaque (void)
+{
+    LpfProviderHafasBin6 *provider;
+    gchar *binary;
+    gsize length;
+    LpfLoc *loc;
+    gboolean enabled;
+
+    g_assert_true (g_file_get_contents (LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL));
+    loc = g_object_new (LPF_TYPE_LOC, NULL);
+    g_assert_cmpint (lpf_provider_hafas_bin6_parse_station (binary, 1, loc, "iso-8859-1"), ==, 0);
+    g_assert_cmpstr (lpf_loc_get_name (loc), ==, "Unkel");
+    g_assert_cmpstr (lpf_loc_get_opaque (loc), ==, "A=1@O=Unkel@X=7219803@Y=50602742@L=008005970@");
+    g_object_unref (loc);
+    g_free (binary);
+
+    /* without station database there's only the id */
+    provider = g_object_new (LPF_TYPE_PROVIDER_HAFAS_BIN6, NULL);
+    g_object_get (provider, "station-db-enabled", &enabled, NULL);
+    g_assert_false (enabled);
+    loc = lpf_provider_loc_new_from_id (LPF_PROVIDER (provider), 8001858);
+    g_assert_cmpstr (lpf_loc_get_name (loc), ==, "");
+    g_assert_cmpstr (lpf_loc_get_opaque (loc), ==, "A=1@L=008001858@");
+    g_assert_cmpuint (lpf_loc_get_id (loc), ==, 8001858);
+    g_object_unref (loc);
+    g_object_unref (provider);
+}
+
+
 /* Make sure we can parse the binary data trip information */
 static void
 test_parse_trips (void)
 {
-    GSList *trips;
+    LpfTripList *trips;
     gchar *binary;
     gsize  length;
     int i;
@@ -79,6 +584,11 @@ test_parse_trips (void)
     LpfLoc *stop;
     gchar *name;
     GDateTime *dep, *arr;
+    HafasBin6View view;
+    HafasBin6TripView tv;
+    HafasBin6PartView pv;
+    HafasBin6StopView sv;
+    LpfStop *start, *other;
 
 #if GLIB_CHECK_VERSION (2, 38, 0)
     g_assert_true(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL));
@@ -86,12 +596,13 @@ test_parse_trips (void)
     g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
 #endif
 
-    trips = hafas_binary_parse_trips (binary, length, NULL);
+    trips = hafas_binary_parse_trips (binary, length, NULL, NULL);
 
-    g_assert (g_slist_length (trips) == 3);
+    g_assert (lpf_trip_list_get_length (trips) == 3);
+    g_assert (g_list_model_get_n_items (G_LIST_MODEL (trips)) == 3);
 
-    for (i = 0; i < g_slist_length (trips); i++) {
-        trip = LPF_TRIP(g_slist_nth_data (trips, i));
+    for (i = 0; i < lpf_trip_list_get_length (trips); i++) {
+        trip = lpf_trip_list_get (trips, i);
         g_object_get (G_OBJECT(trip), "parts", &parts, NULL);
 
         part = LPF_TRIP_PART(g_slist_nth_data (parts, 0));
@@ -104,6 +615,9 @@ test_parse_trips (void)
         /* All trips start in Erpel */
         g_assert (!g_strcmp0 (name, "Erpel(Rhein)"));
         g_free (name);
+        /* and can be used for a trip right away */
+        g_assert_cmpstr (lpf_loc_get_opaque (stop), ==,
+                         "A=1@O=Erpel(Rhein)@X=7241593@Y=50582067@L=008001858@");
 
         g_assert (dep != NULL);
         g_assert (arr == NULL);
@@ -127,8 +641,475 @@ test_parse_trips (void)
         g_free (name);
     }
 
-    g_slist_free (trips);
+    /* Intermediate stops carry the predicted times too */
+    g_assert (hafas_bin6_view_init (&view, binary, length, NULL));
+    hafas_bin6_view_get_trip (&view, 1, &tv);
+    hafas_bin6_trip_view_get_part (&tv, 1, &pv);
+    hafas_bin6_part_view_get_stop (&pv, 2, &sv);
+    trip = lpf_trip_list_get (trips, 1);
+    part = LPF_TRIP_PART (g_slist_nth_data (lpf_trip_get_parts (trip), 1));
+    stop = LPF_LOC (g_slist_nth_data (lpf_trip_part_get_stops (part), 2));
+    g_assert_cmpstr (lpf_loc_get_name (stop), ==, "Heister Kapelle, Unkel");
+    g_assert_cmpint (lpf_stop_get_rt_arrival_minutes (LPF_STOP (stop)), ==,
+                     hafas_bin6_stop_view_get_rt_arrival_minutes (&sv));
+    g_assert_cmpint (lpf_stop_get_rt_departure_minutes (LPF_STOP (stop)), ==,
+                     hafas_bin6_stop_view_get_rt_departure_minutes (&sv));
+
+    /* Stops at the same station share their opaque data */
+    part = LPF_TRIP_PART (lpf_trip_get_parts (lpf_trip_list_get (trips, 0))->data);
+    start = lpf_trip_part_get_start (part);
+    part = LPF_TRIP_PART (lpf_trip_get_parts (lpf_trip_list_get (trips, 2))->data);
+    other = lpf_trip_part_get_start (part);
+    g_assert (lpf_loc_get_opaque (LPF_LOC (start)) == lpf_loc_get_opaque (LPF_LOC (other)));
+    g_object_unref (start);
+    g_object_unref (other);
+
+    g_object_unref (trips);
+    g_free (binary);
+}
+
+
+/* Make sure we can walk the trips without building any objects */
+static void
+test_view (void)
+{
+    gchar *binary, *name;
+    gsize  length;
+    HafasBin6View view;
+    HafasBin6TripView trip;
+    HafasBin6PartView part;
+    HafasBin6StopView stop;
+    GDateTime *dt;
+    guint i;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    g_assert (hafas_bin6_view_init (&view, binary, length, NULL));
+    g_assert_cmpint (view.num_trips, ==, 3);
+    g_assert_cmpstr (view.enc, ==, "iso-8859-1");
+
+    for (i = 0; i < view.num_trips; i++) {
+        hafas_bin6_view_get_trip (&view, i, &trip);
+        g_assert (!hafas_bin6_trip_view_is_canceled (&trip));
+
+        hafas_bin6_trip_view_get_departure (&trip, &stop);
+        name = hafas_bin6_stop_view_get_name (&stop);
+        g_assert_cmpstr (name, ==, "Erpel(Rhein)");
+        g_free (name);
+        g_assert (hafas_bin6_stop_view_get_arrival (&stop) == NULL);
+        g_assert_cmpint (hafas_bin6_stop_view_get_arrival_minutes (&stop), ==, LPF_STOP_NO_TIME);
+        dt = hafas_bin6_stop_view_get_departure (&stop);
+        g_assert (dt != NULL);
+        g_assert_cmpint (hafas_bin6_stop_view_get_departure_minutes (&stop), ==,
+                         g_date_time_to_unix (dt) / 60);
+        g_date_time_unref (dt);
+
+        hafas_bin6_trip_view_get_arrival (&trip, &stop);
+        name = hafas_bin6_stop_view_get_name (&stop);
+        g_assert (g_strrstr (name, "Unkel") != NULL);
+        g_free (name);
+        g_assert (hafas_bin6_stop_view_get_departure (&stop) == NULL);
+        g_assert (hafas_bin6_stop_view_get_rt_arrival (&stop) == NULL);
+    }
+
+    hafas_bin6_view_get_trip (&view, 1, &trip);
+    g_assert_cmpint (hafas_bin6_trip_view_get_n_parts (&trip), ==, 2);
+    hafas_bin6_trip_view_get_part (&trip, 1, &part);
+    g_assert_cmpint (hafas_bin6_part_view_get_n_stops (&part), ==, 8);
+    hafas_bin6_part_view_get_stop (&part, 2, &stop);
+    name = hafas_bin6_stop_view_get_name (&stop);
+    g_assert_cmpstr (name, ==, "Heister Kapelle, Unkel");
+    g_free (name);
+
+    g_free (binary);
+}
+
+
+static gchar*
+gzip_data (const gchar *data, gsize len, gsize *outlen)
+{
+    GConverter *comp;
+    gsize room = len + 1024, read_, written;
+    gchar *out = g_malloc (room);
+
+    comp = (GConverter *)g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+    g_assert (g_converter_convert (comp, data, len, out, room,
+                                   G_CONVERTER_INPUT_AT_END,
+                                   &read_, &written, NULL) == G_CONVERTER_FINISHED);
+    g_object_unref (comp);
+    *outlen = written;
+    return out;
+}
+
+static void
+got_trip (LpfTrip *trip, gpointer user_data)
+{
+    GSList **trips = user_data;
+
+    g_assert (LPF_IS_TRIP (trip));
+    *trips = g_slist_append (*trips, trip);
+}
+
+static void
+check_attrs (LpfTripList *trips)
+{
+    LpfTripPart *part;
+    const gchar * const *notes;
+
+    /* Erpel - Unkel */
+    part = g_slist_nth_data (lpf_trip_get_parts (lpf_trip_list_get (trips, 0)), 0);
+    g_assert_cmpstr (lpf_trip_part_get_attr (part, "Operator"), ==, "DB Regio AG");
+    g_assert_cmpstr (lpf_trip_part_get_attr (part, "Number"), ==, "12560");
+    g_assert (lpf_trip_part_get_attr (part, "Direction") == NULL);
+    notes = lpf_trip_part_get_notes (part);
+    g_assert_cmpint (g_strv_length ((gchar**)notes), ==, 4);
+    g_assert_cmpstr (notes[0], ==, "FB - Number of bicycles conveyed limited");
+    g_assert_cmpint (lpf_trip_part_get_attr_flags (part), ==,
+                     LPF_TRIP_PART_ATTR_FLAGS_BICYCLES |
+                     LPF_TRIP_PART_ATTR_FLAGS_ACCESSIBLE |
+                     LPF_TRIP_PART_ATTR_FLAGS_AIR_CONDITIONING);
+
+    /* Bus without any comments */
+    part = g_slist_nth_data (lpf_trip_get_parts (lpf_trip_list_get (trips, 1)), 1);
+    g_assert_cmpstr (lpf_trip_part_get_attr (part, "Direction"), ==,
+                     "Bad Honnef (Stadtbahn), Bad Honnef");
+    g_assert (lpf_trip_part_get_notes (part)[0] == NULL);
+    g_assert_cmpint (lpf_trip_part_get_attr_flags (part), ==, LPF_TRIP_PART_ATTR_FLAGS_NONE);
+}
+
+
+/* Make sure trips get parsed while compressed data trickles in */
+static void
+test_stream (void)
+{
+    gchar *binary, *compressed, *name;
+    gsize length, clen, pos;
+    HafasBin6TripStream *stream;
+    GSList *trips = NULL, *parts;
+    LpfTripList *list;
+    LpfTripPart *part;
+    LpfLoc *stop;
+    GError *err = NULL;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    compressed = gzip_data (binary, length, &clen);
+
+    stream = trip_stream_new (NULL, got_trip, &trips);
+    for (pos = 0; pos < clen; pos += 17)
+        g_assert (trip_stream_feed (stream, compressed + pos, MIN (17, clen - pos), NULL));
+    g_assert (trip_stream_finish (stream, NULL));
+    trip_stream_free (stream);
+
+    g_assert_cmpint (g_slist_length (trips), ==, 3);
+    g_object_get (G_OBJECT(trips->data), "parts", &parts, NULL);
+    part = LPF_TRIP_PART(parts->data);
+    g_object_get (G_OBJECT(part), "start", &stop, NULL);
+    g_object_get (G_OBJECT(stop), "name", &name, NULL);
+    g_assert_cmpstr (name, ==, "Erpel(Rhein)");
+    g_free (name);
+    /* the attribute tables come after the trips */
+    list = lpf_trip_list_new_from_slist (trips);
+    check_attrs (list);
+    g_object_unref (list);
+    trips = NULL;
+
+    /* A truncated response must not go unnoticed */
+    stream = trip_stream_new (NULL, got_trip, &trips);
+    g_assert (trip_stream_feed (stream, compressed, clen / 2, NULL));
+    g_assert (!trip_stream_finish (stream, &err));
+    g_assert (err != NULL);
+    g_clear_error (&err);
+    trip_stream_free (stream);
+    g_slist_free_full (trips, g_object_unref);
+
+    g_free (compressed);
+    g_free (binary);
+}
+
+
+/* Make sure we decompress to exactly the original data */
+static void
+test_decompress (void)
+{
+    gchar *binary, *compressed, *decomp = NULL;
+    gsize length, clen, len;
+    GError *err = NULL;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    compressed = gzip_data (binary, length, &clen);
+
+    g_assert_cmpint (decompress (compressed, clen, &decomp, &len, &err), ==, 0);
+    g_assert_no_error (err);
+    g_assert_cmpint (len, ==, length);
+    g_assert (!memcmp (decomp, binary, length));
+    g_free (decomp);
+
+    /* truncated data must not go unnoticed */
+    g_assert_cmpint (decompress (compressed, clen / 2, &decomp, &len, &err), ==, -1);
+    g_assert (err != NULL);
+    g_clear_error (&err);
+
+    g_free (compressed);
+    g_free (binary);
+}
+
+
+/* Make sure stations get decoded once per response */
+static void
+test_station_cache (void)
+{
+    gchar *binary;
+    gsize  length;
+    HafasBin6View view;
+    HafasBin6TripView trip;
+    HafasBin6StopView stop;
+    GHashTable *stations;
+    const HafasBin6DecodedStation *first, *again;
+    guint i;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    g_assert (hafas_bin6_view_init (&view, binary, length, NULL));
+    stations = station_cache_new ();
+
+    hafas_bin6_view_get_trip (&view, 0, &trip);
+    hafas_bin6_trip_view_get_departure (&trip, &stop);
+    first = decode_station (stations, &stop);
+    g_assert (first != NULL);
+    g_assert_cmpstr (first->name, ==, "Erpel(Rhein)");
+
+    /* All trips start in Erpel */
+    for (i = 1; i < view.num_trips; i++) {
+        hafas_bin6_view_get_trip (&view, i, &trip);
+        hafas_bin6_trip_view_get_departure (&trip, &stop);
+        again = decode_station (stations, &stop);
+        g_assert (again == first);
+    }
+    g_assert_cmpint (g_hash_table_size (stations), ==, 1);
+
+    g_hash_table_destroy (stations);
+    g_free (binary);
+}
+
+
+/* Make sure station names get converted with and without iconv */
+static void
+test_to_utf8 (void)
+{
+    GHashTable *iconvs = hafas_bin6_iconv_cache_new ();
+    gchar *str;
+
+    g_assert_cmpint (hafas_bin6_charset_from_name ("ISO-8859-1"), ==, HAFAS_BIN6_CHARSET_LATIN1);
+    g_assert_cmpint (hafas_bin6_charset_from_name ("windows-1252"), ==, HAFAS_BIN6_CHARSET_OTHER);
+
+    str = hafas_bin6_to_utf8 ("Rheinf\xe4hre, Erpel", HAFAS_BIN6_CHARSET_LATIN1, "iso-8859-1", iconvs);
+    g_assert_cmpstr (str, ==, "Rheinf\xc3\xa4hre, Erpel");
+    g_free (str);
+
+    g_assert (hafas_bin6_to_utf8 ("Rheinf\xe4hre", HAFAS_BIN6_CHARSET_ASCII, "us-ascii", iconvs) == NULL);
+    g_assert (hafas_bin6_to_utf8 ("Rheinf\xe4hre", HAFAS_BIN6_CHARSET_UTF8, "utf-8", iconvs) == NULL);
+    g_assert_cmpint (g_hash_table_size (iconvs), ==, 0);
+
+    str = hafas_bin6_to_utf8 ("\x80 Rheinf\xe4hre", HAFAS_BIN6_CHARSET_OTHER, "windows-1252", iconvs);
+    g_assert_cmpstr (str, ==, "\xe2\x82\xac Rheinf\xc3\xa4hre");
+    g_free (str);
+    str = hafas_bin6_to_utf8 ("Erpel", HAFAS_BIN6_CHARSET_OTHER, "windows-1252", iconvs);
+    g_assert_cmpstr (str, ==, "Erpel");
+    g_free (str);
+    g_assert_cmpint (g_hash_table_size (iconvs), ==, 1);
+
+    g_hash_table_destroy (iconvs);
+}
+
+
+/* Make sure corrupted and truncated blobs are rejected up front */
+static void
+test_corrupt (void)
+{
+    gchar *binary, *copy;
+    gsize  length;
+    GError *err = NULL;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+
+    /* line name pointing past the end */
+    copy = g_malloc (length);
+    memcpy (copy, binary, length);
+    HAFAS_BIN6_TRIP_PART(copy, 0, 0)->line_off = 0xffff;
+    g_assert (hafas_binary_parse_trips (copy, length, NULL, &err) == NULL);
+    g_assert_error (err, LPF_PROVIDER_ERROR, LPF_PROVIDER_ERROR_PARSE_FAILED);
+    g_clear_error (&err);
+    g_free (copy);
+
+    /* stops of the second trip cut off */
+    g_assert (hafas_binary_parse_trips (binary, 2000, NULL, &err) == NULL);
+    g_assert_error (err, LPF_PROVIDER_ERROR, LPF_PROVIDER_ERROR_PARSE_FAILED);
+    g_clear_error (&err);
+
+    g_free (binary);
+}
+
+
+/* Make sure the whole service day bitmap gets decoded */
+static void
+test_service_days (void)
+{
+    /* byte_base 1, service on day 8 + 8 + 2 and 8 + 8 + 7 */
+    const guchar sd_data[] = { 0x00, 0x00, 0x01, 0x00, 0x04, 0x00,
+                               0x00, 0x21, 0x00, 0x00 };
+    const HafasBin6ServiceDay *sd = (const HafasBin6ServiceDay*)sd_data;
+    gchar *binary;
+    gsize  length;
+    LpfTripList *trips;
+    LpfTrip *trip;
+    GDateTime *dep, *next;
+    GBytes *days;
+    guint first_day, i;
+    LpfStop *stop;
+
+    g_assert_cmpint (hafas_bin6_service_day_offset (sd), ==, 18);
+    days = hafas_bin6_service_days (sd, &first_day);
+    g_assert_cmpint (first_day, ==, 8);
+    g_assert_cmpint (g_bytes_get_size (days), ==, 2);
+    g_bytes_unref (days);
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    trips = hafas_binary_parse_trips (binary, length, NULL, NULL);
+    g_assert (trips != NULL);
+
+    /* All trips run on the day they depart only */
+    for (i = 0; i < lpf_trip_list_get_length (trips); i++) {
+        trip = lpf_trip_list_get (trips, i);
+        stop = lpf_trip_part_get_start (lpf_trip_get_parts (trip)->data);
+        g_object_get (stop, "departure", &dep, NULL);
+        next = g_date_time_add_days (dep, 1);
+        g_assert (lpf_trip_runs_on (trip, dep));
+        g_assert (!lpf_trip_runs_on (trip, next));
+        g_date_time_unref (next);
+        g_date_time_unref (dep);
+        g_object_unref (stop);
+    }
+
+    g_object_unref (trips);
+    g_free (binary);
+}
+
+
+/* Make sure attributes and comments get decoded lazily */
+static void
+test_attrs (void)
+{
+    gchar *binary;
+    gsize  length;
+    LpfTripList *trips;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+
+    trips = hafas_binary_parse_trips (binary, length, NULL, NULL);
+    /* trips don't need the response to decode them */
+    g_free (binary);
+    check_attrs (trips);
+    g_object_unref (trips);
+}
+
+
+/* Make sure parsing scales to responses larger than our real fixture */
+static void
+test_synthetic (void)
+{
+    const gchar *encodings[] = { "iso-8859-1", "utf-8", "windows-1252" };
+    HafasBin6WriterParams params = HAFAS_BIN6_WRITER_PARAMS_INIT;
+    GBytes *data, *gz;
+    LpfTripList *trips;
+    GSList *parts;
+    LpfStop *start;
+    GError *err = NULL;
+    gchar *decomp, *name, *expected;
+    gsize len;
+    guint i;
+
+    params.n_trips = 120;
+    params.n_parts = 3;
+    params.n_stops = 50;
+    params.n_stations = 1000;
+
+    for (i = 0; i < G_N_ELEMENTS (encodings); i++) {
+        params.encoding = encodings[i];
+        data = hafas_bin6_writer_build (&params, NULL);
+        g_assert (data != NULL);
+        gz = hafas_bin6_writer_gzip (data, NULL);
+        g_assert (gz != NULL);
+
+        g_assert_cmpint (decompress (g_bytes_get_data (gz, NULL), g_bytes_get_size (gz),
+                                     &decomp, &len, &err), ==, 0);
+        g_assert_no_error (err);
+        g_assert_cmpmem (decomp, len, g_bytes_get_data (data, NULL), g_bytes_get_size (data));
+
+        trips = hafas_binary_parse_trips (decomp, len, NULL, NULL);
+        g_assert_cmpint (lpf_trip_list_get_length (trips), ==, params.n_trips);
+        parts = lpf_trip_get_parts (lpf_trip_list_get (trips, 0));
+        g_assert_cmpint (g_slist_length (parts), ==, params.n_parts);
+        g_assert_cmpint (g_slist_length (lpf_trip_part_get_stops (parts->data)), ==, params.n_stops);
+
+        start = lpf_trip_part_get_start (parts->data);
+        g_object_get (start, "name", &name, NULL);
+        expected = hafas_bin6_writer_station_name (0);
+        g_assert_cmpstr (name, ==, expected);
+        g_free (expected);
+        g_free (name);
+        g_object_unref (start);
+
+        g_object_unref (trips);
+        g_free (decomp);
+        g_bytes_unref (gz);
+        g_bytes_unref (data);
+    }
+
+    /* stops beyond 16 bit indexes can't be represented */
+    params.n_trips = 1000;
+    g_assert (hafas_bin6_writer_build (&params, NULL) == NULL);
+}
+
+
+/* Make sure building trips on a thread pool keeps their order */
+static void
+test_parallel (void)
+{
+    gchar *binary;
+    gsize  length;
+    HafasBin6View view;
+    LpfTripList *seq, *par;
+    GSList *sparts, *pparts;
+    LpfLoc *sstop, *pstop;
+    gchar *sname, *pname;
+    guint n_chunks, i;
+
+    g_assert(g_file_get_contents(LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin", &binary, &length, NULL) == TRUE);
+    g_assert (hafas_bin6_view_init (&view, binary, length, NULL));
+    seq = hafas_binary_parse_trips (binary, length, NULL, NULL);
+
+    for (n_chunks = 2; n_chunks <= view.num_trips; n_chunks++) {
+        par = hafas_bin6_parse_trips_parallel (&view, n_chunks);
+        g_assert_cmpint (lpf_trip_list_get_length (par), ==, lpf_trip_list_get_length (seq));
+
+        for (i = 0; i < lpf_trip_list_get_length (seq); i++) {
+            g_object_get (G_OBJECT(lpf_trip_list_get (seq, i)), "parts", &sparts, NULL);
+            g_object_get (G_OBJECT(lpf_trip_list_get (par, i)), "parts", &pparts, NULL);
+            g_assert_cmpint (g_slist_length (pparts), ==, g_slist_length (sparts));
+
+            g_object_get (G_OBJECT(g_slist_last (sparts)->data), "end", &sstop, NULL);
+            g_object_get (G_OBJECT(g_slist_last (pparts)->data), "end", &pstop, NULL);
+            g_object_get (G_OBJECT(sstop), "name", &sname, NULL);
+            g_object_get (G_OBJECT(pstop), "name", &pname, NULL);
+            g_assert_cmpstr (pname, ==, sname);
+            g_free (sname);
+            g_free (pname);
+            g_object_unref (sstop);
+            g_object_unref (pstop);
+        }
+        g_object_unref (par);
+    }
 
+    g_object_unref (seq);
+    g_free (binary);
 }
 
 
@@ -141,7 +1122,25 @@ int main(int argc, char **argv)
     g_test_init (&argc, &argv, NULL);
 
     g_test_add_func ("/providers/de-db/parse_stations", test_parse_locs);
+    g_test_add_func ("/providers/de-db/locs_batch", test_locs_batch);
+    g_test_add_func ("/providers/de-db/locs_shape", test_locs_shape);
+    g_test_add_func ("/providers/de-db/locs_cache", test_locs_cache);
+    g_test_add_func ("/providers/de-db/station_index", test_station_index);
+    g_test_add_func ("/providers/de-db/station_near", test_station_near);
+    g_test_add_func ("/providers/de-db/locs_progressive", test_locs_progressive);
+    g_test_add_func ("/providers/de-db/station_db", test_station_db);
+    g_test_add_func ("/providers/de-db/station_opaque", test_station_opaque);
     g_test_add_func ("/providers/de-db/parse_trips", test_parse_trips);
+    g_test_add_func ("/providers/de-db/view", test_view);
+    g_test_add_func ("/providers/de-db/stream", test_stream);
+    g_test_add_func ("/providers/de-db/decompress", test_decompress);
+    g_test_add_func ("/providers/de-db/station_cache", test_station_cache);
+    g_test_add_func ("/providers/de-db/to_utf8", test_to_utf8);
+    g_test_add_func ("/providers/de-db/corrupt", test_corrupt);
+    g_test_add_func ("/providers/de-db/parallel", test_parallel);
+    g_test_add_func ("/providers/de-db/service_days", test_service_days);
+    g_test_add_func ("/providers/de-db/attrs", test_attrs);
+    g_test_add_func ("/providers/de-db/synthetic", test_synthetic);
 
     ret = g_test_run ();
     return ret;
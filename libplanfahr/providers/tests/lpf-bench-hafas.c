@@ -0,0 +1,452 @@
+/*
+ * lpf-bench-hafas.c: throughput benchmarks for the hafas parsers
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+/*
+ * Runs the parsers over a corpus of fixtures and prints one JSON
+ * object per benchmark and fixture so results can be compared
+ * between releases. Fixtures are either plain or gzipped hafas
+ * binary trip data or XML location lists.
+ */
+
+#include <time.h>
+
+#include "../hafas-bin6.c"
+
+#include <libxml/xpath.h>
+
+#ifdef HAVE___LIBC_MALLOC
+/* Count allocations by interposing the libc allocator */
+extern void *__libc_malloc (size_t size);
+extern void *__libc_calloc (size_t nmemb, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+
+static volatile gsize n_allocs;
+
+void *
+malloc (size_t size)
+{
+    __sync_fetch_and_add (&n_allocs, 1);
+    return __libc_malloc (size);
+}
+
+void *
+calloc (size_t nmemb, size_t size)
+{
+    __sync_fetch_and_add (&n_allocs, 1);
+    return __libc_calloc (nmemb, size);
+}
+
+void *
+realloc (void *ptr, size_t size)
+{
+    __sync_fetch_and_add (&n_allocs, 1);
+    return __libc_realloc (ptr, size);
+}
+
+# define ALLOCS() ((gssize)n_allocs)
+#else
+# define ALLOCS() ((gssize)-1)
+#endif /* HAVE___LIBC_MALLOC */
+
+
+typedef struct _BenchResult {
+    const gchar *bench;
+    const gchar *fixture;
+    guint iterations;
+    gsize bytes;        /* processed per iteration */
+    guint trips;        /* per iteration */
+    guint stops;        /* per iteration */
+    gint64 ns;          /* total */
+    gssize allocs;      /* total, -1 if not counted */
+} BenchResult;
+
+
+static gint iterations = 1000;
+static gchar **fixtures;
+
+static GOptionEntry entries[] = {
+    { "iterations", 'n', 0, G_OPTION_ARG_INT, &iterations, "Iterations per benchmark", "N" },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &fixtures, NULL, "[FIXTURE...]" },
+    { NULL }
+};
+
+
+static gint64
+now_ns (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+}
+
+
+static void
+bench_start (BenchResult *r, const gchar *bench, const gchar *fixture)
+{
+    memset (r, 0, sizeof (BenchResult));
+    r->bench = bench;
+    r->fixture = fixture;
+    r->iterations = iterations;
+    r->allocs = ALLOCS();
+    r->ns = now_ns ();
+}
+
+
+static void
+bench_stop (BenchResult *r)
+{
+    gssize allocs = ALLOCS();
+
+    r->ns = now_ns () - r->ns;
+    r->allocs = (allocs < 0) ? -1 : allocs - r->allocs;
+}
+
+
+/* Print the result as a single line of JSON */
+static void
+report (const BenchResult *r)
+{
+    gdouble iters = r->iterations;
+
+    g_print ("{\"version\": \"%s\", \"bench\": \"%s\", \"fixture\": \"%s\", "
+             "\"iterations\": %u, \"ns_per_iter\": %.1f",
+             VERSION, r->bench, r->fixture, r->iterations, r->ns / iters);
+    if (r->trips)
+        g_print (", \"trips\": %u, \"ns_per_trip\": %.1f",
+                 r->trips, r->ns / iters / r->trips);
+    if (r->stops)
+        g_print (", \"stops\": %u, \"ns_per_stop\": %.1f",
+                 r->stops, r->ns / iters / r->stops);
+    if (r->bytes && r->ns)
+        g_print (", \"bytes\": %" G_GSIZE_FORMAT ", \"mb_per_s\": %.2f",
+                 r->bytes, (r->bytes * iters / 1e6) / (r->ns / 1e9));
+    if (r->allocs >= 0) {
+        g_print (", \"allocs_per_iter\": %.1f", r->allocs / iters);
+        if (r->trips)
+            g_print (", \"allocs_per_trip\": %.1f", r->allocs / iters / r->trips);
+    }
+    g_print ("}\n");
+}
+
+
+static gchar*
+gzip_data (const gchar *data, gsize len, gsize *outlen)
+{
+    GConverter *comp;
+    gsize room = len + 1024, read_, written;
+    gchar *out = g_malloc (room);
+
+    comp = (GConverter *)g_zlib_compressor_new (G_ZLIB_COMPRESSOR_FORMAT_GZIP, -1);
+    if (g_converter_convert (comp, data, len, out, room,
+                             G_CONVERTER_INPUT_AT_END,
+                             &read_, &written, NULL) != G_CONVERTER_FINISHED) {
+        g_free (out);
+        out = NULL;
+    }
+    g_object_unref (comp);
+    *outlen = written;
+    return out;
+}
+
+
+/* Count the stops the way they end up as LpfStop objects */
+static guint
+count_stops (const HafasBin6View *view)
+{
+    HafasBin6TripView tv;
+    HafasBin6PartView pv;
+    guint i, j, stops = 0;
+
+    for (i = 0; i < view->num_trips; i++) {
+        hafas_bin6_view_get_trip (view, i, &tv);
+        for (j = 0; j < hafas_bin6_trip_view_get_n_parts (&tv); j++) {
+            hafas_bin6_trip_view_get_part (&tv, j, &pv);
+            stops += 2 + hafas_bin6_part_view_get_n_stops (&pv);
+        }
+    }
+    return stops;
+}
+
+
+static void
+bench_trips (const gchar *fixture, const gchar *data, gsize len,
+             const gchar *compressed, gsize clen)
+{
+    HafasBin6View view;
+    HafasBin6TripView tv;
+    GHashTable *iconvs;
+    BenchResult r;
+    LpfTripList *trips;
+    GError *err = NULL;
+    gchar *out;
+    gsize outlen;
+    guint i, t, stops;
+
+    if (!hafas_bin6_view_init (&view, data, len, &err) ||
+        !hafas_bin6_view_check (&view, &err)) {
+        g_printerr ("%s: %s\n", fixture, err->message);
+        g_clear_error (&err);
+        return;
+    }
+    stops = count_stops (&view);
+    iconvs = hafas_bin6_iconv_cache_new ();
+
+    /* warm up caches */
+    g_object_unref (hafas_binary_parse_trips (data, len, iconvs, NULL));
+
+    bench_start (&r, "decompress", fixture);
+    for (i = 0; i < iterations; i++) {
+        if (decompress (compressed, clen, &out, &outlen, &err) < 0) {
+            g_printerr ("%s: %s\n", fixture, err->message);
+            g_clear_error (&err);
+            break;
+        }
+        g_free (out);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    report (&r);
+
+    bench_start (&r, "parse_trips", fixture);
+    for (i = 0; i < iterations; i++) {
+        trips = hafas_binary_parse_trips (data, len, iconvs, NULL);
+        g_object_unref (trips);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    r.trips = view.num_trips;
+    r.stops = stops;
+    report (&r);
+
+    bench_start (&r, "parse_service_day", fixture);
+    for (i = 0; i < iterations; i++) {
+        for (t = 0; t < view.num_trips; t++)
+            lpf_provider_hafas_bin6_parse_service_day (data, t);
+    }
+    bench_stop (&r);
+    r.trips = view.num_trips;
+    report (&r);
+
+    bench_start (&r, "date_time", fixture);
+    for (i = 0; i < iterations; i++) {
+        for (t = 0; t < view.num_trips; t++) {
+            hafas_bin6_view_get_trip (&view, t, &tv);
+            g_date_time_unref (lpf_provider_hafas_bin6_date_time (view.days, tv.day_off, 12, 34));
+        }
+    }
+    bench_stop (&r);
+    r.trips = view.num_trips;
+    report (&r);
+
+    g_hash_table_destroy (iconvs);
+}
+
+
+/* The DOM and XPath based parser the streaming one replaced, as a baseline */
+static GSList*
+parse_locs_dom (const char *xml)
+{
+    xmlDocPtr doc;
+    xmlXPathContextPtr context = NULL;
+    xmlXPathObjectPtr result = NULL;
+    xmlNodeSetPtr nodeset;
+    gchar *name, *x, *y;
+    GSList *locs = NULL;
+    LpfLoc *loc;
+    gint i;
+
+    doc = xmlParseMemory(xml, strlen(xml));
+    if (doc == NULL)
+        return NULL;
+
+    context = xmlXPathNewContext(doc);
+    if (context == NULL)
+        goto out;
+    result = xmlXPathEvalExpression(BAD_CAST "//MLc[@t=\"ST\"]", context);
+    if (result == NULL || xmlXPathNodeSetIsEmpty(result->nodesetval))
+        goto out;
+
+    nodeset = result->nodesetval;
+    for (i = 0; i < nodeset->nodeNr; i++) {
+        name = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "n");
+        x = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "x");
+        y = (gchar*) xmlGetProp(nodeset->nodeTab[i], BAD_CAST "y");
+        loc = (LpfLoc*) g_object_new (LPF_TYPE_LOC, "name", name,
+                                      "long", g_ascii_strtod(x, NULL) / 1000000.0,
+                                      "lat", g_ascii_strtod(y, NULL) / 1000000.0,
+                                      NULL);
+        lpf_loc_set_opaque (loc, xmlGetProp(nodeset->nodeTab[i], BAD_CAST "i"));
+        locs = g_slist_prepend(locs, loc);
+        xmlFree(name);
+        xmlFree(x);
+        xmlFree(y);
+    }
+    locs = g_slist_reverse (locs);
+ out:
+    xmlXPathFreeContext(context);
+    xmlXPathFreeObject(result);
+    xmlFreeDoc(doc);
+    return locs;
+}
+
+
+static void
+bench_locs (const gchar *fixture, const gchar *xml, gsize len)
+{
+    xmlParserCtxtPtr parser = locs_parser_new ();
+    HafasBin6LocsCache *cache;
+    BenchResult r;
+    GSList *locs;
+    guint i, n;
+
+    locs = parse_locs_xml (parser, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+    n = g_slist_length (locs);
+    g_slist_free_full (locs, g_object_unref);
+
+    bench_start (&r, "parse_locs_dom", fixture);
+    for (i = 0; i < iterations; i++) {
+        locs = parse_locs_dom (xml);
+        g_slist_free_full (locs, g_object_unref);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    report (&r);
+
+    bench_start (&r, "parse_locs_xml_new_ctxt", fixture);
+    for (i = 0; i < iterations; i++) {
+        locs = parse_locs_xml (NULL, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+        g_slist_free_full (locs, g_object_unref);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    report (&r);
+
+    bench_start (&r, "parse_locs_xml", fixture);
+    for (i = 0; i < iterations; i++) {
+        locs = parse_locs_xml (parser, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+        g_slist_free_full (locs, g_object_unref);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    report (&r);
+    /* a repeated lookup answered from the location cache */
+    cache = hafas_bin6_locs_cache_new (HAFAS_BIN6_LOCS_CACHE_SIZE, G_MAXINT64);
+    locs = parse_locs_xml (parser, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 0);
+    hafas_bin6_locs_cache_insert (cache, fixture, LPF_PROVIDER_GET_LOCS_STATIONS, 0, locs, 0);
+    g_slist_free_full (locs, g_object_unref);
+    bench_start (&r, "locs_cache_hit", fixture);
+    for (i = 0; i < iterations; i++) {
+        hafas_bin6_locs_cache_lookup (cache, fixture, LPF_PROVIDER_GET_LOCS_STATIONS, 0, 0, &locs);
+        g_slist_free_full (locs, g_object_unref);
+    }
+    bench_stop (&r);
+    report (&r);
+    hafas_bin6_locs_cache_free (cache);
+
+    /* what an autocompletion showing five entries needs */
+    bench_start (&r, "parse_locs_xml_max5", fixture);
+    for (i = 0; i < iterations; i++) {
+        locs = parse_locs_xml (parser, xml, LPF_PROVIDER_GET_LOCS_STATIONS, 5);
+        g_slist_free_full (locs, g_object_unref);
+    }
+    bench_stop (&r);
+    r.bytes = len;
+    report (&r);
+
+    g_print ("{\"version\": \"%s\", \"bench\": \"parse_locs_xml\", \"fixture\": \"%s\", "
+             "\"locs\": %u}\n", VERSION, fixture, n);
+
+    xmlFreeParserCtxt (parser);
+}
+
+
+static void
+bench_fixture (const gchar *path)
+{
+    gchar *contents, *name, *data = NULL, *compressed = NULL;
+    gsize len, dlen, clen;
+    GError *err = NULL;
+
+    if (!g_file_get_contents (path, &contents, &len, &err)) {
+        g_printerr ("%s\n", err->message);
+        g_clear_error (&err);
+        return;
+    }
+    name = g_path_get_basename (path);
+
+    if (len > 0 && contents[0] == '<') {
+        bench_locs (name, contents, len);
+    } else if (len > 2 && (guchar)contents[0] == 0x1f && (guchar)contents[1] == 0x8b) {
+        if (decompress (contents, len, &data, &dlen, &err) < 0) {
+            g_printerr ("%s: %s\n", name, err->message);
+            g_clear_error (&err);
+        } else
+            bench_trips (name, data, dlen, contents, len);
+    } else if (len > 0) {
+        compressed = gzip_data (contents, len, &clen);
+        if (compressed)
+            bench_trips (name, contents, len, compressed, clen);
+    }
+
+    g_free (compressed);
+    g_free (data);
+    g_free (name);
+    g_free (contents);
+}
+
+
+int main(int argc, char **argv)
+{
+    GOptionContext *context;
+    GError *err = NULL;
+    const gchar *defaults[] = {
+        LPF_TEST_SRCDIR "/hafas-bin-6-station-query-1.bin",
+        LPF_TEST_SRCDIR "/hafas-locs-1.xml",
+        NULL,
+    };
+    const gchar * const *f;
+
+#if ! GLIB_CHECK_VERSION(2, 36, 0)
+    g_type_init ();
+#endif
+
+    context = g_option_context_new ("- benchmark the hafas parsers");
+    g_option_context_add_main_entries (context, entries, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &err)) {
+        g_printerr ("%s\n", err->message);
+        g_clear_error (&err);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    if (iterations <= 0) {
+        g_printerr ("Iterations must be positive\n");
+        return 1;
+    }
+
+    for (f = fixtures ? (const gchar * const *)fixtures : defaults; *f; f++)
+        bench_fixture (*f);
+
+    g_strfreev (fixtures);
+    return 0;
+}
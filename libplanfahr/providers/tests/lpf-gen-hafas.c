@@ -0,0 +1,103 @@
+/*
+ * lpf-gen-hafas.c: generate hafas binary fixtures
+ *
+ * Copyright (C) 2014 Guido Günther
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.	See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ * Author: Guido Günther <agx@sigxcpu.org>
+ */
+
+#include <gio/gio.h>
+
+#include "hafas-bin6-writer.h"
+
+static gint n_trips = 100;
+static gint n_parts = 3;
+static gint n_stops = 50;
+static gint n_stations = 1000;
+static gchar *encoding;
+static gboolean raw;
+
+static GOptionEntry entries[] = {
+    { "trips", 't', 0, G_OPTION_ARG_INT, &n_trips, "Number of trips", "N" },
+    { "parts", 'p', 0, G_OPTION_ARG_INT, &n_parts, "Parts per trip", "N" },
+    { "stops", 's', 0, G_OPTION_ARG_INT, &n_stops, "Intermediate stops per part", "N" },
+    { "stations", 'S', 0, G_OPTION_ARG_INT, &n_stations, "Size of the stations table", "N" },
+    { "encoding", 'e', 0, G_OPTION_ARG_STRING, &encoding, "Encoding of the strings table", "ENC" },
+    { "raw", 'r', 0, G_OPTION_ARG_NONE, &raw, "Don't gzip the output", NULL },
+    { NULL }
+};
+
+
+int main(int argc, char **argv)
+{
+    HafasBin6WriterParams params = HAFAS_BIN6_WRITER_PARAMS_INIT;
+    GOptionContext *context;
+    GBytes *data = NULL, *gz;
+    GError *err = NULL;
+    int ret = 1;
+
+#if ! GLIB_CHECK_VERSION(2, 36, 0)
+    g_type_init ();
+#endif
+
+    context = g_option_context_new ("OUTFILE - generate a hafas binary fixture");
+    g_option_context_add_main_entries (context, entries, NULL);
+    if (!g_option_context_parse (context, &argc, &argv, &err)) {
+        g_option_context_free (context);
+        goto out;
+    }
+    g_option_context_free (context);
+
+    if (argc != 2 || n_trips <= 0 || n_parts <= 0 || n_stops < 0 || n_stations <= 0) {
+        g_printerr ("Usage: %s [OPTION...] OUTFILE\n", g_get_prgname ());
+        goto out;
+    }
+
+    params.n_trips = n_trips;
+    params.n_parts = n_parts;
+    params.n_stops = n_stops;
+    params.n_stations = n_stations;
+    if (encoding)
+        params.encoding = encoding;
+
+    if ((data = hafas_bin6_writer_build (&params, &err)) == NULL)
+        goto out;
+
+    if (!raw) {
+        if ((gz = hafas_bin6_writer_gzip (data, &err)) == NULL)
+            goto out;
+        g_bytes_unref (data);
+        data = gz;
+    }
+
+    if (!g_file_set_contents (argv[1],
+                              g_bytes_get_data (data, NULL),
+                              g_bytes_get_size (data),
+                              &err))
+        goto out;
+    ret = 0;
+
+ out:
+    if (err) {
+        g_printerr ("%s\n", err->message);
+        g_clear_error (&err);
+    }
+    if (data)
+        g_bytes_unref (data);
+    g_free (encoding);
+    return ret;
+}
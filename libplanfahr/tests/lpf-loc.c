@@ -30,6 +30,7 @@ typedef struct {
     LpfProvider *provider;
     GMainLoop *loop;
     gboolean got_loc_reached;
+    guint n_batch_locs[3];
 } TestFixture;
 
 
@@ -67,6 +68,7 @@ test_got_loc (GSList *locs, gpointer user_data, GError *err)
     g_assert_cmpint (g_slist_length (locs), ==, 1);
     loc = g_slist_nth (locs, 0)->data;
     g_assert_cmpstr ("testloc1", ==, lpf_loc_get_name (loc));
+    lpf_provider_free_locs (fixture->provider, locs);
 }
 
 
@@ -84,6 +86,205 @@ test_lpf_loc(TestFixture *fixture, gconstpointer user_data)
 }
 
 
+static void
+test_got_batch_locs (guint idx, GSList *locs, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+
+    g_assert_no_error (err);
+    g_assert_cmpint (idx, <, 3);
+    /* each match is delivered once and in order */
+    g_assert_cmpint (fixture->n_batch_locs[idx], ==, 0);
+    if (idx > 0)
+        g_assert_cmpint (fixture->n_batch_locs[idx - 1], >, 0);
+    fixture->n_batch_locs[idx] = g_slist_length (locs) + 1;
+    lpf_provider_free_locs (fixture->provider, locs);
+}
+
+
+static void
+test_got_batch_done (GSList *locs, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+
+    g_assert_no_error (err);
+    g_assert_null (locs);
+    g_assert_false (fixture->got_loc_reached);
+    fixture->got_loc_reached = TRUE;
+    g_main_loop_quit (fixture->loop);
+}
+
+
+/* Providers without batch support look up one match after the other */
+static void
+test_lpf_loc_batch(TestFixture *fixture, gconstpointer user_data)
+{
+    const gchar *matches[] = { "testloc1", "nomatch", "testloc2", NULL };
+
+    fixture->loop = g_main_loop_new (NULL, FALSE);
+
+    g_assert_cmpint (lpf_provider_get_locs_batch (fixture->provider, matches, 0,
+                                                  test_got_batch_locs,
+                                                  test_got_batch_done,
+                                                  fixture), ==, 0);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->got_loc_reached);
+    g_assert_cmpint (fixture->n_batch_locs[0], ==, 2);
+    g_assert_cmpint (fixture->n_batch_locs[1], ==, 1);
+    g_assert_cmpint (fixture->n_batch_locs[2], ==, 2);
+    g_main_loop_unref (fixture->loop);
+}
+
+
+static void
+test_got_capped_locs (GSList *locs, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+
+    g_assert_no_error (err);
+    fixture->got_loc_reached = TRUE;
+    g_main_loop_quit (fixture->loop);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_assert_cmpstr ("testloc1", ==, lpf_loc_get_name (locs->data));
+    lpf_provider_free_locs (fixture->provider, locs);
+}
+
+
+/* Results get capped for providers that can't do so themselves */
+static void
+test_lpf_loc_full(TestFixture *fixture, gconstpointer user_data)
+{
+    fixture->loop = g_main_loop_new (NULL, FALSE);
+
+    /* matches both test locations */
+    g_assert_cmpint (lpf_provider_get_locs_full (fixture->provider, "testloc1 testloc2",
+                                                 LPF_PROVIDER_GET_LOCS_STATIONS, 1,
+                                                 test_got_capped_locs, fixture), ==, 0);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->got_loc_reached);
+    g_main_loop_unref (fixture->loop);
+}
+
+
+static void
+test_got_loc_list (LpfLocList *locs, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+
+    g_assert_no_error (err);
+    fixture->got_loc_reached = TRUE;
+    g_main_loop_quit (fixture->loop);
+    g_assert_true (g_list_model_get_item_type (G_LIST_MODEL (locs)) == LPF_TYPE_LOC);
+    g_assert_cmpuint (lpf_loc_list_get_length (locs), ==, 2);
+    g_assert_cmpstr ("testloc1", ==, lpf_loc_get_name (lpf_loc_list_get (locs, 0)));
+    g_assert_cmpstr ("testloc2", ==, lpf_loc_get_name (lpf_loc_list_get (locs, 1)));
+    g_object_unref (locs);
+}
+
+
+/* Linked list results get turned into a list */
+static void
+test_lpf_loc_list(TestFixture *fixture, gconstpointer user_data)
+{
+    fixture->loop = g_main_loop_new (NULL, FALSE);
+
+    g_assert_cmpint (lpf_provider_get_loc_list (fixture->provider, "testloc1 testloc2",
+                                                LPF_PROVIDER_GET_LOCS_STATIONS, 0,
+                                                test_got_loc_list, fixture), ==, 0);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->got_loc_reached);
+    g_main_loop_unref (fixture->loop);
+}
+
+
+static void
+test_got_progressive_locs (GSList *locs, gboolean final, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+
+    g_assert_no_error (err);
+    /* no local knowledge so there's only the final answer */
+    g_assert_true (final);
+    g_assert_false (fixture->got_loc_reached);
+    fixture->got_loc_reached = TRUE;
+    g_main_loop_quit (fixture->loop);
+    g_assert_cmpint (g_slist_length (locs), ==, 1);
+    g_assert_cmpstr ("testloc2", ==, lpf_loc_get_name (locs->data));
+    lpf_provider_free_locs (fixture->provider, locs);
+}
+
+
+/* Providers without progressive lookups answer once */
+static void
+test_lpf_loc_progressive(TestFixture *fixture, gconstpointer user_data)
+{
+    fixture->loop = g_main_loop_new (NULL, FALSE);
+
+    g_assert_cmpint (lpf_provider_get_locs_progressive (fixture->provider, "testloc2",
+                                                        LPF_PROVIDER_GET_LOCS_STATIONS, 0,
+                                                        test_got_progressive_locs, fixture), ==, 0);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->got_loc_reached);
+    g_main_loop_unref (fixture->loop);
+}
+
+
+/* Equal names are shared between locations */
+static void
+test_lpf_loc_intern(void)
+{
+    gchar *name = g_strdup ("testloc1");
+    LpfLoc *a = g_object_new (LPF_TYPE_LOC, "name", name, NULL);
+    LpfLoc *b = g_object_new (LPF_TYPE_LOC, "name", "testloc1", NULL);
+
+    g_free (name);
+    g_assert_cmpstr (lpf_loc_get_name (a), ==, "testloc1");
+    g_assert_true (lpf_loc_get_name (a) == lpf_loc_get_name (b));
+
+    g_object_unref (a);
+    g_assert_cmpstr (lpf_loc_get_name (b), ==, "testloc1");
+    g_object_unref (b);
+}
+
+
+/* Locations with an id are the same if their ids match */
+static void
+test_lpf_loc_identity(void)
+{
+    LpfLoc *a = g_object_new (LPF_TYPE_LOC, "name", "testloc1", "long", 7.0, "lat", 50.0, NULL);
+    LpfLoc *b = g_object_new (LPF_TYPE_LOC, "name", "testloc1", "long", 7.0, "lat", 50.0, NULL);
+    LpfLoc *c = g_object_new (LPF_TYPE_LOC, "name", "testloc2", NULL);
+    GHashTable *seen = g_hash_table_new (lpf_loc_hash, lpf_loc_equal);
+
+    /* without ids name and position count */
+    g_assert_true (lpf_loc_equal (a, b));
+    g_assert_cmpuint (lpf_loc_hash (a), ==, lpf_loc_hash (b));
+    g_assert_false (lpf_loc_equal (a, c));
+
+    lpf_loc_set_id (a, LPF_TEST_PROVIDER, 4711);
+    g_assert_cmpuint (lpf_loc_get_id (a), ==, 4711);
+    g_assert_cmpstr (lpf_loc_get_provider (a), ==, LPF_TEST_PROVIDER);
+    g_assert_false (lpf_loc_equal (a, b));
+
+    /* with ids the name doesn't matter */
+    lpf_loc_set_id (c, LPF_TEST_PROVIDER, 4711);
+    g_assert_true (lpf_loc_equal (a, c));
+    g_assert_cmpuint (lpf_loc_hash (a), ==, lpf_loc_hash (c));
+
+    lpf_loc_set_id (b, "other", 4711);
+    g_assert_false (lpf_loc_equal (a, b));
+
+    g_hash_table_add (seen, a);
+    g_assert_true (g_hash_table_contains (seen, c));
+    g_assert_false (g_hash_table_contains (seen, b));
+
+    g_hash_table_destroy (seen);
+    g_object_unref (a);
+    g_object_unref (b);
+    g_object_unref (c);
+}
+
+
 int main(int argc, char **argv)
 {
     gboolean ret;
@@ -93,6 +294,16 @@ int main(int argc, char **argv)
 
     g_test_add ("/libplanfahr/lpf-loc", TestFixture, NULL,
                 fixture_setup, test_lpf_loc, fixture_teardown);
+    g_test_add ("/libplanfahr/lpf-loc/batch", TestFixture, NULL,
+                fixture_setup, test_lpf_loc_batch, fixture_teardown);
+    g_test_add ("/libplanfahr/lpf-loc/full", TestFixture, NULL,
+                fixture_setup, test_lpf_loc_full, fixture_teardown);
+    g_test_add ("/libplanfahr/lpf-loc/list", TestFixture, NULL,
+                fixture_setup, test_lpf_loc_list, fixture_teardown);
+    g_test_add ("/libplanfahr/lpf-loc/progressive", TestFixture, NULL,
+                fixture_setup, test_lpf_loc_progressive, fixture_teardown);
+    g_test_add_func ("/libplanfahr/lpf-loc/intern", test_lpf_loc_intern);
+    g_test_add_func ("/libplanfahr/lpf-loc/identity", test_lpf_loc_identity);
 
     ret = g_test_run ();
     return ret;
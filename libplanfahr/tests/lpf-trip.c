@@ -74,6 +74,8 @@ test_got_trips (GSList *trips, gpointer user_data, GError *err)
     g_object_get (part, "line", &line, NULL);
     g_assert_nonnull (part);
     g_assert_cmpstr ("at the end of the longest", ==, line);
+    g_free (line);
+    lpf_provider_free_trips (fixture->provider, trips);
 }
 
 
@@ -98,6 +100,209 @@ test_lpf_trip(TestFixture *fixture, gconstpointer user_data)
 }
 
 
+static void
+test_got_trip_list (LpfTripList *trips, gpointer user_data, GError *err)
+{
+    TestFixture *fixture = user_data;
+    LpfTripPart *part;
+    gchar *line;
+
+    g_assert_false (fixture->got_trips_reached);
+    fixture->got_trips_reached = TRUE;
+    g_main_loop_quit (fixture->loop);
+    g_assert_no_error (err);
+    g_assert_cmpint (lpf_trip_list_get_length (trips), ==, 1);
+    part = lpf_trip_get_parts (lpf_trip_list_get (trips, 0))->data;
+    g_assert_nonnull (part);
+    g_object_get (part, "line", &line, NULL);
+    g_assert_cmpstr (line, ==, "at the end of the longest");
+    g_free (line);
+    g_object_unref (trips);
+}
+
+
+static void
+test_lpf_trip_list(TestFixture *fixture, gconstpointer user_data)
+{
+    GDateTime *when = g_date_time_new_now_local ();
+    LpfLoc *start, *end;
+
+    fixture->loop = g_main_loop_new (NULL, FALSE);
+
+    start = g_object_new(LPF_TYPE_LOC, "name", "testloc1", NULL);
+    end = g_object_new(LPF_TYPE_LOC, "name", "testloc2", NULL);
+
+    lpf_provider_get_trip_list(fixture->provider, start, end, when, 0, test_got_trip_list, fixture);
+    g_main_loop_run (fixture->loop);
+    g_assert_true (fixture->got_trips_reached);
+    g_date_time_unref (when);
+    g_object_unref (start);
+    g_object_unref (end);
+    g_main_loop_unref (fixture->loop);
+}
+
+
+/* Lists index in order and convert to and from linked lists */
+static void
+test_lpf_trip_list_slist(void)
+{
+    LpfTripList *list = lpf_trip_list_new (0);
+    LpfTrip *trips[3];
+    GPtrArray *array;
+    GSList *slist;
+    guint i;
+
+    for (i = 0; i < G_N_ELEMENTS (trips); i++) {
+        trips[i] = g_object_new (LPF_TYPE_TRIP, NULL);
+        lpf_trip_list_add (list, trips[i]);
+    }
+    g_assert_cmpuint (lpf_trip_list_get_length (list), ==, 3);
+    g_assert_true (g_list_model_get_item_type (G_LIST_MODEL (list)) == LPF_TYPE_TRIP);
+    for (i = 0; i < G_N_ELEMENTS (trips); i++)
+        g_assert_true (lpf_trip_list_get (list, i) == trips[i]);
+
+    slist = lpf_trip_list_to_slist (list);
+    g_object_unref (list);
+    g_assert_cmpuint (g_slist_length (slist), ==, 3);
+    g_assert_true (slist->data == trips[0]);
+
+    list = lpf_trip_list_new_from_slist (slist);
+    g_assert_cmpuint (lpf_trip_list_get_length (list), ==, 3);
+    g_assert_true (lpf_trip_list_get (list, 2) == trips[2]);
+    g_object_unref (list);
+
+    array = g_ptr_array_new_full (1, g_object_unref);
+    g_ptr_array_add (array, g_object_new (LPF_TYPE_TRIP, NULL));
+    list = lpf_trip_list_new_take (array);
+    g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 1);
+    g_object_unref (list);
+}
+
+
+/* Objects built by the typed constructors show up in the properties */
+static void
+test_lpf_trip_new_take(void)
+{
+    GDateTime *dep = g_date_time_new_utc (2014, 2, 27, 10, 0, 0);
+    GDateTime *arr = g_date_time_new_utc (2014, 2, 27, 10, 30, 0);
+    gint32 dep_min = g_date_time_to_unix (dep) / 60;
+    gint32 arr_min = g_date_time_to_unix (arr) / 60;
+    GDateTime *dt;
+    LpfStop *start, *end, *stop;
+    LpfTripPart *part;
+    LpfTrip *trip;
+    gchar *line, *plat;
+    gint delay;
+
+    start = lpf_stop_new_full ("testloc1", 3.14, 15.0, LPF_STOP_NO_TIME, dep_min,
+                               LPF_STOP_NO_TIME, LPF_STOP_NO_TIME, NULL, "1a");
+    end = lpf_stop_new_full ("testloc2", 2.71, 82.0, arr_min, LPF_STOP_NO_TIME,
+                             arr_min + 5, LPF_STOP_NO_TIME, "7", NULL);
+    part = lpf_trip_part_new_take (start, end, "at the end of the longest", NULL);
+    trip = lpf_trip_new_take (g_slist_prepend (NULL, part), LPF_TRIP_STATUS_FLAGS_CANCELED,
+                              NULL, NULL);
+
+    g_assert_true (lpf_trip_get_parts (trip)->data == part);
+    g_object_get (part, "line", &line, NULL);
+    g_assert_cmpstr (line, ==, "at the end of the longest");
+    g_free (line);
+
+    stop = lpf_trip_part_get_start (part);
+    g_assert_cmpstr (lpf_loc_get_name (LPF_LOC (stop)), ==, "testloc1");
+    g_assert_cmpfloat (lpf_loc_get_long (LPF_LOC (stop)), ==, 3.14);
+    g_object_get (stop, "departure", &dt, "dep_plat", &plat, NULL);
+    g_assert_true (g_date_time_equal (dt, dep));
+    g_assert_cmpstr (plat, ==, "1a");
+    g_date_time_unref (dt);
+    g_free (plat);
+    g_object_unref (stop);
+
+    stop = lpf_trip_part_get_end (part);
+    g_assert_cmpfloat (lpf_loc_get_lat (LPF_LOC (stop)), ==, 82.0);
+    g_object_get (stop, "arrival_delay", &delay, "arr_plat", &plat, NULL);
+    g_assert_cmpint (delay, ==, 5);
+    g_assert_cmpstr (plat, ==, "7");
+    g_free (plat);
+    g_object_unref (stop);
+
+    g_object_unref (trip);
+    g_date_time_unref (dep);
+    g_date_time_unref (arr);
+}
+
+
+/* Stop times set as date times read back as minutes and vice versa */
+static void
+test_lpf_trip_stop_times(void)
+{
+    GDateTime *dep = g_date_time_new_utc (2014, 2, 27, 10, 0, 0);
+    GDateTime *rt_dep = g_date_time_new_utc (2014, 2, 27, 9, 58, 0);
+    GDateTime *dt;
+    LpfStop *stop;
+    gint delay;
+
+    stop = g_object_new (LPF_TYPE_STOP, NULL);
+    g_assert_cmpint (lpf_stop_get_arrival_minutes (stop), ==, LPF_STOP_NO_TIME);
+    g_object_get (stop, "arrival", &dt, NULL);
+    g_assert_null (dt);
+
+    g_object_set (stop, "departure", dep, "rt_departure", rt_dep, NULL);
+    g_assert_cmpint (lpf_stop_get_departure_minutes (stop), ==,
+                     g_date_time_to_unix (dep) / 60);
+    g_assert_cmpint (lpf_stop_get_departure_delay (stop), ==, -2);
+    g_assert_cmpint (lpf_stop_get_arrival_delay (stop), ==, 0);
+    g_object_get (stop, "departure_delay", &delay, "rt_departure", &dt, NULL);
+    g_assert_cmpint (delay, ==, -2);
+    g_assert_true (g_date_time_equal (dt, rt_dep));
+    g_date_time_unref (dt);
+
+    g_object_unref (stop);
+    g_date_time_unref (dep);
+    g_date_time_unref (rt_dep);
+}
+
+
+static void
+test_lpf_trip_runs_on(void)
+{
+    /* runs on the 1st, 3rd and 10th day */
+    const guchar bits[] = { 0xa0, 0x40 };
+    GDateTime *start = g_date_time_new_utc (2014, 2, 27, 0, 0, 0);
+    GDateTime *when;
+    GBytes *days = g_bytes_new (bits, sizeof (bits));
+    LpfTrip *trip;
+
+    trip = g_object_new (LPF_TYPE_TRIP, NULL);
+    g_assert_false (lpf_trip_runs_on (trip, start));
+    g_object_set (trip,
+                  "service-start", start,
+                  "service-days", days,
+                  NULL);
+
+    g_assert_true (lpf_trip_runs_on (trip, start));
+    when = g_date_time_new_utc (2014, 2, 28, 23, 59, 0);
+    g_assert_false (lpf_trip_runs_on (trip, when));
+    g_date_time_unref (when);
+    when = g_date_time_new_utc (2014, 3, 1, 12, 0, 0);
+    g_assert_true (lpf_trip_runs_on (trip, when));
+    g_date_time_unref (when);
+    when = g_date_time_new_utc (2014, 3, 8, 0, 0, 0);
+    g_assert_true (lpf_trip_runs_on (trip, when));
+    g_date_time_unref (when);
+    /* before and after the bitmap */
+    when = g_date_time_new_utc (2014, 2, 26, 0, 0, 0);
+    g_assert_false (lpf_trip_runs_on (trip, when));
+    g_date_time_unref (when);
+    when = g_date_time_new_utc (2014, 3, 15, 0, 0, 0);
+    g_assert_false (lpf_trip_runs_on (trip, when));
+    g_date_time_unref (when);
+
+    g_object_unref (trip);
+    g_bytes_unref (days);
+    g_date_time_unref (start);
+}
+
+
 int main(int argc, char **argv)
 {
     gboolean ret;
@@ -107,6 +312,12 @@ int main(int argc, char **argv)
 
     g_test_add ("/libplanfahr/lpf-trip", TestFixture, NULL,
                 fixture_setup, test_lpf_trip, fixture_teardown);
+    g_test_add ("/libplanfahr/lpf-trip/list", TestFixture, NULL,
+                fixture_setup, test_lpf_trip_list, fixture_teardown);
+    g_test_add_func ("/libplanfahr/lpf-trip/list_slist", test_lpf_trip_list_slist);
+    g_test_add_func ("/libplanfahr/lpf-trip/new_take", test_lpf_trip_new_take);
+    g_test_add_func ("/libplanfahr/lpf-trip/stop_times", test_lpf_trip_stop_times);
+    g_test_add_func ("/libplanfahr/lpf-trip/runs_on", test_lpf_trip_runs_on);
 
     ret = g_test_run ();
     return ret;